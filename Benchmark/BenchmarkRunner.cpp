@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include "BenchmarkRunner.hpp"
+
+namespace swcu {
+
+void BenchmarkRunner::add(const std::string& name, Operation operation,
+    Fixture setUp, Fixture tearDown)
+{
+    mBenchmarks.push_back({ name, std::move(operation), std::move(setUp),
+        std::move(tearDown) });
+}
+
+size_t BenchmarkRunner::run(const std::string& filter)
+{
+    size_t ran = 0;
+    for(auto& benchmark : mBenchmarks)
+    {
+        if(benchmark.name.find(filter) == std::string::npos) continue;
+        if(benchmark.setUp) benchmark.setUp();
+        size_t batch = _calibrate(benchmark.operation);
+        std::vector<double> samples;
+        samples.reserve(SAMPLES);
+        uint64_t total = 0;
+        for(size_t i = 0; i < SAMPLES; ++i)
+        {
+            uint64_t nanos = _time(benchmark.operation, batch);
+            total += nanos;
+            samples.push_back(static_cast<double>(nanos) / batch);
+        }
+        if(benchmark.tearDown) benchmark.tearDown();
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double q) {
+            return samples[std::min(samples.size() - 1,
+                static_cast<size_t>(q * samples.size()))];
+        };
+        mResults.push_back({ benchmark.name,
+            static_cast<uint64_t>(batch) * SAMPLES,
+            static_cast<double>(total) / (batch * SAMPLES),
+            at(0.5), at(0.9), at(0.99) });
+        ++ran;
+    }
+    return ran;
+}
+
+std::string BenchmarkRunner::getReport() const
+{
+    std::ostringstream report;
+    report << "# name iterations mean_ns p50_ns p90_ns p99_ns\n";
+    report << std::fixed << std::setprecision(1);
+    for(auto& result : mResults)
+    {
+        report << result.name << ' ' <<
+            result.iterations << ' ' <<
+            result.mean << ' ' <<
+            result.p50 << ' ' <<
+            result.p90 << ' ' <<
+            result.p99 << '\n';
+    }
+    return report.str();
+}
+
+uint64_t BenchmarkRunner::_time(const Operation& operation,
+    size_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    operation(iterations);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+size_t BenchmarkRunner::_calibrate(const Operation& operation)
+{
+    // Also warms caches and lazily built state up.
+    size_t batch = 1;
+    for(;;)
+    {
+        uint64_t nanos = _time(operation, batch);
+        if(nanos >= SAMPLE_NANOS || batch >= (size_t(1) << 24)) break;
+        // Aim a little past the target rather than doubling blindly.
+        size_t next = nanos == 0 ? batch * 16 :
+            static_cast<size_t>(batch * 1.2 * SAMPLE_NANOS / nanos);
+        batch = std::max(batch * 2, std::min(next, batch * 16));
+    }
+    return batch;
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace swcu {
+
+/**
+ * Runs microbenchmarks and reports how long one operation takes. Each
+ * benchmark is called with a batch size and must perform that many
+ * operations; the batch size is grown until a batch takes about
+ * SAMPLE_NANOS, then SAMPLES batches are timed.
+ */
+class BenchmarkRunner
+{
+public:
+    /**
+     * Perform the given number of operations.
+     */
+    typedef std::function<void(size_t iterations)> Operation;
+    /**
+     * Prepare before, or clean up after, a benchmark. Not timed.
+     */
+    typedef std::function<void()>                  Fixture;
+
+    static const size_t     SAMPLES         = 50;
+    static const uint64_t   SAMPLE_NANOS    = 2000000;
+
+    struct Result
+    {
+        std::string     name;
+        uint64_t        iterations;
+        double          mean;
+        double          p50;
+        double          p90;
+        double          p99;
+    };
+
+protected:
+    struct Benchmark
+    {
+        std::string     name;
+        Operation       operation;
+        Fixture         setUp;
+        Fixture         tearDown;
+    };
+
+    std::vector<Benchmark>  mBenchmarks;
+    std::vector<Result>     mResults;
+
+public:
+            void    add(const std::string& name, Operation operation,
+                Fixture setUp = Fixture(), Fixture tearDown = Fixture());
+
+    /**
+     * Run the benchmarks whose names contain filter, all if empty.
+     * @return Number of benchmarks run.
+     */
+            size_t  run(const std::string& filter = "");
+
+            const std::vector<Result>& getResults() const
+            { return mResults; }
+    /**
+     * One line per benchmark, times in nanoseconds per operation:
+     * name iterations mean_ns p50_ns p90_ns p99_ns
+     */
+            std::string getReport() const;
+
+protected:
+    static  uint64_t _time(const Operation& operation, size_t iterations);
+    static  size_t  _calibrate(const Operation& operation);
+};
+
+}
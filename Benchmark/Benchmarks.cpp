@@ -0,0 +1,698 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sampgdk/a_players.h>
+#include <sampgdk/a_samp.h>
+
+#include "../Common/Common.hpp"
+#include "../Common/Format.hpp"
+#include "../Common/SpatialGrid.hpp"
+#include "../Event/Event.hpp"
+#include "../Interface/CommandManager.hpp"
+#include "../Interface/Dialog.hpp"
+#include "../Interface/DialogManager.hpp"
+#include "../Map/MapManager.hpp"
+#include "../Player/PlayerManager.hpp"
+#include "../Weapon/WeaponShopDialog.hpp"
+#include "../Web/WebServiceManager.hpp"
+
+#include "BenchmarkRunner.hpp"
+#include "StubServer.hpp"
+
+#include "Benchmarks.hpp"
+
+// Defined in Server.cpp.
+void SAMPGDK_CALL OnServerTick(int timerid, void* param);
+
+// The stream-built strings FORMAT replaced, kept as the baseline of the
+// format benchmarks. Newer libraries return the temporary stream itself
+// from <<, so it's passed as an ostream& like the old ones did to keep
+// the dynamic_cast.
+inline std::ostream& asOstream(std::ostream&& os) { return os; }
+#define STR(x) ((dynamic_cast<std::ostringstream&>( \
+    asOstream(std::ostringstream()) << x)).str())
+#define CSTR(x) ((dynamic_cast<std::ostringstream&>( \
+    asOstream(std::ostringstream()) << x)).str().c_str())
+
+namespace swcu {
+
+namespace {
+
+// Maps kept in the database for the loading and web benchmarks.
+const int           BENCHMARK_MAPS          = 10;
+const size_t        MAP_OBJECTS             = 500;
+const size_t        MAP_VEHICLES            = 10;
+const size_t        IMPORT_OBJECTS          = 200;
+const size_t        LIST_ITEMS              = 1000;
+const size_t        EVENT_LISTENERS         = 64;
+// Every player and a few managers listening, on a full server.
+const size_t        EVENT_LISTENERS_FULL    = 500;
+// Deferred events queued between two flushes, about what a busy tick has.
+const size_t        EVENTS_PER_FLUSH        = 64;
+// Players of the grid benchmarks, scattered over a square of a busy
+// town's size.
+const int           GRID_PLAYERS            = 500;
+const float         GRID_AREA               = 600.0f;
+const size_t        GRID_NEAREST            = 10;
+const float         GRID_NEAREST_RADIUS     = 200.0f;
+// A player name and a line of chat in GBK, as clients send them.
+const char          GBK_NAME[]              =
+    "\xCD\xE6\xBC\xD2_\xD0\xA1\xC3\xF7";
+const char          GBK_CHAT[]              =
+    "\xB4\xF3\xBC\xD2\xBA\xC3, \xBD\xF1\xCC\xEC\xCD\xED\xC9\xCF"
+    "\xD2\xBB\xC6\xF0\xC8\xA5\xBB\xFA\xB3\xA1\xC5\xDC\xB3\xB5"
+    "\xB0\xC9! meet at LS airport, 8pm";
+
+/**
+ * Pawn code of a map, objects laid out on a grid.
+ */
+std::string makeMapSource(size_t objects, size_t vehicles)
+{
+    std::string source;
+    for(size_t i = 0; i < objects; ++i)
+    {
+        source.append(FORMAT(
+            "CreateDynamicObject(1337, {}.5, {}.25, 10.0, 0.0, 0.0, {}.0);\n",
+            i % 50 * 3, i / 50 * 3, i % 360).str());
+    }
+    for(size_t i = 0; i < vehicles; ++i)
+    {
+        source.append(FORMAT(
+            "AddStaticVehicle(411, {}.0, -20.0, 10.0, 90.0, 1, 1);\n",
+            i * 5).str());
+    }
+    return source;
+}
+
+std::string getMapName(int i)
+{
+    return FORMAT("bench_map_{}", i).str();
+}
+
+/**
+ * Store and load the benchmark maps once.
+ */
+void ensureMaps()
+{
+    static bool created = false;
+    if(created) return;
+    created = true;
+    std::string source = makeMapSource(MAP_OBJECTS, MAP_VEHICLES);
+    mongo::OID owner = mongo::OID::gen();
+    for(int i = 0; i < BENCHMARK_MAPS; ++i)
+    {
+        MapManager::get().parse(LANDSCAPE, getMapName(i), 0, owner, source);
+    }
+}
+
+typedef size_t (*Conversion)(const char *src, size_t len, char *out,
+    size_t outlen);
+
+/**
+ * Convert the text again and again into a buffer that fits any result.
+ */
+BenchmarkRunner::Operation convertText(const std::string& text,
+    Conversion conversion)
+{
+    return [text, conversion](size_t n) {
+        char out[256];
+        for(size_t i = 0; i < n; ++i)
+        {
+            if(conversion(text.data(), text.size(), out, sizeof(out)) ==
+                CONVERT_FAILED)
+            {
+                LOG(ERROR) << "Benchmark text not converted.";
+                return;
+            }
+        }
+    };
+}
+
+/**
+ * Plain iconv, the baseline of the tables GBKToUTF8 and UTF8ToGBK use.
+ */
+size_t iconvGBKToUTF8(const char *src, size_t len, char *out, size_t outlen)
+{
+    return convert("GBK", "UTF-8", src, len, out, outlen);
+}
+
+size_t iconvUTF8ToGBK(const char *src, size_t len, char *out, size_t outlen)
+{
+    return convert("UTF-8", "GBK", src, len, out, outlen);
+}
+
+int getShownDialog(int playerid)
+{
+    return StubServer::get().getPlayer(playerid).dialogId;
+}
+
+/**
+ * List dialog over items kept in memory, telling the benchmark which
+ * rows turn the page.
+ */
+class BenchmarkListDialog : public PagedListDialog<size_t>
+{
+public:
+    struct View
+    {
+        bool            hasPrev;
+        bool            hasNext;
+        size_t          items;
+    };
+
+protected:
+    const std::vector<std::string>* mTitles;
+    View*               mView;
+
+public:
+                        BenchmarkListDialog(int playerid,
+                            const std::vector<std::string>* titles,
+                            View* view) :
+                            PagedListDialog<size_t>(playerid, "Benchmark"),
+                            mTitles(titles), mView(view) {}
+    virtual             ~BenchmarkListDialog() {}
+
+    virtual bool        fetchPage(size_t offset, size_t limit) override
+    {
+        for(size_t i = offset; i < mTitles->size() && i < offset + limit;
+            ++i)
+        {
+            addItem(i, (*mTitles)[i]);
+        }
+        return true;
+    }
+    virtual bool        process(size_t /* key */) override
+    {
+        return false;
+    }
+    virtual bool        display() override
+    {
+        bool shown = PagedListDialog<size_t>::display();
+        *mView = { mHasPrev, mHasNext, mItemList.size() };
+        return shown;
+    }
+};
+
+class BenchmarkListener : public EventListener
+{
+public:
+    size_t              mReceived;
+
+                        BenchmarkListener() :
+                            EventListener({ onPlayerSpawn }),
+                            mReceived(0) {}
+    virtual             ~BenchmarkListener() {}
+
+    virtual void        handleEvent(const Event& /* evt */) override
+    {
+        ++mReceived;
+    }
+};
+
+void registerMapBenchmarks(BenchmarkRunner& runner)
+{
+    auto importSource = std::make_shared<std::string>(
+        makeMapSource(IMPORT_OBJECTS, 0));
+    // Parse the code and store the objects, then throw the map away.
+    runner.add("map_import", [importSource](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            auto map = MapManager::get().parse(LANDSCAPE, "bench_import", 0,
+                mongo::OID::gen(), *importSource);
+            map->deleteFromDatabase();
+            MapManager::get().unloadMap("bench_import");
+        }
+    });
+    // One map of MAP_OBJECTS objects from the database.
+    runner.add("map_load", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            MapManager::get().unloadMap(getMapName(0));
+            MapManager::get().loadMap(getMapName(0));
+        }
+    }, &ensureMaps);
+    runner.add("map_load_all", [](size_t n) {
+        for(size_t i = 0; i < n; ++i) MapManager::get().loadAllMaps();
+    }, &ensureMaps);
+}
+
+void registerCommandBenchmarks(BenchmarkRunner& runner)
+{
+    // Sends six client messages.
+    runner.add("command_help", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            OnPlayerCommandText(static_cast<int>(i % BENCHMARK_PLAYERS),
+                "/help");
+        }
+    });
+    // Parses an int argument.
+    runner.add("command_skin", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            OnPlayerCommandText(static_cast<int>(i % BENCHMARK_PLAYERS),
+                "/skin 42");
+        }
+    });
+    runner.add("command_unknown", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            OnPlayerCommandText(static_cast<int>(i % BENCHMARK_PLAYERS),
+                "/nosuchcommand 1 2 3");
+        }
+    });
+
+    // The arguments alone, read in place and from the stringstream the
+    // handlers were given before, which is kept as the baseline.
+    runner.add("args_skin", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            CommandArgs args("skin 120");
+            StringRef name;
+            int skin;
+            args.next(name);
+            args.read(skin);
+        }
+    });
+    runner.add("sstream_args_skin", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            std::stringstream args("skin 120");
+            std::string name;
+            int skin;
+            args >> name >> skin;
+        }
+    });
+    runner.add("args_teleport", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            CommandArgs args("t 1234.5 -200.25 13.0");
+            StringRef name;
+            float x, y, z;
+            args.next(name);
+            args.read(x);
+            args.read(y);
+            args.read(z);
+        }
+    });
+    runner.add("sstream_args_teleport", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            std::stringstream args("t 1234.5 -200.25 13.0");
+            std::string name;
+            float x, y, z;
+            args >> name >> x >> y >> z;
+        }
+    });
+    runner.add("args_color", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            CommandArgs args("c color 3 126");
+            StringRef name, subcommand;
+            int color1, color2;
+            args.next(name);
+            args.next(subcommand);
+            args.read(color1);
+            args.read(color2);
+        }
+    });
+    runner.add("sstream_args_color", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            std::stringstream args("c color 3 126");
+            std::string name, subcommand;
+            int color1, color2;
+            args >> name >> subcommand >> color1 >> color2;
+        }
+    });
+}
+
+void registerDialogBenchmarks(BenchmarkRunner& runner)
+{
+    // Build and show a menu, then close it.
+    runner.add("dialog_push", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int playerid = static_cast<int>(i % BENCHMARK_PLAYERS);
+            DialogManager::get().push<WeaponShopDialog>(playerid);
+            DialogManager::get().clearPlayerStack(playerid);
+        }
+    });
+
+    // Turn the pages of a long list through OnDialogResponse, to the end
+    // and back.
+    auto titles = std::make_shared<std::vector<std::string>>();
+    for(size_t i = 0; i < LIST_ITEMS; ++i)
+    {
+        titles->push_back(FORMAT("Item {} of the benchmark list", i).str());
+    }
+    auto view = std::make_shared<BenchmarkListDialog::View>();
+    auto forward = std::make_shared<bool>(true);
+    runner.add("dialog_page", [view, forward](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            if(*forward && !view->hasNext) *forward = false;
+            if(!*forward && !view->hasPrev) *forward = true;
+            // The previous page row comes first, the next page row last.
+            int listitem = *forward ?
+                static_cast<int>(view->items) + (view->hasPrev ? 1 : 0) : 0;
+            OnDialogResponse(0, getShownDialog(0), 1, listitem, "");
+        }
+    }, [titles, view, forward]() {
+        *forward = true;
+        DialogManager::get().clearPlayerStack(0);
+        DialogManager::get().push<BenchmarkListDialog>(0, titles.get(),
+            view.get());
+    }, []() {
+        DialogManager::get().clearPlayerStack(0);
+    });
+}
+
+void registerEncodingBenchmarks(BenchmarkRunner& runner)
+{
+    Conversion gbkToUTF8 = &GBKToUTF8;
+    Conversion utf8ToGBK = &UTF8ToGBK;
+    std::string name = GBK_NAME;
+    std::string chat = GBK_CHAT;
+    std::string utf8Name = GBKToUTF8(name);
+    std::string utf8Chat = GBKToUTF8(chat);
+
+    runner.add("gbk_to_utf8_name", convertText(name, gbkToUTF8));
+    runner.add("gbk_to_utf8_chat", convertText(chat, gbkToUTF8));
+    runner.add("utf8_to_gbk_name", convertText(utf8Name, utf8ToGBK));
+    runner.add("utf8_to_gbk_chat", convertText(utf8Chat, utf8ToGBK));
+    runner.add("iconv_gbk_to_utf8_name", convertText(name, &iconvGBKToUTF8));
+    runner.add("iconv_gbk_to_utf8_chat", convertText(chat, &iconvGBKToUTF8));
+    runner.add("iconv_utf8_to_gbk_name",
+        convertText(utf8Name, &iconvUTF8ToGBK));
+    runner.add("iconv_utf8_to_gbk_chat",
+        convertText(utf8Chat, &iconvUTF8ToGBK));
+}
+
+void registerEventBenchmarks(BenchmarkRunner& runner)
+{
+    auto listeners =
+        std::make_shared<std::vector<std::unique_ptr<BenchmarkListener>>>();
+    auto subscribeMany = [listeners](size_t count) {
+        return [listeners, count]() {
+            for(size_t i = 0; i < count; ++i)
+            {
+                listeners->emplace_back(new BenchmarkListener());
+            }
+        };
+    };
+    auto subscribe = subscribeMany(EVENT_LISTENERS);
+    auto unsubscribe = [listeners]() {
+        listeners->clear();
+        EventManager::get().setDelivery(onPlayerSpawn, IMMEDIATE);
+    };
+
+    // One event to EVENT_LISTENERS listeners and whoever else listens.
+    auto fanout = [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            EventManager::get().sendEvent(onPlayerSpawn,
+                PlayerManager::get().getPlayer(
+                    static_cast<int>(i % BENCHMARK_PLAYERS)));
+        }
+    };
+    runner.add("event_fanout", fanout, subscribe, unsubscribe);
+    runner.add("event_fanout_500", fanout,
+        subscribeMany(EVENT_LISTENERS_FULL), unsubscribe);
+
+    // Queue the same events, delivered by a flush every EVENTS_PER_FLUSH.
+    runner.add("event_deferred", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            EventManager::get().sendEvent(onPlayerSpawn,
+                PlayerManager::get().getPlayer(
+                    static_cast<int>(i % BENCHMARK_PLAYERS)));
+            if((i + 1) % EVENTS_PER_FLUSH == 0)
+            {
+                EventManager::get().flushEvents();
+            }
+        }
+        EventManager::get().flushEvents();
+    }, [subscribe]() {
+        subscribe();
+        EventManager::get().setDelivery(onPlayerSpawn, DEFERRED);
+    }, unsubscribe);
+}
+
+void registerFormatBenchmarks(BenchmarkRunner& runner)
+{
+    // A player joining, told to everyone.
+    runner.add("format_join", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int playerid = static_cast<int>(i % BENCHMARK_PLAYERS);
+            Player* p = PlayerManager::get().getPlayer(playerid);
+            SendClientMessageToAll(0xFFFFFFFF, FORMAT(
+                "{}({}) joined the server.",
+                p->getColoredNickname(), playerid).c_str());
+        }
+    });
+    runner.add("stream_join", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int playerid = static_cast<int>(i % BENCHMARK_PLAYERS);
+            Player* p = PlayerManager::get().getPlayer(playerid);
+            SendClientMessageToAll(0xFFFFFFFF, CSTR(
+                p->getColoredNickname() << "(" << playerid <<
+                ") joined the server."));
+        }
+    });
+    // A single number, like the level and rank notices.
+    runner.add("format_level", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            SendClientMessage(static_cast<int>(i % BENCHMARK_PLAYERS),
+                0xFFFFFFFF, FORMAT("Your wanted level is now {}",
+                i % 7).c_str());
+        }
+    });
+    runner.add("stream_level", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            SendClientMessage(static_cast<int>(i % BENCHMARK_PLAYERS),
+                0xFFFFFFFF, CSTR("Your wanted level is now " << i % 7));
+        }
+    });
+    // A private message, shown to both ends.
+    runner.add("format_private", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int from = static_cast<int>(i % BENCHMARK_PLAYERS);
+            int to = static_cast<int>((i + 1) % BENCHMARK_PLAYERS);
+            Player* p = PlayerManager::get().getPlayer(from);
+            Player* target = PlayerManager::get().getPlayer(to);
+            SendClientMessage(from, 0xFFFFFFFF, FORMAT(
+                "PM to {}{FFFFFF}({}): {}",
+                target->getColoredNickname(), to, GBK_CHAT).c_str());
+            SendClientMessage(to, 0xFFFFFFFF, FORMAT(
+                "PM from {}{FFFFFF}({}): {}",
+                p->getColoredNickname(), from, GBK_CHAT).c_str());
+        }
+    });
+    runner.add("stream_private", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int from = static_cast<int>(i % BENCHMARK_PLAYERS);
+            int to = static_cast<int>((i + 1) % BENCHMARK_PLAYERS);
+            Player* p = PlayerManager::get().getPlayer(from);
+            Player* target = PlayerManager::get().getPlayer(to);
+            SendClientMessage(from, 0xFFFFFFFF, CSTR(
+                "PM to " << target->getColoredNickname() <<
+                "{FFFFFF}(" << to << "): " << GBK_CHAT));
+            SendClientMessage(to, 0xFFFFFFFF, CSTR(
+                "PM from " << p->getColoredNickname() <<
+                "{FFFFFF}(" << from << "): " << GBK_CHAT));
+        }
+    });
+    // The string itself, as STR gave it.
+    runner.add("format_str", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            std::string text = FORMAT("bench_map_{}", i).str();
+            (void)text;
+        }
+    });
+    runner.add("stream_str", [](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            std::string text = STR("bench_map_" << i);
+            (void)text;
+        }
+    });
+}
+
+void registerGridBenchmarks(BenchmarkRunner& runner)
+{
+    // The same places on every run.
+    auto positions = std::make_shared<std::vector<kanko::Vector3>>();
+    std::mt19937 random(1);
+    for(int i = 0; i < GRID_PLAYERS; ++i)
+    {
+        float x = random() % 10000 / 10000.0f * GRID_AREA;
+        float y = random() % 10000 / 10000.0f * GRID_AREA;
+        positions->push_back(kanko::Vector3(x, y, 10.0f));
+    }
+    auto grid = std::make_shared<SpatialGrid>(Config::playerGridCellSize,
+        Config::playerGridMoveThreshold);
+    for(int i = 0; i < GRID_PLAYERS; ++i)
+    {
+        grid->update(i, (*positions)[i], 0, 0);
+    }
+
+    // Who hears a line of local chat.
+    runner.add("grid_query_radius", [grid, positions](size_t n) {
+        std::vector<int> out;
+        for(size_t i = 0; i < n; ++i)
+        {
+            out.clear();
+            grid->queryRadius((*positions)[i % GRID_PLAYERS],
+                Config::chatLocalRadius, 0, 0, out);
+        }
+    });
+    runner.add("grid_query_nearest", [grid, positions](size_t n) {
+        std::vector<int> out;
+        for(size_t i = 0; i < n; ++i)
+        {
+            out.clear();
+            grid->queryNearest((*positions)[i % GRID_PLAYERS], GRID_NEAREST,
+                GRID_NEAREST_RADIUS, 0, 0, out);
+        }
+    });
+    // Each player steps 2 m back and forth, past the move threshold.
+    auto step = std::make_shared<float>(2.0f);
+    runner.add("grid_update", [grid, positions, step](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int id = static_cast<int>(i % GRID_PLAYERS);
+            if(id == 0) *step = -*step;
+            kanko::Vector3& pos = (*positions)[id];
+            pos.x += *step;
+            grid->update(id, pos, 0, 0);
+        }
+    });
+}
+
+void registerLabelBenchmarks(BenchmarkRunner& runner)
+{
+    // Change one field of every label and redraw them, as a tick where
+    // everyone's wanted level changed would.
+    auto level = std::make_shared<int>(0);
+    runner.add("label_update_all", [level](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            *level = (*level + 1) % 7;
+            PlayerManager::get().forEachPlayer([level](Player& player) {
+                player.getLabel().setWantedLevel(*level);
+            });
+            PlayerManager::get().updateLabels();
+        }
+    });
+    // Nothing changed, what every other tick costs.
+    runner.add("label_update_clean", [](size_t n) {
+        for(size_t i = 0; i < n; ++i) PlayerManager::get().updateLabels();
+    });
+}
+
+void registerWebBenchmarks(BenchmarkRunner& runner)
+{
+    auto get = [](const std::string& path) {
+        return [path](size_t n) {
+            std::string response;
+            for(size_t i = 0; i < n; ++i)
+            {
+                WebServiceManager::get().respond("GET", path, response);
+            }
+        };
+    };
+    runner.add("web_hello", get("/hello"));
+    runner.add("web_map_list", get("/maps/"), &ensureMaps);
+    runner.add("web_map_name", get("/maps/name/" + getMapName(0)),
+        &ensureMaps);
+    // Falls through every route to the static files.
+    runner.add("web_static_miss", get("/nosuchfile.html"));
+}
+
+void registerTickBenchmarks(BenchmarkRunner& runner)
+{
+    runner.add("server_tick", [](size_t n) {
+        for(size_t i = 0; i < n; ++i) OnServerTick(-1, nullptr);
+    });
+    // Sent by every client many times a second. The players step 2 m
+    // back and forth between rounds, past the move threshold, so each
+    // update moves them on the grid as walking players would.
+    auto step = std::make_shared<float>(2.0f);
+    runner.add("on_player_update", [step](size_t n) {
+        for(size_t i = 0; i < n; ++i)
+        {
+            int playerid = static_cast<int>(i % BENCHMARK_PLAYERS);
+            if(playerid == 0) *step = -*step;
+            StubServer::get().getPlayer(playerid).x += *step;
+            OnPlayerUpdate(playerid);
+        }
+    });
+}
+
+}
+
+void connectBenchmarkPlayers(int count)
+{
+    // 20 by 20 metres apart on a square.
+    int side = 1;
+    while(side * side < count) ++side;
+    for(int i = 0; i < count; ++i)
+    {
+        StubServer::get().connect(i, FORMAT("Bench_{}", i).str());
+        OnPlayerConnect(i);
+        // Skip the register dialog and the help shown on joining.
+        DialogManager::get().clearPlayerStack(i);
+        Player* player = PlayerManager::get().getPlayer(i);
+        if(player == nullptr)
+        {
+            LOG(ERROR) << "Benchmark player " << i << " not added.";
+            continue;
+        }
+        if(!player->isValid()) player->createProfile("benchmark");
+        player->setLoggedIn(true);
+        SetPlayerPos(i, (i % side) * 20.0f, (i / side) * 20.0f, 10.0f);
+        OnPlayerUpdate(i);
+    }
+}
+
+void registerBenchmarks(BenchmarkRunner& runner)
+{
+    registerMapBenchmarks(runner);
+    registerCommandBenchmarks(runner);
+    registerDialogBenchmarks(runner);
+    registerEncodingBenchmarks(runner);
+    registerEventBenchmarks(runner);
+    registerFormatBenchmarks(runner);
+    registerGridBenchmarks(runner);
+    registerLabelBenchmarks(runner);
+    registerWebBenchmarks(runner);
+    registerTickBenchmarks(runner);
+}
+
+}
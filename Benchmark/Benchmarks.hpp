@@ -0,0 +1,42 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace swcu {
+
+class BenchmarkRunner;
+
+/**
+ * Players connected by connectBenchmarkPlayers(), from id 0.
+ */
+const int BENCHMARK_PLAYERS = 200;
+
+/**
+ * Connect players through OnPlayerConnect, register their profiles and
+ * log them in, spread over a square so the spatial grid has work to do.
+ * The game mode must be initialized.
+ */
+void connectBenchmarkPlayers(int count);
+
+/**
+ * Add the suite: map loading, command dispatch, dialog rendering, event
+ * fan-out, label updates, web routing and the server tick. Benchmarks
+ * create what they need in their set up, so any of them may be run alone.
+ */
+void registerBenchmarks(BenchmarkRunner& runner);
+
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "../Common/Common.hpp"
+#include "../Common/Scheduler.hpp"
+#include "../Interface/CommandManager.hpp"
+
+#include "Checks.hpp"
+
+namespace swcu {
+
+namespace {
+
+size_t gFailed = 0;
+
+// Not CHECK, which easylogging++ defines.
+#define EXPECT(x) \
+    do \
+    { \
+        if(!(x)) \
+        { \
+            ++gFailed; \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #x << \
+                std::endl; \
+        } \
+    } while(false)
+
+// Ticks a timer can be away from without being parked.
+const uint64_t WHEEL_RANGE = uint64_t(1) << (TimerWheel::SLOT_BITS *
+    TimerWheel::LEVELS);
+
+std::chrono::steady_clock::time_point never()
+{
+    return std::chrono::steady_clock::time_point::max();
+}
+
+std::chrono::steady_clock::time_point past()
+{
+    return std::chrono::steady_clock::time_point::min();
+}
+
+/**
+ * Advance a tick at a time, running all that's ready, until the tick.
+ */
+void runTo(TimerWheel& wheel, uint64_t tick)
+{
+    while(wheel.getCurrentTick() < tick)
+    {
+        wheel.advance();
+        wheel.runReady(never());
+    }
+}
+
+/**
+ * Schedule a one-off timer after the delay, from a wheel already at the
+ * start tick, and check that it runs exactly once and on time. A delay
+ * of 0 still waits for the next tick.
+ */
+void checkDelay(uint64_t start, uint64_t delay)
+{
+    uint64_t due = start + (delay > 0 ? delay : 1);
+    TimerWheel wheel;
+    runTo(wheel, start);
+    std::vector<uint64_t> runs;
+    wheel.schedule(delay, 0, [&]() {
+        runs.push_back(wheel.getCurrentTick());
+        return false;
+    });
+    runTo(wheel, start + delay + 2);
+    EXPECT(runs.size() == 1);
+    EXPECT(runs.size() == 1 && runs[0] == due);
+    EXPECT(wheel.getTimerCount() == 0);
+}
+
+void checkLevelBoundaries()
+{
+    // Starts off a boundary, so the slots of a level wrap around.
+    for(uint64_t start : { 0, 37, 4090 })
+    {
+        for(size_t level = 1; level < TimerWheel::LEVELS; ++level)
+        {
+            uint64_t boundary = uint64_t(1) << (TimerWheel::SLOT_BITS *
+                level);
+            checkDelay(start, boundary - 1);
+            checkDelay(start, boundary);
+            checkDelay(start, boundary + 1);
+        }
+        checkDelay(start, 1);
+        checkDelay(start, WHEEL_RANGE - 1);
+    }
+    checkDelay(0, 0);
+}
+
+void checkParking()
+{
+    checkDelay(0, WHEEL_RANGE);
+    checkDelay(5, WHEEL_RANGE + 1000);
+    checkDelay(0, 2 * WHEEL_RANGE + 3);
+}
+
+void checkRepeating()
+{
+    TimerWheel wheel;
+    std::vector<uint64_t> runs;
+    // Longer than a level 0 turn, so each run is placed through level 1.
+    wheel.schedule(5, 100, [&]() {
+        runs.push_back(wheel.getCurrentTick());
+        return runs.size() < 4;
+    });
+    runTo(wheel, 1000);
+    EXPECT(runs == std::vector<uint64_t>({ 5, 105, 205, 305 }));
+    EXPECT(wheel.getTimerCount() == 0);
+
+    // An interval of 0 runs once, whatever the task returns.
+    size_t count = 0;
+    wheel.schedule(3, 0, [&]() { ++count; return true; });
+    runTo(wheel, 1100);
+    EXPECT(count == 1);
+}
+
+void checkCancel()
+{
+    TimerWheel wheel;
+    bool ran = false;
+    auto task = [&]() { ran = true; return false; };
+    TimerHandle near    = wheel.schedule(10, 0, task);
+    TimerHandle far     = wheel.schedule(1000, 0, task);
+    TimerHandle parked  = wheel.schedule(WHEEL_RANGE + 10, 0, task);
+    EXPECT(wheel.getTimerCount() == 3);
+    EXPECT(wheel.cancel(near));
+    EXPECT(wheel.cancel(far));
+    EXPECT(wheel.cancel(parked));
+    EXPECT(!wheel.isPending(near));
+    EXPECT(!wheel.cancel(near));
+    EXPECT(wheel.getTimerCount() == 0);
+    runTo(wheel, WHEEL_RANGE + 20);
+    EXPECT(!ran);
+
+    // A repeating timer cancelling itself.
+    TimerHandle self;
+    size_t count = 0;
+    self = wheel.schedule(1, 1, [&]() {
+        if(++count == 3) wheel.cancel(self);
+        return true;
+    });
+    runTo(wheel, wheel.getCurrentTick() + 10);
+    EXPECT(count == 3);
+    EXPECT(!wheel.isPending(self));
+}
+
+void checkStaleHandles()
+{
+    TimerWheel wheel;
+    TimerHandle done = wheel.schedule(1, 0, []() { return false; });
+    EXPECT(wheel.isPending(done));
+    runTo(wheel, 2);
+    EXPECT(!wheel.isPending(done));
+    EXPECT(!wheel.cancel(done));
+
+    // Takes the place freed by the first one.
+    bool ran = false;
+    TimerHandle reused = wheel.schedule(5, 0, [&]() {
+        ran = true;
+        return false;
+    });
+    EXPECT(reused.getId() != done.getId());
+    EXPECT(!wheel.cancel(done));
+    EXPECT(wheel.isPending(reused));
+    runTo(wheel, 10);
+    EXPECT(ran);
+
+    // A cancelled timer keeps its place until its slot comes up, and the
+    // timer getting it afterwards isn't reachable by the old handle.
+    TimerHandle cancelled = wheel.schedule(3, 0, []() { return false; });
+    wheel.cancel(cancelled);
+    runTo(wheel, wheel.getCurrentTick() + 5);
+    ran = false;
+    TimerHandle next = wheel.schedule(2, 0, [&]() {
+        ran = true;
+        return false;
+    });
+    EXPECT(!wheel.cancel(cancelled));
+    runTo(wheel, wheel.getCurrentTick() + 5);
+    EXPECT(ran);
+    EXPECT(!wheel.isPending(next));
+}
+
+void checkSpilling()
+{
+    TimerWheel wheel;
+    std::vector<int> order;
+    for(int i = 0; i < 5; ++i)
+    {
+        wheel.schedule(1, 0, [&order, i]() {
+            order.push_back(i);
+            return false;
+        });
+    }
+    wheel.schedule(2, 0, [&order]() {
+        order.push_back(5);
+        return false;
+    });
+    wheel.advance();
+    // At least one runs however late it is.
+    EXPECT(wheel.runReady(past()) == 4);
+    EXPECT(order == std::vector<int>({ 0 }));
+    // The leftovers go before what comes due on the next tick.
+    wheel.advance();
+    EXPECT(wheel.getReadyCount() == 5);
+    EXPECT(wheel.runReady(never()) == 0);
+    EXPECT(order == std::vector<int>({ 0, 1, 2, 3, 4, 5 }));
+
+    // Tasks scheduling more timers while running.
+    size_t count = 0;
+    wheel.schedule(1, 0, [&]() {
+        for(int i = 0; i < 100; ++i)
+        {
+            wheel.schedule(1, 0, [&count]() { ++count; return false; });
+        }
+        return false;
+    });
+    runTo(wheel, wheel.getCurrentTick() + 3);
+    EXPECT(count == 100);
+    EXPECT(wheel.getTimerCount() == 0);
+}
+
+void checkSchedulerSpillCount()
+{
+    Counter& spilled = Metrics::get().counter(
+        "swcu_scheduler_spilled_total", "", "");
+    uint64_t before = spilled.value();
+    int budget = Config::schedulerTickBudget;
+    // Only one timer runs each tick.
+    Config::schedulerTickBudget = 0;
+    size_t count = 0;
+    for(int i = 0; i < 5; ++i)
+    {
+        Scheduler::get().after(0, [&count]() { ++count; });
+    }
+    for(int i = 0; i < 6; ++i) Scheduler::get().tick();
+    Config::schedulerTickBudget = budget;
+    EXPECT(count == 5);
+    // Four were put off once, however many ticks they waited.
+    EXPECT(spilled.value() - before == 4);
+}
+
+size_t gCommandRuns = 0;
+CommandResult gCommandResult = COMMAND_HANDLED;
+
+CommandResult checkedCommand(int /* playerid */, int /* value */)
+{
+    ++gCommandRuns;
+    return gCommandResult;
+}
+
+void checkCommandCharging()
+{
+    CommandOptions options;
+    options.cooldown = 60000;
+    CommandManager::get().registerCommand("swcu_check_cooldown",
+        &checkedCommand, "", options);
+    const int playerid = 0;
+    CommandManager::get().resetPlayer(playerid);
+    gCommandRuns = 0;
+
+    // Failing and wrong arguments don't start the cooldown.
+    gCommandResult = COMMAND_HANDLED_NO_CHARGE;
+    EXPECT(CommandManager::get().handleCallback(playerid,
+        "/swcu_check_cooldown 1"));
+    EXPECT(CommandManager::get().handleCallback(playerid,
+        "/swcu_check_cooldown x"));
+    EXPECT(gCommandRuns == 1);
+    gCommandResult = COMMAND_HANDLED;
+    EXPECT(CommandManager::get().handleCallback(playerid,
+        "/swcu_check_cooldown 1"));
+    EXPECT(gCommandRuns == 2);
+    // That one did, so the next is refused without running.
+    EXPECT(CommandManager::get().handleCallback(playerid,
+        "/swcu_check_cooldown 1"));
+    EXPECT(gCommandRuns == 2);
+
+    CommandManager::get().resetPlayer(playerid);
+    gCommandResult = COMMAND_UNKNOWN;
+    EXPECT(!CommandManager::get().handleCallback(playerid,
+        "/swcu_check_cooldown 1"));
+    EXPECT(gCommandRuns == 3);
+    CommandManager::get().resetPlayer(playerid);
+}
+
+#undef EXPECT
+
+}
+
+size_t runChecks()
+{
+    gFailed = 0;
+    checkLevelBoundaries();
+    checkParking();
+    checkRepeating();
+    checkCancel();
+    checkStaleHandles();
+    checkSpilling();
+    checkSchedulerSpillCount();
+    checkCommandCharging();
+    return gFailed;
+}
+
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace swcu {
+
+/**
+ * Check what the benchmarks run through but can't tell wrong from right:
+ * - the timer wheel of the scheduler: timers around each level boundary
+ *   and beyond the wheels, repeating timers, cancellation, stale handles
+ *   and spilling past the tick budget,
+ * - that only commands which did something are charged to the cooldown.
+ * Failures are printed to stderr. Run before the game mode is initialized.
+ * @return Number of failed checks.
+ */
+size_t runChecks();
+
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sampgdk/a_samp.h>
+
+#include "../Common/Common.hpp"
+#include "../SAMP/Journal.hpp"
+
+#include "BenchmarkRunner.hpp"
+#include "Benchmarks.hpp"
+#include "Checks.hpp"
+#include "StubServer.hpp"
+
+namespace {
+
+/**
+ * Let the players still online leave, so that they are saved and freed
+ * while the managers they use are still there.
+ */
+void disconnectAll()
+{
+    for(int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if(!swcu::StubServer::get().getPlayer(i).connected) continue;
+        OnPlayerDisconnect(i, 1);
+        swcu::StubServer::get().disconnect(i);
+    }
+}
+
+/**
+ * Replay a journal against the stub natives.
+ * @return The report, empty if the journal can't be read.
+ */
+std::string replayJournal(const std::string& path)
+{
+    swcu::JournalReplayer replayer(path);
+    if(!replayer.isValid())
+    {
+        std::cerr << "Cannot read journal " << path << std::endl;
+        return "";
+    }
+    // Names aren't journaled, the slot stands in for one.
+    replayer.setConnectionHandler([](int playerid, bool connected) {
+        if(connected)
+        {
+            swcu::StubServer::get().connect(playerid,
+                FORMAT("Replay_{}", playerid).str());
+        }
+        else
+        {
+            swcu::StubServer::get().disconnect(playerid);
+        }
+    });
+    replayer.setPositionHandler([](int playerid, float x, float y, float z) {
+        swcu::StubServer::PlayerState& player =
+            swcu::StubServer::get().getPlayer(playerid);
+        player.x = x;
+        player.y = y;
+        player.z = z;
+    });
+    uint64_t replayed = replayer.run();
+    LOG(INFO) << replayed << " journal record(s) replayed.";
+    disconnectAll();
+    return replayer.getReport();
+}
+
+}
+
+/**
+ * Runs the game mode without a server, against the stub natives and the
+ * in-memory database, and prints how long its hot paths take:
+ *     SWCU2Benchmark [--filter text] [--output file]
+ * Or replays a journal recorded on a server and prints how long each kind
+ * of callback took:
+ *     SWCU2Benchmark --replay journal [--output file]
+ * The report is the same from build to build but for the numbers, so two
+ * of them can be diffed.
+ * With --check, the checks of Checks.hpp are run first and a failure ends
+ * the run with a nonzero status.
+ */
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    std::string output;
+    std::string journal;
+    bool check = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--check")
+        {
+            check = true;
+            continue;
+        }
+        std::string* value = arg == "--filter" ? &filter :
+            arg == "--output" ? &output :
+            arg == "--replay" ? &journal : nullptr;
+        if(value == nullptr || i + 1 == argc)
+        {
+            std::cerr << "Usage: " << argv[0] <<
+                " [--check] [--filter text] [--replay journal]"
+                " [--output file]" <<
+                std::endl;
+            return 1;
+        }
+        *value = argv[++i];
+    }
+
+    // Nothing is listening, recorded or printed but the report.
+    swcu::Config::webServerPort = 0;
+    swcu::Config::journalPath   = "";
+    swcu::Config::logPath       = "logs/benchmark.log";
+    swcu::Config::logToConsole  = false;
+
+    if(check)
+    {
+        size_t failed = swcu::runChecks();
+        if(failed > 0)
+        {
+            std::cerr << failed << " check(s) failed." << std::endl;
+            return 1;
+        }
+    }
+
+    OnGameModeInit();
+    std::string report;
+    if(!journal.empty())
+    {
+        report = replayJournal(journal);
+        OnGameModeExit();
+        if(report.empty()) return 1;
+    }
+    else
+    {
+        swcu::connectBenchmarkPlayers(swcu::BENCHMARK_PLAYERS);
+
+        swcu::BenchmarkRunner runner;
+        swcu::registerBenchmarks(runner);
+        size_t ran = runner.run(filter);
+        LOG(INFO) << ran << " benchmark(s) run.";
+        disconnectAll();
+        OnGameModeExit();
+        if(ran == 0)
+        {
+            std::cerr << "No benchmark matches " << filter << std::endl;
+            return 1;
+        }
+        report = runner.getReport();
+    }
+
+    if(output.empty())
+    {
+        std::cout << report;
+        return 0;
+    }
+    std::ofstream file(output);
+    file << report;
+    if(!file)
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <regex>
+
+#include "../Common/Common.hpp"
+
+#include "MemoryStorage.hpp"
+
+namespace swcu {
+
+namespace {
+
+bool isOperator(const mongo::BSONElement& e)
+{
+    return e.fieldName()[0] == '$';
+}
+
+bool isIndexNamespace(const std::string& ns)
+{
+    static const std::string suffix = ".system.indexes";
+    return ns.size() >= suffix.size() &&
+        ns.compare(ns.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+std::auto_ptr<mongo::DBClientCursor> MemoryDBConnection::query(
+    const std::string& ns, mongo::Query query, int nToReturn, int nToSkip,
+    const mongo::BSONObj* /* fieldsToReturn */, int /* queryOptions */,
+    int /* batchSize */)
+{
+    const Collection& docs = mCollections[ns];
+    mongo::BSONObj filter = query.getFilter();
+    std::vector<mongo::BSONObj> result;
+    for(auto& doc : docs)
+    {
+        if(matches(doc, filter)) result.push_back(doc);
+    }
+    mongo::BSONObj sort = query.getSort();
+    if(!sort.isEmpty())
+    {
+        std::stable_sort(result.begin(), result.end(),
+            [&sort](const mongo::BSONObj& a, const mongo::BSONObj& b) {
+                for(mongo::BSONObjIterator it(sort); it.more();)
+                {
+                    mongo::BSONElement key = it.next();
+                    int cmp = a.getFieldDotted(key.fieldName()).woCompare(
+                        b.getFieldDotted(key.fieldName()), false);
+                    if(cmp != 0) return key.number() < 0 ? cmp > 0 : cmp < 0;
+                }
+                return false;
+            });
+    }
+    // Negative nToReturn asks for a single batch, findOne passes -1.
+    size_t skip = std::min(result.size(), static_cast<size_t>(
+        std::max(nToSkip, 0)));
+    result.erase(result.begin(), result.begin() + skip);
+    size_t limit = static_cast<size_t>(std::abs(nToReturn));
+    if(limit != 0 && result.size() > limit) result.resize(limit);
+    return std::auto_ptr<mongo::DBClientCursor>(
+        new MemoryCursor(this, ns, std::move(result)));
+}
+
+void MemoryDBConnection::insert(const std::string& ns, mongo::BSONObj obj,
+    int /* flags */)
+{
+    // Old servers take indexes as documents here.
+    if(isIndexNamespace(ns)) return;
+    if(obj["_id"].eoo())
+    {
+        mongo::BSONObjBuilder b;
+        b.append("_id", mongo::OID::gen()).appendElements(obj);
+        obj = b.obj();
+    }
+    mCollections[ns].push_back(obj.getOwned());
+}
+
+void MemoryDBConnection::insert(const std::string& ns,
+    const std::vector<mongo::BSONObj>& v, int flags)
+{
+    for(auto& obj : v) insert(ns, obj, flags);
+}
+
+void MemoryDBConnection::update(const std::string& ns, mongo::Query query,
+    mongo::BSONObj obj, bool /* upsert */, bool multi)
+{
+    mongo::BSONObj filter = query.getFilter();
+    for(auto& doc : mCollections[ns])
+    {
+        if(!matches(doc, filter)) continue;
+        doc = _applyUpdate(doc, obj);
+        if(!multi) return;
+    }
+}
+
+void MemoryDBConnection::remove(const std::string& ns, mongo::Query q,
+    bool justOne)
+{
+    mongo::BSONObj filter = q.getFilter();
+    Collection& docs = mCollections[ns];
+    for(auto it = docs.begin(); it != docs.end();)
+    {
+        if(!matches(*it, filter))
+        {
+            ++it;
+            continue;
+        }
+        it = docs.erase(it);
+        if(justOne) return;
+    }
+}
+
+bool MemoryDBConnection::runCommand(const std::string& dbname,
+    const mongo::BSONObj& cmd, mongo::BSONObj& info, int /* options */)
+{
+    if(std::string(cmd.firstElementFieldName()) == "count")
+    {
+        const Collection& docs =
+            mCollections[dbname + "." + cmd.firstElement().str()];
+        mongo::BSONObj filter = cmd["query"].isABSONObj() ?
+            cmd["query"].Obj() : mongo::BSONObj();
+        long long n = std::count_if(docs.begin(), docs.end(),
+            [&filter](const mongo::BSONObj& doc) {
+                return matches(doc, filter);
+            });
+        info = BSON("n" << static_cast<double>(n) << "ok" << 1.0);
+        return true;
+    }
+    // create, createIndexes and getlasterror have nothing to do here.
+    info = BSON("ok" << 1.0);
+    return true;
+}
+
+bool MemoryDBConnection::matches(const mongo::BSONObj& doc,
+    const mongo::BSONObj& filter)
+{
+    for(mongo::BSONObjIterator it(filter); it.more();)
+    {
+        mongo::BSONElement condition = it.next();
+        // $and, $or and the like aren't used.
+        if(isOperator(condition)) return false;
+        if(!_matchField(doc.getFieldDotted(condition.fieldName()),
+            condition))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MemoryDBConnection::_matchField(const mongo::BSONElement& value,
+    const mongo::BSONElement& condition)
+{
+    if(!condition.isABSONObj() || condition.Obj().isEmpty() ||
+        !isOperator(condition.Obj().firstElement()))
+    {
+        return !value.eoo() && value.woCompare(condition, false) == 0;
+    }
+    for(mongo::BSONObjIterator it(condition.Obj()); it.more();)
+    {
+        mongo::BSONElement op = it.next();
+        std::string name = op.fieldName();
+        int cmp = value.eoo() ? 0 : value.woCompare(op, false);
+        bool matched;
+        if(name == "$exists") matched = value.eoo() != op.trueValue();
+        else if(name == "$ne") matched = value.eoo() || cmp != 0;
+        else if(value.eoo()) matched = false;
+        else if(name == "$gt") matched = cmp > 0;
+        else if(name == "$gte") matched = cmp >= 0;
+        else if(name == "$lt") matched = cmp < 0;
+        else if(name == "$lte") matched = cmp <= 0;
+        else if(name == "$regex")
+        {
+            matched = value.type() == mongo::String &&
+                std::regex_search(value.str(), std::regex(op.str()));
+        }
+        else if(name == "$in")
+        {
+            matched = false;
+            for(mongo::BSONObjIterator in(op.Obj()); in.more();)
+            {
+                if(value.woCompare(in.next(), false) == 0)
+                {
+                    matched = true;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            LOG(WARNING) << "Unsupported query operator " << name;
+            matched = false;
+        }
+        if(!matched) return false;
+    }
+    return true;
+}
+
+mongo::BSONObj MemoryDBConnection::_applyUpdate(const mongo::BSONObj& doc,
+    const mongo::BSONObj& update)
+{
+    if(update.isEmpty() || !isOperator(update.firstElement()))
+    {
+        mongo::BSONObjBuilder b;
+        b.append(doc["_id"]);
+        for(mongo::BSONObjIterator it(update); it.more();)
+        {
+            mongo::BSONElement e = it.next();
+            if(std::string(e.fieldName()) != "_id") b.append(e);
+        }
+        return b.obj();
+    }
+    mongo::BSONObj result = doc;
+    for(mongo::BSONObjIterator ops(update); ops.more();)
+    {
+        mongo::BSONElement op = ops.next();
+        std::string name = op.fieldName();
+        for(mongo::BSONObjIterator it(op.Obj()); it.more();)
+        {
+            mongo::BSONElement field = it.next();
+            std::string path = field.fieldName();
+            if(name == "$set")
+            {
+                result = _setField(result, path, &field);
+            }
+            else if(name == "$unset")
+            {
+                result = _setField(result, path, nullptr);
+            }
+            else if(name == "$inc")
+            {
+                mongo::BSONElement current = result.getFieldDotted(path);
+                mongo::BSONObj sum;
+                if(current.type() == mongo::NumberDouble ||
+                    field.type() == mongo::NumberDouble)
+                {
+                    sum = BSON("v" << current.number() + field.number());
+                }
+                else if(current.type() == mongo::NumberLong ||
+                    field.type() == mongo::NumberLong)
+                {
+                    sum = BSON("v" << static_cast<long long>(
+                        current.numberLong() + field.numberLong()));
+                }
+                else
+                {
+                    sum = BSON("v" << current.numberInt() +
+                        field.numberInt());
+                }
+                mongo::BSONElement value = sum.firstElement();
+                result = _setField(result, path, &value);
+            }
+            else
+            {
+                LOG(WARNING) << "Unsupported update operator " << name;
+            }
+        }
+    }
+    return result;
+}
+
+mongo::BSONObj MemoryDBConnection::_setField(const mongo::BSONObj& obj,
+    const std::string& path, const mongo::BSONElement* value)
+{
+    size_t dot = path.find('.');
+    std::string head = path.substr(0, dot);
+    std::string rest = dot == std::string::npos ? "" : path.substr(dot + 1);
+    mongo::BSONObjBuilder b;
+    bool found = false;
+    for(mongo::BSONObjIterator it(obj); it.more();)
+    {
+        mongo::BSONElement e = it.next();
+        if(head != e.fieldName())
+        {
+            b.append(e);
+            continue;
+        }
+        found = true;
+        if(dot != std::string::npos)
+        {
+            b.append(head, _setField(e.isABSONObj() ? e.Obj() :
+                mongo::BSONObj(), rest, value));
+        }
+        else if(value != nullptr)
+        {
+            b.appendAs(*value, head);
+        }
+    }
+    if(!found && value != nullptr)
+    {
+        if(dot != std::string::npos)
+        {
+            b.append(head, _setField(mongo::BSONObj(), rest, value));
+        }
+        else b.appendAs(*value, head);
+    }
+    return b.obj();
+}
+
+MemoryDBConnection& getMemoryDB()
+{
+    static MemoryDBConnection db;
+    return db;
+}
+
+/** ~~ Replacing Common.cpp ~~ **/
+
+mongo::DBClientConnection* getDBConn()
+{
+    return &getMemoryDB();
+}
+
+bool dbCheckError()
+{
+    auto err = MONGO_TIMED("", "getLastError", getDBConn()->getLastError());
+    if (err.size())
+    {
+        LOG(ERROR) << err;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mongo/client/dbclient.h>
+
+namespace swcu {
+
+/**
+ * Connection keeping every collection in memory, standing in for MongoDB
+ * in the benchmarks. Understands the part of the query language the game
+ * mode uses: equality on dotted fields, $in, $gt, $gte, $lt, $lte, $ne,
+ * $exists and $regex, sorting, skipping and limiting. Updates take $set,
+ * $unset, $inc or a whole new document. Projections and upserts are
+ * ignored and unique indexes are not enforced.
+ */
+class MemoryDBConnection : public mongo::DBClientConnection
+{
+public:
+    typedef std::vector<mongo::BSONObj> Collection;
+
+protected:
+    std::map<std::string, Collection> mCollections;
+
+public:
+                    MemoryDBConnection() : mongo::DBClientConnection(false)
+                    {}
+    virtual         ~MemoryDBConnection() {}
+
+    using mongo::DBClientConnection::query;
+    using mongo::DBClientConnection::insert;
+    using mongo::DBClientConnection::update;
+    using mongo::DBClientConnection::remove;
+
+    virtual std::auto_ptr<mongo::DBClientCursor> query(
+        const std::string& ns, mongo::Query query = mongo::Query(),
+        int nToReturn = 0, int nToSkip = 0,
+        const mongo::BSONObj* fieldsToReturn = 0, int queryOptions = 0,
+        int batchSize = 0) override;
+    virtual void    insert(const std::string& ns, mongo::BSONObj obj,
+        int flags = 0) override;
+    virtual void    insert(const std::string& ns,
+        const std::vector<mongo::BSONObj>& v, int flags = 0) override;
+    virtual void    update(const std::string& ns, mongo::Query query,
+        mongo::BSONObj obj, bool upsert = false, bool multi = false)
+        override;
+    virtual void    remove(const std::string& ns, mongo::Query q,
+        bool justOne = 0) override;
+    /**
+     * Counts for count, every other command just succeeds.
+     */
+    virtual bool    runCommand(const std::string& dbname,
+        const mongo::BSONObj& cmd, mongo::BSONObj& info, int options = 0)
+        override;
+
+            Collection& getCollection(const std::string& ns)
+            { return mCollections[ns]; }
+            void    clear()                     { mCollections.clear(); }
+
+    static  bool    matches(const mongo::BSONObj& doc,
+        const mongo::BSONObj& filter);
+
+protected:
+    static  bool    _matchField(const mongo::BSONElement& value,
+        const mongo::BSONElement& condition);
+    static  mongo::BSONObj _applyUpdate(const mongo::BSONObj& doc,
+        const mongo::BSONObj& update);
+    /**
+     * Rebuild obj with the field at the dotted path set to value, or
+     * removed if value is nullptr. Missing parents are created.
+     */
+    static  mongo::BSONObj _setField(const mongo::BSONObj& obj,
+        const std::string& path, const mongo::BSONElement* value);
+};
+
+/**
+ * Cursor over the results of a query, copied out when it was made.
+ */
+class MemoryCursor : public mongo::DBClientCursor
+{
+protected:
+    std::vector<mongo::BSONObj> mDocs;
+    size_t          mNext;
+
+public:
+                    MemoryCursor(mongo::DBClientBase* client,
+                        const std::string& ns,
+                        std::vector<mongo::BSONObj> docs) :
+                        mongo::DBClientCursor(client, ns, 0LL, 0, 0),
+                        mDocs(std::move(docs)), mNext(0) {}
+    virtual         ~MemoryCursor() {}
+
+    virtual bool    more() override { return mNext < mDocs.size(); }
+    virtual mongo::BSONObj next() override { return mDocs[mNext++]; }
+};
+
+/**
+ * What getDBConn() returns in the benchmarks.
+ */
+MemoryDBConnection& getMemoryDB();
+
+}
@@ -0,0 +1,512 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sampgdk/a_objects.h>
+#include <sampgdk/a_players.h>
+#include <sampgdk/a_samp.h>
+#include <sampgdk/a_vehicles.h>
+
+#include "StubServer.hpp"
+
+/**
+ * The natives of sampgdk used by the game mode, defined under the names
+ * its headers declare, so nothing else has to change to link without the
+ * server. Getters report what the setters were given.
+ */
+
+namespace swcu {
+
+StubServer::StubServer() : mCalls(0)
+{
+    for(int i = 0; i < MAX_PLAYERS; ++i) disconnect(i);
+}
+
+void StubServer::connect(int playerid, const std::string& name)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    disconnect(playerid);
+    mPlayers[playerid].connected = true;
+    mPlayers[playerid].name = name;
+}
+
+void StubServer::disconnect(int playerid)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    PlayerState& player = mPlayers[playerid];
+    player.connected = false;
+    player.name.clear();
+    player.x = player.y = player.z = player.facing = 0.0f;
+    player.world = player.interior = player.skin = 0;
+    player.vehicle = INVALID_VEHICLE_ID;
+    player.seat = -1;
+    player.dialogId = -1;
+    player.dialogStyle = 0;
+    player.dialogInfo.clear();
+}
+
+StubServer::PlayerState& StubServer::getPlayer(int playerid)
+{
+    static PlayerState none;
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS)
+    {
+        // Natives may have written to it, keep it looking disconnected.
+        none.connected = false;
+        return none;
+    }
+    return mPlayers[playerid];
+}
+
+int StubServer::createVehicle(int model, float x, float y, float z,
+    float angle)
+{
+    VehicleState vehicle = { true, model, x, y, z, angle, 0 };
+    for(size_t i = 0; i < mVehicles.size(); ++i)
+    {
+        if(!mVehicles[i].exists)
+        {
+            mVehicles[i] = vehicle;
+            return static_cast<int>(i + 1);
+        }
+    }
+    mVehicles.push_back(vehicle);
+    return static_cast<int>(mVehicles.size());
+}
+
+bool StubServer::destroyVehicle(int vehicleid)
+{
+    VehicleState* vehicle = getVehicle(vehicleid);
+    if(vehicle == nullptr) return false;
+    vehicle->exists = false;
+    return true;
+}
+
+StubServer::VehicleState* StubServer::getVehicle(int vehicleid)
+{
+    if(vehicleid < 1 || static_cast<size_t>(vehicleid) > mVehicles.size())
+    {
+        return nullptr;
+    }
+    VehicleState& vehicle = mVehicles[vehicleid - 1];
+    return vehicle.exists ? &vehicle : nullptr;
+}
+
+int StubServer::addTimer(const Timer& timer)
+{
+    mTimers.push_back(timer);
+    return static_cast<int>(mTimers.size());
+}
+
+int StubServer::createItem(std::vector<bool>& items)
+{
+    for(size_t i = 0; i < items.size(); ++i)
+    {
+        if(!items[i])
+        {
+            items[i] = true;
+            return static_cast<int>(i + 1);
+        }
+    }
+    items.push_back(true);
+    return static_cast<int>(items.size());
+}
+
+bool StubServer::destroyItem(std::vector<bool>& items, int id)
+{
+    if(!hasItem(items, id)) return false;
+    items[id - 1] = false;
+    return true;
+}
+
+bool StubServer::hasItem(const std::vector<bool>& items, int id)
+{
+    return id >= 1 && static_cast<size_t>(id) <= items.size() &&
+        items[id - 1];
+}
+
+size_t StubServer::countItems(const std::vector<bool>& items)
+{
+    size_t count = 0;
+    for(bool alive : items)
+    {
+        if(alive) ++count;
+    }
+    return count;
+}
+
+}
+
+namespace {
+
+swcu::StubServer& stub()
+{
+    swcu::StubServer& server = swcu::StubServer::get();
+    server.countCall();
+    return server;
+}
+
+/**
+ * @return The player if connected, else nullptr, when natives fail.
+ */
+swcu::StubServer::PlayerState* online(int playerid)
+{
+    swcu::StubServer::PlayerState& player = stub().getPlayer(playerid);
+    return player.connected ? &player : nullptr;
+}
+
+int copyString(const std::string& str, char* buffer, int size)
+{
+    if(size <= 0) return 0;
+    size_t length = std::min(str.size(), static_cast<size_t>(size - 1));
+    memcpy(buffer, str.data(), length);
+    buffer[length] = '\0';
+    return static_cast<int>(length);
+}
+
+}
+
+/** ~~ Server ~~ **/
+
+int AddPlayerClass(int /* modelid */, float /* spawn_x */,
+    float /* spawn_y */, float /* spawn_z */, float /* z_angle */,
+    int /* weapon1 */, int /* weapon1_ammo */, int /* weapon2 */,
+    int /* weapon2_ammo */, int /* weapon3 */, int /* weapon3_ammo */)
+{
+    stub();
+    return 0;
+}
+
+int GetMaxPlayers()
+{
+    stub();
+    return MAX_PLAYERS;
+}
+
+bool ShowNameTags(bool /* show */)
+{
+    stub();
+    return true;
+}
+
+bool CreateExplosion(float /* x */, float /* y */, float /* z */,
+    int /* type */, float /* radius */)
+{
+    stub();
+    return true;
+}
+
+int SetTimer(int interval, bool repeat, TimerCallback callback, void* param)
+{
+    return stub().addTimer({ interval, repeat, callback, param });
+}
+
+bool SendClientMessageToAll(int /* color */, const char* /* message */)
+{
+    stub();
+    return true;
+}
+
+bool SendDeathMessage(int /* killer */, int /* killee */, int /* weapon */)
+{
+    stub();
+    return true;
+}
+
+/** ~~ Players ~~ **/
+
+bool IsPlayerConnected(int playerid)
+{
+    return online(playerid) != nullptr;
+}
+
+int GetPlayerName(int playerid, char* name, int size)
+{
+    auto player = online(playerid);
+    return copyString(player ? player->name : "", name, size);
+}
+
+int SetPlayerName(int playerid, const char* name)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return -1;
+    player->name = name;
+    return 1;
+}
+
+int GetPlayerIp(int playerid, char* ip, int size)
+{
+    return copyString(online(playerid) ? "127.0.0.1" : "", ip, size);
+}
+
+int gpci(int playerid, char* buffer, int size)
+{
+    return copyString(online(playerid) ?
+        "0123456789ABCDEF0123456789ABCDEF01234567" : "", buffer, size);
+}
+
+bool Kick(int playerid)
+{
+    return online(playerid) != nullptr;
+}
+
+bool ForceClassSelection(int playerid)
+{
+    return online(playerid) != nullptr;
+}
+
+bool TogglePlayerControllable(int playerid, bool /* toggle */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool SendClientMessage(int playerid, int /* color */,
+    const char* /* message */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool ShowPlayerDialog(int playerid, int dialogid, int style,
+    const char* /* caption */, const char* info,
+    const char* /* button1 */, const char* /* button2 */)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->dialogId = dialogid;
+    player->dialogStyle = style;
+    player->dialogInfo = info;
+    return true;
+}
+
+bool SelectObject(int playerid)
+{
+    return online(playerid) != nullptr;
+}
+
+bool GetPlayerPos(int playerid, float* x, float* y, float* z)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    *x = player->x;
+    *y = player->y;
+    *z = player->z;
+    return true;
+}
+
+bool SetPlayerPos(int playerid, float x, float y, float z)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->x = x;
+    player->y = y;
+    player->z = z;
+    return true;
+}
+
+float GetPlayerDistanceFromPoint(int playerid, float x, float y, float z)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return 0.0f;
+    float dx = player->x - x, dy = player->y - y, dz = player->z - z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+bool GetPlayerFacingAngle(int playerid, float* angle)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    *angle = player->facing;
+    return true;
+}
+
+bool SetPlayerFacingAngle(int playerid, float angle)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->facing = angle;
+    return true;
+}
+
+int GetPlayerInterior(int playerid)
+{
+    auto player = online(playerid);
+    return player ? player->interior : 0;
+}
+
+bool SetPlayerInterior(int playerid, int interiorid)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->interior = interiorid;
+    return true;
+}
+
+int GetPlayerVirtualWorld(int playerid)
+{
+    auto player = online(playerid);
+    return player ? player->world : 0;
+}
+
+bool SetPlayerVirtualWorld(int playerid, int worldid)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->world = worldid;
+    return true;
+}
+
+bool SetPlayerSkin(int playerid, int skinid)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->skin = skinid;
+    return true;
+}
+
+bool SetPlayerColor(int playerid, int /* color */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool SetPlayerHealth(int playerid, float /* health */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool SetPlayerArmour(int playerid, float /* armour */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool SetPlayerWantedLevel(int playerid, int /* level */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool SetPlayerSpecialAction(int playerid, int /* actionid */)
+{
+    return online(playerid) != nullptr;
+}
+
+bool GivePlayerWeapon(int playerid, int /* weaponid */, int /* ammo */)
+{
+    return online(playerid) != nullptr;
+}
+
+int GetPlayerVehicleID(int playerid)
+{
+    auto player = online(playerid);
+    return player ? player->vehicle : 0;
+}
+
+int GetPlayerVehicleSeat(int playerid)
+{
+    auto player = online(playerid);
+    return player ? player->seat : -1;
+}
+
+bool IsPlayerInAnyVehicle(int playerid)
+{
+    auto player = online(playerid);
+    return player != nullptr && player->vehicle != INVALID_VEHICLE_ID;
+}
+
+bool PutPlayerInVehicle(int playerid, int vehicleid, int seatid)
+{
+    auto player = online(playerid);
+    if(player == nullptr || !swcu::StubServer::get().getVehicle(vehicleid))
+    {
+        return false;
+    }
+    player->vehicle = vehicleid;
+    player->seat = seatid;
+    return true;
+}
+
+bool RemovePlayerFromVehicle(int playerid)
+{
+    auto player = online(playerid);
+    if(player == nullptr) return false;
+    player->vehicle = INVALID_VEHICLE_ID;
+    player->seat = -1;
+    return true;
+}
+
+/** ~~ Vehicles ~~ **/
+
+int CreateVehicle(int vehicletype, float x, float y, float z,
+    float rotation, int /* color1 */, int /* color2 */,
+    int /* respawn_delay */, bool /* addsiren */)
+{
+    return stub().createVehicle(vehicletype, x, y, z, rotation);
+}
+
+bool DestroyVehicle(int vehicleid)
+{
+    return stub().destroyVehicle(vehicleid);
+}
+
+bool SetVehiclePos(int vehicleid, float x, float y, float z)
+{
+    auto vehicle = stub().getVehicle(vehicleid);
+    if(vehicle == nullptr) return false;
+    vehicle->x = x;
+    vehicle->y = y;
+    vehicle->z = z;
+    return true;
+}
+
+bool SetVehicleZAngle(int vehicleid, float z_angle)
+{
+    auto vehicle = stub().getVehicle(vehicleid);
+    if(vehicle == nullptr) return false;
+    vehicle->angle = z_angle;
+    return true;
+}
+
+bool SetVehicleVirtualWorld(int vehicleid, int worldid)
+{
+    auto vehicle = stub().getVehicle(vehicleid);
+    if(vehicle == nullptr) return false;
+    vehicle->world = worldid;
+    return true;
+}
+
+bool LinkVehicleToInterior(int vehicleid, int /* interiorid */)
+{
+    return stub().getVehicle(vehicleid) != nullptr;
+}
+
+bool SetVehicleToRespawn(int vehicleid)
+{
+    return stub().getVehicle(vehicleid) != nullptr;
+}
+
+bool RepairVehicle(int vehicleid)
+{
+    return stub().getVehicle(vehicleid) != nullptr;
+}
+
+bool ChangeVehicleColor(int vehicleid, int /* color1 */, int /* color2 */)
+{
+    return stub().getVehicle(vehicleid) != nullptr;
+}
+
+bool AddVehicleComponent(int vehicleid, int /* componentid */)
+{
+    return stub().getVehicle(vehicleid) != nullptr;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sampgdk/a_samp.h>
+
+#include "../Utility/Singleton.hpp"
+
+namespace swcu {
+
+/**
+ * What the stub natives of the benchmarks remember in place of the SA-MP
+ * server and the streamer. Only what the game mode reads back is kept,
+ * natives which just show something to players are counted and return.
+ * Like the natives, it's only used from the game thread.
+ */
+class StubServer : public Singleton<StubServer>
+{
+public:
+    struct PlayerState
+    {
+        bool            connected;
+        std::string     name;
+        float           x, y, z, facing;
+        int             world, interior, skin;
+        int             vehicle, seat;
+        // The dialog shown last.
+        int             dialogId;
+        int             dialogStyle;
+        std::string     dialogInfo;
+    };
+
+    struct VehicleState
+    {
+        bool            exists;
+        int             model;
+        float           x, y, z, angle;
+        int             world;
+    };
+
+    struct Timer
+    {
+        int             interval;
+        bool            repeat;
+        TimerCallback   callback;
+        void*           param;
+    };
+
+protected:
+    std::array<PlayerState, MAX_PLAYERS> mPlayers;
+    // By id - 1, ids are reused once freed like the server does.
+    std::vector<VehicleState>            mVehicles;
+    std::vector<Timer>                   mTimers;
+    // Streamer items alive, by id - 1.
+    std::vector<bool>                    mObjects;
+    std::vector<bool>                    mLabels;
+    std::vector<bool>                    mAreas;
+    uint64_t                             mCalls;
+
+protected:
+                    StubServer();
+    friend class Singleton<StubServer>;
+
+public:
+    virtual         ~StubServer() {}
+
+    /**
+     * Make the slot look like a client joined under the name. Only the
+     * server side, the game mode learns of it from OnPlayerConnect.
+     */
+            void    connect(int playerid, const std::string& name);
+            void    disconnect(int playerid);
+    /**
+     * @return The state of the slot, or a disconnected dummy if the id is
+     *         out of range.
+     */
+            PlayerState& getPlayer(int playerid);
+
+            int     createVehicle(int model, float x, float y, float z,
+                float angle);
+            bool    destroyVehicle(int vehicleid);
+            VehicleState* getVehicle(int vehicleid);
+
+            int     addTimer(const Timer& timer);
+            const std::vector<Timer>& getTimers() const { return mTimers; }
+
+    /**
+     * Streamer items, numbered from 1 like the streamer does.
+     */
+    static  int     createItem(std::vector<bool>& items);
+    static  bool    destroyItem(std::vector<bool>& items, int id);
+    static  bool    hasItem(const std::vector<bool>& items, int id);
+            std::vector<bool>& getObjects()         { return mObjects; }
+            std::vector<bool>& getLabels()          { return mLabels; }
+            std::vector<bool>& getAreas()           { return mAreas; }
+    static  size_t  countItems(const std::vector<bool>& items);
+
+    /**
+     * Natives called so far, to tell how chatty a benchmark is.
+     */
+            void    countCall()                     { ++mCalls; }
+            uint64_t getCallCount() const           { return mCalls; }
+};
+
+}
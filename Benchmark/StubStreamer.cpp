@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StubServer.hpp"
+#include "StubStreamer.hpp"
+
+using swcu::StubServer;
+
+namespace {
+
+StubServer& stub()
+{
+    StubServer& server = StubServer::get();
+    server.countCall();
+    return server;
+}
+
+}
+
+namespace Natives {
+
+/** ~~ Objects ~~ **/
+
+int CreateDynamicObject(int /* modelid */, float /* x */, float /* y */,
+    float /* z */, float /* rx */, float /* ry */, float /* rz */,
+    int /* worldid */, int /* interiorid */, int /* playerid */,
+    float /* streamdistance */)
+{
+    StubServer& server = stub();
+    return StubServer::createItem(server.getObjects());
+}
+
+bool DestroyDynamicObject(int objectid)
+{
+    StubServer& server = stub();
+    return StubServer::destroyItem(server.getObjects(), objectid);
+}
+
+bool SetDynamicObjectPos(int objectid, float /* x */, float /* y */,
+    float /* z */)
+{
+    StubServer& server = stub();
+    return StubServer::hasItem(server.getObjects(), objectid);
+}
+
+bool SetDynamicObjectRot(int objectid, float /* rx */, float /* ry */,
+    float /* rz */)
+{
+    StubServer& server = stub();
+    return StubServer::hasItem(server.getObjects(), objectid);
+}
+
+bool SetDynamicObjectMaterialText(int objectid, int /* materialindex */,
+    const std::string& /* text */, int /* materialsize */,
+    const std::string& /* fontface */, int /* fontsize */,
+    bool /* bold */, int /* fontcolor */, int /* backcolor */,
+    int /* textalignment */)
+{
+    StubServer& server = stub();
+    return StubServer::hasItem(server.getObjects(), objectid);
+}
+
+bool EditDynamicObject(int playerid, int objectid)
+{
+    StubServer& server = stub();
+    return server.getPlayer(playerid).connected &&
+        StubServer::hasItem(server.getObjects(), objectid);
+}
+
+/** ~~ 3D Text Labels ~~ **/
+
+int CreateDynamic3DTextLabel(const std::string& /* text */, int /* color */,
+    float /* x */, float /* y */, float /* z */, float /* drawdistance */,
+    int /* attachedplayer */, int /* attachedvehicle */, bool /* testlos */,
+    int /* worldid */, int /* interiorid */, int /* playerid */,
+    float /* streamdistance */)
+{
+    StubServer& server = stub();
+    return StubServer::createItem(server.getLabels());
+}
+
+bool DestroyDynamic3DTextLabel(int id)
+{
+    StubServer& server = stub();
+    return StubServer::destroyItem(server.getLabels(), id);
+}
+
+bool UpdateDynamic3DTextLabelText(int id, int /* color */,
+    const std::string& /* text */)
+{
+    StubServer& server = stub();
+    return StubServer::hasItem(server.getLabels(), id);
+}
+
+/** ~~ Areas ~~ **/
+
+int CreateDynamicSphere(float /* x */, float /* y */, float /* z */,
+    float /* size */, int /* worldid */, int /* interiorid */,
+    int /* playerid */)
+{
+    StubServer& server = stub();
+    return StubServer::createItem(server.getAreas());
+}
+
+int CreateDynamicCuboid(float /* minx */, float /* miny */,
+    float /* minz */, float /* maxx */, float /* maxy */, float /* maxz */,
+    int /* worldid */, int /* interiorid */, int /* playerid */)
+{
+    StubServer& server = stub();
+    return StubServer::createItem(server.getAreas());
+}
+
+bool DestroyDynamicArea(int areaid)
+{
+    StubServer& server = stub();
+    return StubServer::destroyItem(server.getAreas(), areaid);
+}
+
+/** ~~ Updates ~~ **/
+
+bool Streamer_Update(int playerid)
+{
+    return stub().getPlayer(playerid).connected;
+}
+
+bool Streamer_UpdateEx(int playerid, float /* x */, float /* y */,
+    float /* z */, int /* worldid */, int /* interiorid */)
+{
+    return stub().getPlayer(playerid).connected;
+}
+
+}
+
+/** ~~ Callback Forwarding ~~ **/
+
+bool Streamer_OnPlayerConnect(int /* playerid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerDisconnect(int /* playerid */, int /* reason */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerEnterCheckpoint(int /* playerid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerLeaveCheckpoint(int /* playerid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerEnterRaceCheckpoint(int /* playerid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerLeaveRaceCheckpoint(int /* playerid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerPickUpPickup(int /* playerid */, int /* pickupid */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerEditObject(int /* playerid */, bool /* playerobject */,
+    int /* objectid */, int /* response */, float /* x */, float /* y */,
+    float /* z */, float /* rx */, float /* ry */, float /* rz */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerSelectObject(int /* playerid */, int /* type */,
+    int /* objectid */, int /* modelid */, float /* x */, float /* y */,
+    float /* z */)
+{
+    return true;
+}
+
+bool Streamer_OnPlayerWeaponShot(int /* playerid */, int /* weaponid */,
+    int /* hittype */, int /* hitid */, float /* x */, float /* y */,
+    float /* z */)
+{
+    return true;
+}
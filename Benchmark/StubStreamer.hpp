@@ -0,0 +1,87 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+/**
+ * Stand-ins for the natives and callback forwarders of the streamer, with
+ * the same signatures, for the benchmarks. Items are only numbered and
+ * counted by StubServer, nothing is streamed to anyone.
+ */
+
+namespace Natives {
+
+/** ~~ Objects ~~ **/
+
+int CreateDynamicObject(int modelid, float x, float y, float z,
+    float rx, float ry, float rz, int worldid = -1, int interiorid = -1,
+    int playerid = -1, float streamdistance = 300.0f);
+bool DestroyDynamicObject(int objectid);
+bool SetDynamicObjectPos(int objectid, float x, float y, float z);
+bool SetDynamicObjectRot(int objectid, float rx, float ry, float rz);
+bool SetDynamicObjectMaterialText(int objectid, int materialindex,
+    const std::string& text, int materialsize = 90,
+    const std::string& fontface = "Arial", int fontsize = 24,
+    bool bold = true, int fontcolor = 0xFFFFFFFF, int backcolor = 0,
+    int textalignment = 0);
+bool EditDynamicObject(int playerid, int objectid);
+
+/** ~~ 3D Text Labels ~~ **/
+
+int CreateDynamic3DTextLabel(const std::string& text, int color,
+    float x, float y, float z, float drawdistance,
+    int attachedplayer = 0xFFFF, int attachedvehicle = 0xFFFF,
+    bool testlos = false, int worldid = -1, int interiorid = -1,
+    int playerid = -1, float streamdistance = 100.0f);
+bool DestroyDynamic3DTextLabel(int id);
+bool UpdateDynamic3DTextLabelText(int id, int color,
+    const std::string& text);
+
+/** ~~ Areas ~~ **/
+
+int CreateDynamicSphere(float x, float y, float z, float size,
+    int worldid = -1, int interiorid = -1, int playerid = -1);
+int CreateDynamicCuboid(float minx, float miny, float minz,
+    float maxx, float maxy, float maxz,
+    int worldid = -1, int interiorid = -1, int playerid = -1);
+bool DestroyDynamicArea(int areaid);
+
+/** ~~ Updates ~~ **/
+
+bool Streamer_Update(int playerid);
+bool Streamer_UpdateEx(int playerid, float x, float y, float z,
+    int worldid = -1, int interiorid = -1);
+
+}
+
+/** ~~ Callback Forwarding ~~ **/
+
+bool Streamer_OnPlayerConnect(int playerid);
+bool Streamer_OnPlayerDisconnect(int playerid, int reason);
+bool Streamer_OnPlayerEnterCheckpoint(int playerid);
+bool Streamer_OnPlayerLeaveCheckpoint(int playerid);
+bool Streamer_OnPlayerEnterRaceCheckpoint(int playerid);
+bool Streamer_OnPlayerLeaveRaceCheckpoint(int playerid);
+bool Streamer_OnPlayerPickUpPickup(int playerid, int pickupid);
+bool Streamer_OnPlayerEditObject(int playerid, bool playerobject,
+    int objectid, int response, float x, float y, float z,
+    float rx, float ry, float rz);
+bool Streamer_OnPlayerSelectObject(int playerid, int type, int objectid,
+    int modelid, float x, float y, float z);
+bool Streamer_OnPlayerWeaponShot(int playerid, int weaponid, int hittype,
+    int hitid, float x, float y, float z);
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "Internal/Logging.hpp"
+#include "Internal/Config.hpp"
+#include "AsyncLog.hpp"
+
+namespace swcu {
+
+namespace {
+
+/**
+ * Hands the lines built by easylogging++ to AsyncLog.
+ */
+class AsyncLogDispatch : public el::LogDispatchCallback
+{
+protected:
+    void handle(const el::LogDispatchData* data) override
+    {
+        if(data->dispatchAction() != el::base::DispatchAction::NormalLog)
+        {
+            return;
+        }
+        const el::LogMessage* message = data->logMessage();
+        std::string line = message->logger()->logBuilder()->build(
+            message, true);
+        // The process is about to abort, the writer won't get to it.
+        if(message->level() == el::Level::Fatal)
+        {
+            fwrite(line.data(), 1, line.size(), stderr);
+            fflush(stderr);
+        }
+        AsyncLog::get().write(line.data(), line.size());
+    }
+};
+
+const char* const ASYNC_DISPATCH_ID     = "AsyncLogDispatch";
+const char* const DEFAULT_DISPATCH_ID   = "DefaultLogDispatchCallback";
+
+/**
+ * The ring of a thread, let go when the thread exits. AsyncLog keeps it
+ * until what's left in it is written.
+ */
+struct RingHandle
+{
+    std::shared_ptr<LogRing>    ring;
+
+                                ~RingHandle() { if(ring) ring->close(); }
+};
+
+}
+
+LogRing::LogRing(size_t capacity) :
+    mMask(0), mHead(0), mTail(0), mClosed(false)
+{
+    size_t size = 1;
+    while(size < capacity) size <<= 1;
+    mData.reset(new char[size]);
+    mMask = size - 1;
+}
+
+bool LogRing::push(const char* text, size_t size)
+{
+    // The positions only grow and are taken modulo the capacity, which
+    // divides the range of size_t, so wrapping around is harmless.
+    size_t head = mHead.load(std::memory_order_relaxed);
+    size_t tail = mTail.load(std::memory_order_acquire);
+    if(size > mMask + 1 - (head - tail)) return false;
+    size_t start = head & mMask;
+    size_t first = std::min(size, mMask + 1 - start);
+    memcpy(mData.get() + start, text, first);
+    memcpy(mData.get(), text + first, size - first);
+    mHead.store(head + size, std::memory_order_release);
+    return true;
+}
+
+size_t LogRing::drain(std::string& out)
+{
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    size_t head = mHead.load(std::memory_order_acquire);
+    size_t size = head - tail;
+    size_t start = tail & mMask;
+    size_t first = std::min(size, mMask + 1 - start);
+    out.append(mData.get() + start, first);
+    out.append(mData.get(), size - first);
+    mTail.store(head, std::memory_order_release);
+    return size;
+}
+
+AsyncLog::AsyncLog() :
+    mRunning(false), mFileSize(0),
+    mDropped(&Metrics::get().counter("swcu_log_dropped_total", "",
+        "Log lines dropped for a full ring.")),
+    mWritten(&Metrics::get().counter("swcu_log_written_bytes_total", "",
+        "Bytes of log written by the log writer."))
+{
+}
+
+bool AsyncLog::start(const std::string& path)
+{
+    if(isRunning()) return true;
+    mFile.open(path, std::ios::binary | std::ios::app);
+    if(!mFile.is_open())
+    {
+        LOG(ERROR) << "Cannot open log file " << path << ".";
+        return false;
+    }
+    mPath = path;
+    mFile.seekp(0, std::ios::end);
+    mFileSize = static_cast<size_t>(mFile.tellp());
+    mRunning.store(true, std::memory_order_release);
+    mWriter = std::thread(&AsyncLog::_run, this);
+    el::Helpers::installLogDispatchCallback<AsyncLogDispatch>(
+        ASYNC_DISPATCH_ID);
+    el::Helpers::uninstallLogDispatchCallback<
+        el::base::DefaultLogDispatchCallback>(DEFAULT_DISPATCH_ID);
+    LOG(INFO) << "Logging to " << path << " in the background.";
+    return true;
+}
+
+void AsyncLog::stop()
+{
+    if(!isRunning()) return;
+    // New lines are written at once from here on, the writer only has to
+    // finish the queued ones.
+    el::Helpers::installLogDispatchCallback<
+        el::base::DefaultLogDispatchCallback>(DEFAULT_DISPATCH_ID);
+    el::Helpers::uninstallLogDispatchCallback<AsyncLogDispatch>(
+        ASYNC_DISPATCH_ID);
+    _stopWriter();
+}
+
+bool AsyncLog::write(const char* text, size_t size)
+{
+    if(_ring().push(text, size)) return true;
+    mDropped->inc();
+    return false;
+}
+
+LogRing& AsyncLog::_ring()
+{
+    thread_local RingHandle handle;
+    if(!handle.ring)
+    {
+        handle.ring = std::make_shared<LogRing>(Config::logRingSize);
+        std::lock_guard<std::mutex> lock(mRingsMutex);
+        mRings.push_back(handle.ring);
+    }
+    return *handle.ring;
+}
+
+void AsyncLog::_run()
+{
+    std::string batch;
+    for(;;)
+    {
+        // Read before collecting, so the last round takes everything
+        // written before stop().
+        bool running = isRunning();
+        _collect(batch);
+        if(!batch.empty())
+        {
+            _output(batch);
+            batch.clear();
+        }
+        if(!running) break;
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWake.wait_for(lock,
+            std::chrono::milliseconds(Config::logFlushInterval),
+            [this]() { return !isRunning(); });
+    }
+}
+
+void AsyncLog::_stopWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mRunning.store(false, std::memory_order_release);
+    }
+    mWake.notify_all();
+    if(mWriter.joinable()) mWriter.join();
+    if(mFile.is_open()) mFile.close();
+}
+
+void AsyncLog::_collect(std::string& batch)
+{
+    // Only threads writing their first line wait for this, and draining
+    // is no more than copying memory.
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    for(auto iter = mRings.begin(); iter != mRings.end();)
+    {
+        // Checked first, an exited thread can't have pushed after it.
+        bool closed = (*iter)->isClosed();
+        (*iter)->drain(batch);
+        if(closed) iter = mRings.erase(iter);
+        else ++iter;
+    }
+}
+
+void AsyncLog::_output(const std::string& batch)
+{
+    if(mFile.is_open())
+    {
+        if(mFileSize > 0 && mFileSize + batch.size() > Config::logMaxFileSize)
+        {
+            _rotate();
+        }
+        mFile.write(batch.data(), batch.size());
+        mFile.flush();
+        mFileSize += batch.size();
+    }
+    if(Config::logToConsole)
+    {
+        fwrite(batch.data(), 1, batch.size(), stdout);
+        fflush(stdout);
+    }
+    mWritten->inc(batch.size());
+}
+
+void AsyncLog::_rotate()
+{
+    mFile.close();
+    // path.N is the oldest and is overwritten, path becomes path.1.
+    for(size_t i = Config::logMaxFiles; i > 0; --i)
+    {
+        std::string from = i > 1 ? mPath + "." + std::to_string(i - 1) :
+            mPath;
+        std::rename(from.c_str(), (mPath + "." + std::to_string(i)).c_str());
+    }
+    if(Config::logMaxFiles == 0) std::remove(mPath.c_str());
+    mFile.open(mPath, std::ios::binary | std::ios::trunc);
+    mFileSize = 0;
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Utility/Singleton.hpp"
+#include "Metrics.hpp"
+
+namespace swcu {
+
+/**
+ * Bytes passed from one thread to another without locking. The producer
+ * only moves the head and the consumer only moves the tail.
+ */
+class LogRing
+{
+protected:
+    std::unique_ptr<char[]> mData;
+    size_t                  mMask;
+    std::atomic<size_t>     mHead;
+    // Keeps the two ends on different cache lines.
+    char                    mPadding[64];
+    std::atomic<size_t>     mTail;
+    // The thread writing to it has exited.
+    std::atomic<bool>       mClosed;
+
+public:
+    /**
+     * @param capacity Rounded up to a power of two.
+     */
+    explicit                LogRing(size_t capacity);
+
+    /**
+     * Copy in all of the text or, if there's no room for it, none of it.
+     */
+            bool            push(const char* text, size_t size);
+    /**
+     * Append everything pushed so far to out.
+     * @return Number of bytes taken.
+     */
+            size_t          drain(std::string& out);
+
+            void            close()
+            { mClosed.store(true, std::memory_order_release); }
+            bool            isClosed() const
+            { return mClosed.load(std::memory_order_acquire); }
+            bool            empty() const
+            { return mHead.load(std::memory_order_acquire) ==
+                mTail.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Log sink which never makes the caller wait for the disk. Each thread
+ * writing logs gets a ring of its own, and a background thread collects
+ * the rings about every Config::logFlushInterval ms and writes them out
+ * in one go, to Config::logPath and the console. The file is rotated
+ * once it grows past Config::logMaxFileSize, keeping Config::logMaxFiles
+ * old ones as path.1, path.2, ...
+ * A line which doesn't fit into the ring of its thread is dropped and
+ * counted rather than waited for.
+ *
+ * While started, it replaces the synchronous writer of easylogging++.
+ * Lines from different threads are written in the order they're
+ * collected, which may differ from their timestamps by an interval.
+ */
+class AsyncLog : public Singleton<AsyncLog>
+{
+protected:
+    std::mutex                              mRingsMutex;
+    std::vector<std::shared_ptr<LogRing>>   mRings;
+    std::atomic<bool>                       mRunning;
+    std::thread                             mWriter;
+    std::mutex                              mWakeMutex;
+    std::condition_variable                 mWake;
+
+    // Only used by the writer thread.
+    std::string                             mPath;
+    std::ofstream                           mFile;
+    size_t                                  mFileSize;
+
+    Counter*                                mDropped;
+    Counter*                                mWritten;
+
+protected:
+                            AsyncLog();
+    friend class Singleton<AsyncLog>;
+
+public:
+    /**
+     * Only stops the writer, easylogging++ may be gone by then.
+     */
+    virtual                 ~AsyncLog() { _stopWriter(); }
+
+    /**
+     * Start the writer thread and route easylogging++ through it.
+     */
+            bool            start(const std::string& path);
+    /**
+     * Write out what's left and give logging back to easylogging++.
+     */
+            void            stop();
+            bool            isRunning() const
+            { return mRunning.load(std::memory_order_acquire); }
+
+    /**
+     * Queue a line, with its line break, from any thread. Never blocks
+     * once the thread has written its first line.
+     * @return False if the line was dropped.
+     */
+            bool            write(const char* text, size_t size);
+
+protected:
+            LogRing&        _ring();
+            void            _run();
+            void            _stopWriter();
+    /**
+     * Take the text of every ring and forget the rings of exited threads.
+     */
+            void            _collect(std::string& batch);
+            void            _output(const std::string& batch);
+            void            _rotate();
+};
+
+}
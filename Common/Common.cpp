@@ -41,7 +41,7 @@ mongo::DBClientConnection* getDBConn()
 
 bool dbCheckError()
 {
-    auto err = getDBConn()->getLastError();
+    auto err = MONGO_TIMED("", "getLastError", getDBConn()->getLastError());
     if (err.size())
     {
         LOG(ERROR) << err;
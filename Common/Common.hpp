@@ -17,12 +17,15 @@
 #pragma once
  
 #include <mongo/client/dbclient.h>
+#include <cstdint>
 #include <sstream>
 
-#include "Internal/easylogging++.h"
+#include "Internal/Logging.hpp"
 #include "Internal/EncodingUtility.hpp"
 #include "Internal/StringFuncUtil.hpp"
 #include "Internal/Config.hpp"
+#include "Format.hpp"
+#include "Metrics.hpp"
  
 /********** Mongo Exception Handler Wrapper **********/
 
@@ -33,27 +36,52 @@
     } \
     catch (const mongo::DBException &e) \
     { \
+        METRIC_DB_ERROR(); \
         LOG(ERROR) << e.what(); \
     } \
     catch (const std::exception& e) \
     { \
+        METRIC_DB_ERROR(); \
         LOG(ERROR) << e.what(); \
     } \
     catch (...) \
     { \
+        METRIC_DB_ERROR(); \
         LOG(ERROR) << "Unknown error."; \
     } \
     do {} while (false)
 
-#define STR(x) ((dynamic_cast<std::ostringstream&>( \
-    std::ostringstream() << x)).str())
-#define CSTR(x) ((dynamic_cast<std::ostringstream&>( \
-    std::ostringstream() << x)).str().c_str())
+/**
+ * Evaluate a database call and record its latency under the collection
+ * and operation name. Costs nothing beyond a flag check until /metrics
+ * is scraped.
+ */
+#define MONGO_TIMED(collection, op, ...) \
+    ([&]() { \
+        METRIC_DB_TIMER(collection, op); \
+        return __VA_ARGS__; \
+    }())
 
 namespace swcu {
 
 mongo::DBClientConnection*  getDBConn();
 bool                        dbCheckError();
 
+/**
+ * Hashes the 12 bytes of an ObjectId, so containers can be keyed by it
+ * without formatting it as a string.
+ */
+struct OIDHash
+{
+    size_t          operator()(const mongo::OID& oid) const
+    {
+        // FNV-1a.
+        const unsigned char* data = oid.getData();
+        uint32_t h = 2166136261u;
+        for(int i = 0; i < 12; ++i) h = (h ^ data[i]) * 16777619u;
+        return h;
+    }
+};
+
 
 }
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "Internal/EncodingUtility.hpp"
+
+namespace swcu {
+
+/**
+ * Immutable text known in both GBK, which the game speaks, and UTF-8,
+ * which the database and the web speak. Made from either one, the other
+ * is converted on first use and kept, so it's converted at most once
+ * however often it's asked for. Copies share the text, and may be read
+ * from several threads.
+ */
+class DualString
+{
+protected:
+    struct Text
+    {
+        std::string     gbk;
+        std::string     utf8;
+        bool            fromGBK;
+        std::once_flag  converted;
+    };
+
+    std::shared_ptr<Text>   mText;
+
+public:
+                        DualString() {}
+
+    static  DualString  fromGBK(const std::string& gbk)
+    {
+        DualString str;
+        str.mText = std::make_shared<Text>();
+        str.mText->gbk = gbk;
+        str.mText->fromGBK = true;
+        return str;
+    }
+    static  DualString  fromUTF8(const std::string& utf8)
+    {
+        DualString str;
+        str.mText = std::make_shared<Text>();
+        str.mText->utf8 = utf8;
+        str.mText->fromGBK = false;
+        return str;
+    }
+
+            const std::string& gbk() const
+            { return _get(false); }
+            const std::string& utf8() const
+            { return _get(true); }
+            bool        empty() const
+            { return !mText || (mText->fromGBK ?
+                mText->gbk.empty() : mText->utf8.empty()); }
+
+protected:
+            const std::string& _get(bool utf8) const
+    {
+        static const std::string none;
+        if(!mText) return none;
+        Text& text = *mText;
+        if(text.fromGBK != utf8) return utf8 ? text.utf8 : text.gbk;
+        std::call_once(text.converted, [&text]() {
+            if(text.fromGBK) text.utf8 = GBKToUTF8(text.gbk);
+            else text.gbk = UTF8ToGBK(text.utf8);
+        });
+        return utf8 ? text.utf8 : text.gbk;
+    }
+};
+
+/**
+ * Writes the GBK text, as the game and the logs take it.
+ */
+inline std::ostream& operator<<(std::ostream& os, const DualString& str)
+{
+    return os << str.gbk();
+}
+
+}
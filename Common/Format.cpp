@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+
+#include "Format.hpp"
+
+namespace swcu {
+
+void FormatSink::write(int64_t value)
+{
+    if(value >= 0)
+    {
+        write(static_cast<uint64_t>(value));
+        return;
+    }
+    write('-');
+    // Negating the smallest value overflows, go through unsigned.
+    write(uint64_t(0) - static_cast<uint64_t>(value));
+}
+
+void FormatSink::write(uint64_t value)
+{
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do
+    {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while(value != 0);
+    append(p, digits + sizeof(digits) - p);
+}
+
+void FormatSink::write(double value)
+{
+    // Same as the default of streams.
+    char text[32];
+    int size = snprintf(text, sizeof(text), "%g", value);
+    if(size > 0) append(text, size);
+}
+
+void FormatSink::format(const char* fmt, const Arg* args, size_t count)
+{
+    const char* literal = fmt;
+    size_t next = 0;
+    for(const char* p = fmt; *p != '\0'; ++p)
+    {
+        if(p[0] != '{' || p[1] != '}') continue;
+        append(literal, p - literal);
+        if(next < count)
+        {
+            args[next].write(*this, args[next].value);
+            ++next;
+        }
+        literal = ++p + 1;
+    }
+    append(literal, strlen(literal));
+}
+
+void FormatSink::_spill(const char* str, size_t size)
+{
+    if(!mSpilled)
+    {
+        mSpill.reserve(mSize + size + mCapacity);
+        mSpill.assign(mBuffer, mSize);
+        mSpilled = true;
+    }
+    mSpill.append(str, size);
+}
+
+}
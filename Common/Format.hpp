@@ -0,0 +1,241 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "../Utility/StringRef.hpp"
+
+/**
+ * Format text into a buffer on the stack, replacing each {} in fmt, which
+ * must be a string literal, with the next argument. The number of {} is
+ * checked against the arguments when compiling. Other braces, such as
+ * color embeddings like {FFFFFF}, are kept as they are.
+ * The result lives until the end of the full expression:
+ *     SendClientMessage(id, color, FORMAT("{} has ${}", name, money).c_str());
+ * fmt alone, without arguments, is accepted too.
+ */
+#define FORMAT(...) \
+    ::swcu::Formatted<>(::swcu::PlaceholderCount< \
+        ::swcu::countPlaceholders(SWCU_FORMAT_FIRST(__VA_ARGS__, 0))>(), \
+        __VA_ARGS__)
+// Always given a second argument, so that fmt alone is valid C++11.
+#define SWCU_FORMAT_FIRST(fmt, ...) fmt
+
+namespace swcu {
+
+constexpr size_t countPlaceholders(const char* fmt)
+{
+    size_t count = 0;
+    for(size_t i = 0; fmt[i] != '\0'; ++i)
+    {
+        if(fmt[i] == '{' && fmt[i + 1] == '}')
+        {
+            ++count;
+            ++i;
+        }
+    }
+    return count;
+}
+
+/**
+ * Number of placeholders FORMAT counted in its format string.
+ */
+template<size_t Count>
+struct PlaceholderCount
+{
+};
+
+/**
+ * Text being formatted. Kept in the buffer it's given while it fits,
+ * then moved to the heap.
+ */
+class FormatSink
+{
+protected:
+    char*               mBuffer;
+    size_t              mCapacity;
+    size_t              mSize;
+    std::string         mSpill;
+    bool                mSpilled;
+
+public:
+                        FormatSink(char* buffer, size_t capacity) :
+                            mBuffer(buffer), mCapacity(capacity),
+                            mSize(0), mSpilled(false)
+                        { mBuffer[0] = '\0'; }
+                        FormatSink(const FormatSink&) = delete;
+            FormatSink& operator=(const FormatSink&) = delete;
+
+            void        append(const char* str, size_t size)
+    {
+        if(!mSpilled && mSize + size < mCapacity)
+        {
+            memcpy(mBuffer + mSize, str, size);
+            mSize += size;
+            mBuffer[mSize] = '\0';
+            return;
+        }
+        _spill(str, size);
+    }
+
+            void        write(const char* str)
+            { append(str, strlen(str)); }
+            void        write(const std::string& str)
+            { append(str.data(), str.size()); }
+            void        write(StringRef str)
+            { append(str.data(), str.size()); }
+            void        write(char c)               { append(&c, 1); }
+            void        write(int64_t value);
+            void        write(uint64_t value);
+            void        write(double value);
+
+            const char* c_str() const
+            { return mSpilled ? mSpill.c_str() : mBuffer; }
+            size_t      size() const
+            { return mSpilled ? mSpill.size() : mSize; }
+            std::string str() const
+            { return std::string(c_str(), size()); }
+
+    /**
+     * Fill in fmt with count arguments.
+     */
+    struct Arg
+    {
+        void            (*write)(FormatSink& sink, const void* value);
+        const void*     value;
+    };
+            void        format(const char* fmt, const Arg* args,
+                size_t count);
+
+protected:
+            void        _spill(const char* str, size_t size);
+};
+
+namespace format_detail {
+
+template<typename T, typename Enable = void>
+struct Writer;
+
+template<typename T>
+struct Writer<T, typename std::enable_if<
+    std::is_integral<T>::value && !std::is_same<T, char>::value &&
+    !std::is_same<T, bool>::value>::type>
+{
+    static  void        write(FormatSink& sink, const void* value)
+    {
+        const T& v = *static_cast<const T*>(value);
+        if(std::is_signed<T>::value) sink.write(static_cast<int64_t>(v));
+        else sink.write(static_cast<uint64_t>(v));
+    }
+};
+
+template<typename T>
+struct Writer<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+    static  void        write(FormatSink& sink, const void* value)
+    {
+        typedef typename std::underlying_type<T>::type Underlying;
+        Underlying v = static_cast<Underlying>(*static_cast<const T*>(value));
+        Writer<Underlying>::write(sink, &v);
+    }
+};
+
+template<typename T>
+struct Writer<T, typename std::enable_if<
+    std::is_floating_point<T>::value>::type>
+{
+    static  void        write(FormatSink& sink, const void* value)
+    {
+        sink.write(static_cast<double>(*static_cast<const T*>(value)));
+    }
+};
+
+template<typename T>
+struct Writer<T, typename std::enable_if<
+    std::is_same<T, char>::value ||
+    std::is_same<T, std::string>::value ||
+    std::is_same<T, StringRef>::value>::type>
+{
+    static  void        write(FormatSink& sink, const void* value)
+    {
+        sink.write(*static_cast<const T*>(value));
+    }
+};
+
+template<typename T>
+struct Writer<T, typename std::enable_if<
+    std::is_same<T, const char*>::value ||
+    std::is_same<T, char*>::value>::type>
+{
+    static  void        write(FormatSink& sink, const void* value)
+    {
+        sink.write(*static_cast<const char* const*>(value));
+    }
+};
+
+inline void writeArray(FormatSink& sink, const void* value)
+{
+    sink.write(static_cast<const char*>(value));
+}
+
+template<typename T>
+FormatSink::Arg makeArg(const T& value, std::false_type /* isArray */)
+{
+    return { &Writer<T>::write, &value };
+}
+
+/**
+ * Character arrays, mostly string literals.
+ */
+template<typename T>
+FormatSink::Arg makeArg(const T& value, std::true_type /* isArray */)
+{
+    return { &writeArray, value };
+}
+
+}
+
+/**
+ * Result of FORMAT, holding up to Size - 1 characters without touching
+ * the heap. SA-MP caps a client message at 144.
+ */
+template<size_t Size = 256>
+class Formatted : public FormatSink
+{
+protected:
+    char                mStorage[Size];
+
+public:
+    template<size_t Count, typename...Args>
+                        Formatted(PlaceholderCount<Count>, const char* fmt,
+                            const Args&...args) :
+                            FormatSink(mStorage, Size)
+    {
+        static_assert(Count == sizeof...(Args),
+            "The number of {} doesn't match the number of arguments.");
+        const FormatSink::Arg list[sizeof...(Args) + 1] = {
+            format_detail::makeArg(args, std::is_array<Args>())...
+        };
+        format(fmt, list, sizeof...(Args));
+    }
+};
+
+}
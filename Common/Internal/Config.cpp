@@ -29,5 +29,33 @@ std::string Config::colNameGangZone     = "swcu2.gangzone";
 std::string Config::colNameEventLog     = "swcu2.eventlog";
 int         Config::webServerPort       = 8081;
 size_t      Config::webServerThread     = 4;
+std::string Config::webRoot             = "web/";
+int         Config::webAssetMaxAge      = 3600;
+int         Config::webAssetRescanInterval = 5;
+int         Config::serverTickInterval  = 50;
+int         Config::webEventStreamInterval = 200;
+float       Config::webEventStreamMoveThreshold = 0.5f;
+int         Config::webEventStreamHeartbeat = 15;
+size_t      Config::webEventStreamMaxClients = 32;
+size_t      Config::mapImportBatchSize  = 256;
+size_t      Config::mapImportMaxItems   = 20000;
+int         Config::schedulerTickBudget = 5000;
+int         Config::playerGodModeInterval = 500;
+int         Config::playerPrisonCheckInterval = 1000;
+float       Config::playerGridCellSize  = 50.0f;
+float       Config::playerGridMoveThreshold = 1.0f;
+int         Config::chatDefaultChannel  = 3; // CHAT_GLOBAL
+float       Config::chatLocalRadius     = 30.0f;
+double      Config::chatRate            = 1.0;
+double      Config::chatBurst           = 4.0;
+size_t      Config::dialogPageSize      = 20;
+size_t      Config::dialogMaxBytes      = 4000;
+std::string Config::journalPath         = "";
+std::string Config::logPath             = "logs/swcu.log";
+size_t      Config::logRingSize         = 64 * 1024;
+int         Config::logFlushInterval    = 100;
+size_t      Config::logMaxFileSize      = 16 * 1024 * 1024;
+size_t      Config::logMaxFiles         = 5;
+bool        Config::logToConsole        = true;
 
 }
@@ -33,6 +33,42 @@ struct Config
     static std::string  colNameEventLog;
     static int          webServerPort;
     static size_t       webServerThread;
+    static std::string  webRoot;
+    static int          webAssetMaxAge;
+    static int          webAssetRescanInterval;
+    static int          serverTickInterval;
+    static int          webEventStreamInterval;
+    static float        webEventStreamMoveThreshold;
+    static int          webEventStreamHeartbeat;
+    static size_t       webEventStreamMaxClients;
+    static size_t       mapImportBatchSize;
+    static size_t       mapImportMaxItems;
+    // Time the scheduler may spend per tick, in us.
+    static int          schedulerTickBudget;
+    // Periodic duties of players, in ms.
+    static int          playerGodModeInterval;
+    static int          playerPrisonCheckInterval;
+    // Grid of player positions, in game units.
+    static float        playerGridCellSize;
+    static float        playerGridMoveThreshold;
+    // Chat, see ChatManager.
+    static int          chatDefaultChannel;
+    static float        chatLocalRadius;
+    // Messages per second, and how many may be sent at once.
+    static double       chatRate;
+    static double       chatBurst;
+    // Items per page of paged list dialogs, and the most text one may show.
+    static size_t       dialogPageSize;
+    static size_t       dialogMaxBytes;
+    // Journal of callbacks for offline replay, not recorded if empty.
+    static std::string  journalPath;
+    // Log file, see AsyncLog. Sizes in bytes, the interval in ms.
+    static std::string  logPath;
+    static size_t       logRingSize;
+    static int          logFlushInterval;
+    static size_t       logMaxFileSize;
+    static size_t       logMaxFiles;
+    static bool         logToConsole;
 };
 
 }
@@ -14,11 +14,16 @@
  * limitations under the License.
  */
 
+#include <cstdint>
+#include <cstring>
 #include <iconv.h>
-#include <memory>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "sha1.h"
 #include "EncodingUtility.hpp"
-#include "easylogging++.h"
+#include "Logging.hpp"
 
 namespace swcu {
 
@@ -31,64 +36,299 @@ std::string sha1(const std::string& src)
     return hexstring;
 }
 
+namespace {
+
 /**
- * From http://my.oschina.net/xiaot99/blog/204041
+ * iconv descriptors opened by this thread, reset before each use.
  */
-int convert(const char *from_charset, const char *to_charset,
-    char *inbuf, size_t inlen, char *outbuf, size_t outlen)
+class IconvCache
 {
-    iconv_t     cd;
-    char        **pin   = &inbuf;
-    char        **pout  = &outbuf;
+protected:
+    struct Entry
+    {
+        std::string     from;
+        std::string     to;
+        iconv_t         cd;
+    };
 
-    cd = iconv_open(to_charset, from_charset);
-    if(cd == 0)
+    std::vector<Entry>  mEntries;
+
+public:
+    ~IconvCache()
+    {
+        for(auto& e : mEntries) iconv_close(e.cd);
+    }
+
+    iconv_t get(const char *from, const char *to)
+    {
+        for(auto& e : mEntries)
+        {
+            if(e.from != from || e.to != to) continue;
+            iconv(e.cd, nullptr, nullptr, nullptr, nullptr);
+            return e.cd;
+        }
+        iconv_t cd = iconv_open(to, from);
+        if(cd != reinterpret_cast<iconv_t>(-1))
+        {
+            mEntries.push_back({ from, to, cd });
+        }
+        return cd;
+    }
+};
+
+thread_local IconvCache iconvCache;
+
+// Double-byte GBK: lead byte 0x81-0xFE, trail byte 0x40-0xFE.
+const int GBK_LEADS     = 0xFE - 0x81 + 1;
+const int GBK_TRAILS    = 0xFE - 0x40 + 1;
+
+/**
+ * Both directions of GBK for the Basic Multilingual Plane, taken from
+ * iconv once so the results are the same as asking iconv.
+ * Characters outside of the tables are left to iconv.
+ */
+struct GBKTables
+{
+    // Code point of each double-byte character, 0 if unmapped.
+    uint16_t            toUnicode[GBK_LEADS * GBK_TRAILS];
+    // GBK of each code point, 0 if unmapped, below 0x100 if single-byte.
+    uint16_t            fromUnicode[0x10000];
+
+    GBKTables()
+    {
+        memset(toUnicode, 0, sizeof(toUnicode));
+        memset(fromUnicode, 0, sizeof(fromUnicode));
+        iconv_t cd = iconv_open("UTF-16LE", "GBK");
+        if(cd == reinterpret_cast<iconv_t>(-1))
+        {
+            LOG(ERROR) << "GBK isn't supported by iconv.";
+            return;
+        }
+        for(int lead = 0; lead < GBK_LEADS; ++lead)
+        {
+            for(int trail = 0; trail < GBK_TRAILS; ++trail)
+            {
+                char in[2] = { char(0x81 + lead), char(0x40 + trail) };
+                unsigned char out[4];
+                char *pin = in, *pout = reinterpret_cast<char*>(out);
+                size_t inlen = 2, outlen = 4;
+                iconv(cd, nullptr, nullptr, nullptr, nullptr);
+                if(iconv(cd, &pin, &inlen, &pout, &outlen) ==
+                    static_cast<size_t>(-1) || outlen != 2)
+                {
+                    continue;
+                }
+                uint16_t u = out[0] | (out[1] << 8);
+                toUnicode[lead * GBK_TRAILS + trail] = u;
+            }
+        }
+        iconv_close(cd);
+        cd = iconv_open("GBK", "UTF-16LE");
+        if(cd == reinterpret_cast<iconv_t>(-1)) return;
+        for(uint32_t u = 0x80; u < 0x10000; ++u)
+        {
+            if(u >= 0xD800 && u <= 0xDFFF) continue;
+            char in[2] = { char(u & 0xFF), char(u >> 8) };
+            unsigned char out[4];
+            char *pin = in, *pout = reinterpret_cast<char*>(out);
+            size_t inlen = 2, outlen = 4;
+            iconv(cd, nullptr, nullptr, nullptr, nullptr);
+            if(iconv(cd, &pin, &inlen, &pout, &outlen) ==
+                static_cast<size_t>(-1))
+            {
+                continue;
+            }
+            if(outlen == 3) fromUnicode[u] = out[0];
+            else if(outlen == 2) fromUnicode[u] = (out[0] << 8) | out[1];
+        }
+        iconv_close(cd);
+    }
+};
+
+const GBKTables& getGBKTables()
+{
+    // Built by the first caller, safely across threads.
+    static const GBKTables tables;
+    return tables;
+}
+
+/**
+ * Length of the run of ASCII characters at the start of src.
+ */
+size_t asciiPrefix(const char *src, size_t len)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(src + i));
+        int high = _mm_movemask_epi8(chunk);
+        if(high != 0) return i + __builtin_ctz(high);
+    }
+#endif
+    for(; i + 8 <= len; i += 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, src + i, 8);
+        if(chunk & 0x8080808080808080ULL) break;
+    }
+    while(i < len && (src[i] & 0x80) == 0) ++i;
+    return i;
+}
+
+size_t tableGBKToUTF8(const char *src, size_t len, char *out, size_t outlen)
+{
+    const GBKTables& tables = getGBKTables();
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(src);
+    size_t i = 0, o = 0;
+    while(true)
+    {
+        size_t run = asciiPrefix(src + i, len - i);
+        if(outlen - o < run) return CONVERT_FAILED;
+        memcpy(out + o, src + i, run);
+        i += run;
+        o += run;
+        if(i == len) return o;
+        if(i + 1 == len || in[i] < 0x81 || in[i] > 0xFE ||
+            in[i + 1] < 0x40 || in[i + 1] > 0xFE)
+        {
+            return CONVERT_FAILED;
+        }
+        uint32_t u = tables.toUnicode[
+            (in[i] - 0x81) * GBK_TRAILS + (in[i + 1] - 0x40)];
+        if(u == 0) return CONVERT_FAILED;
+        i += 2;
+        if(u < 0x800)
+        {
+            if(outlen - o < 2) return CONVERT_FAILED;
+            out[o++] = char(0xC0 | (u >> 6));
+        }
+        else
+        {
+            if(outlen - o < 3) return CONVERT_FAILED;
+            out[o++] = char(0xE0 | (u >> 12));
+            out[o++] = char(0x80 | ((u >> 6) & 0x3F));
+        }
+        out[o++] = char(0x80 | (u & 0x3F));
+    }
+}
+
+size_t tableUTF8ToGBK(const char *src, size_t len, char *out, size_t outlen)
+{
+    const GBKTables& tables = getGBKTables();
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(src);
+    size_t i = 0, o = 0;
+    while(true)
+    {
+        size_t run = asciiPrefix(src + i, len - i);
+        if(outlen - o < run) return CONVERT_FAILED;
+        memcpy(out + o, src + i, run);
+        i += run;
+        o += run;
+        if(i == len) return o;
+        // Two or three bytes for the plane GBK is in, anything else is
+        // left to iconv.
+        uint32_t u;
+        if(in[i] >= 0xC2 && in[i] <= 0xDF)
+        {
+            if(i + 1 >= len || (in[i + 1] & 0xC0) != 0x80)
+            {
+                return CONVERT_FAILED;
+            }
+            u = ((in[i] & 0x1F) << 6) | (in[i + 1] & 0x3F);
+            i += 2;
+        }
+        else if(in[i] >= 0xE0 && in[i] <= 0xEF)
+        {
+            if(i + 2 >= len || (in[i + 1] & 0xC0) != 0x80 ||
+                (in[i + 2] & 0xC0) != 0x80)
+            {
+                return CONVERT_FAILED;
+            }
+            u = ((in[i] & 0x0F) << 12) | ((in[i + 1] & 0x3F) << 6) |
+                (in[i + 2] & 0x3F);
+            // Overlong forms and surrogates.
+            if(u < 0x800 || (u >= 0xD800 && u <= 0xDFFF))
+            {
+                return CONVERT_FAILED;
+            }
+            i += 3;
+        }
+        else
+        {
+            return CONVERT_FAILED;
+        }
+        uint16_t gbk = tables.fromUnicode[u];
+        if(gbk == 0) return CONVERT_FAILED;
+        if(gbk < 0x100)
+        {
+            if(outlen - o < 1) return CONVERT_FAILED;
+            out[o++] = char(gbk);
+        }
+        else
+        {
+            if(outlen - o < 2) return CONVERT_FAILED;
+            out[o++] = char(gbk >> 8);
+            out[o++] = char(gbk & 0xFF);
+        }
+    }
+}
+
+}
+
+size_t convert(const char *from_charset, const char *to_charset,
+    const char *inbuf, size_t inlen, char *outbuf, size_t outlen)
+{
+    iconv_t cd = iconvCache.get(from_charset, to_charset);
+    if(cd == reinterpret_cast<iconv_t>(-1))
     {
         LOG(ERROR) << "Can't convert from " << from_charset << " to "
             << to_charset << ".";
-        return -1;
+        return CONVERT_FAILED;
     }
-    memset(outbuf, 0, outlen);
-    if(iconv(cd, pin, &inlen, pout, &outlen) == static_cast<size_t>(-1))
+    char        *pin    = const_cast<char*>(inbuf);
+    char        *pout   = outbuf;
+    size_t      left    = outlen;
+    if(iconv(cd, &pin, &inlen, &pout, &left) == static_cast<size_t>(-1))
     {
         LOG(ERROR) << "Convertion from " << from_charset << " to "
             << to_charset << " failed.";
-        return -1;
+        return CONVERT_FAILED;
     }
-    iconv_close(cd);
-    return 0;
+    return outlen - left;
+}
+
+size_t GBKToUTF8(const char *src, size_t len, char *out, size_t outlen)
+{
+    size_t r = tableGBKToUTF8(src, len, out, outlen);
+    if(r != CONVERT_FAILED) return r;
+    return convert("GBK", "UTF-8", src, len, out, outlen);
+}
+
+size_t UTF8ToGBK(const char *src, size_t len, char *out, size_t outlen)
+{
+    size_t r = tableUTF8ToGBK(src, len, out, outlen);
+    if(r != CONVERT_FAILED) return r;
+    return convert("UTF-8", "GBK", src, len, out, outlen);
 }
 
 std::string GBKToUTF8(const std::string& src)
 {
-    size_t len = src.size();
-    std::unique_ptr<char[]> srcCopy(new char[len + 1]);
-    std::unique_ptr<char[]> dest(new char[len * 3 + 1]);
-    memset(dest.get(), 0, sizeof(*dest.get()));
-    memcpy(srcCopy.get(), src.c_str(), len + 1);
-    int r = convert("GBK", "UTF-8", srcCopy.get(), len + 1, dest.get(), len*3+1);
-    std::string retStr;
-    if(r == 0)
-    {
-        retStr = dest.get();
-    }
-    return retStr;
+    std::string dest(src.size() * 3, '\0');
+    size_t r = GBKToUTF8(src.data(), src.size(), &dest[0], dest.size());
+    if(r == CONVERT_FAILED) return std::string();
+    dest.resize(r);
+    return dest;
 }
 
 std::string UTF8ToGBK(const std::string& src)
 {
-    size_t len = src.size();
-    std::unique_ptr<char[]> srcCopy(new char[len + 1]);
-    std::unique_ptr<char[]> dest(new char[len + 1]);
-    memset(dest.get(), 0, sizeof(*dest.get()));
-    memcpy(srcCopy.get(), src.c_str(), len + 1);
-    int r = convert("UTF-8", "GBK", srcCopy.get(), len + 1, dest.get(), len + 1);
-    std::string retStr;
-    if(r == 0)
-    {
-        retStr = dest.get();
-    }
-    return retStr;
+    std::string dest(src.size(), '\0');
+    size_t r = UTF8ToGBK(src.data(), src.size(), &dest[0], dest.size());
+    if(r == CONVERT_FAILED) return std::string();
+    dest.resize(r);
+    return dest;
 }
 
 }
@@ -22,8 +22,29 @@ namespace swcu {
 
 std::string sha1(const std::string& src);
 
-int convert(char *from_charset, char *to_charset,
-    char *inbuf, size_t inlen, char *outbuf, size_t outlen);
+/**
+ * Returned by the conversions below on failure.
+ */
+const size_t CONVERT_FAILED = static_cast<size_t>(-1);
+
+/**
+ * Convert with iconv, whose descriptors are kept per thread.
+ * @return Bytes written to outbuf, not NUL terminated, or CONVERT_FAILED.
+ */
+size_t convert(const char *from_charset, const char *to_charset,
+    const char *inbuf, size_t inlen, char *outbuf, size_t outlen);
+
+/**
+ * Convert len bytes of src into out of outlen bytes, not NUL terminated.
+ * The result takes at most 3 * len bytes in UTF-8 and len bytes in GBK.
+ * @return Bytes written, or CONVERT_FAILED if src isn't valid or out is
+ * too small.
+ */
+size_t GBKToUTF8(const char *src, size_t len, char *out, size_t outlen);
+size_t UTF8ToGBK(const char *src, size_t len, char *out, size_t outlen);
+/**
+ * @return The converted text, or an empty string on failure.
+ */
 std::string GBKToUTF8(const std::string& src);
 std::string UTF8ToGBK(const std::string& src);
 
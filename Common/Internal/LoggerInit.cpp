@@ -14,6 +14,6 @@
  * limitations under the License.
  */
 
-#include "easylogging++.h"
+#include "Logging.hpp"
 
 _INITIALIZE_EASYLOGGINGPP
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/**
+ * Least severe level compiled in, levels below it turn LOG() into a
+ * writer which does nothing and is optimized away:
+ *   0 everything (debug only without NDEBUG), 1 info, 2 warning,
+ *   3 error, 4 fatal.
+ * Set for the whole build, e.g. -DSWCU_LOG_MIN_LEVEL=2.
+ */
+#ifndef SWCU_LOG_MIN_LEVEL
+#define SWCU_LOG_MIN_LEVEL 0
+#endif
+
+#if SWCU_LOG_MIN_LEVEL > 0
+#define _ELPP_DISABLE_DEBUG_LOGS
+#define _ELPP_DISABLE_TRACE_LOGS
+#define _ELPP_DISABLE_VERBOSE_LOGS
+#endif
+#if SWCU_LOG_MIN_LEVEL > 1
+#define _ELPP_DISABLE_INFO_LOGS
+#endif
+#if SWCU_LOG_MIN_LEVEL > 2
+#define _ELPP_DISABLE_WARNING_LOGS
+#endif
+#if SWCU_LOG_MIN_LEVEL > 3
+#define _ELPP_DISABLE_ERROR_LOGS
+#endif
+
+#include "easylogging++.h"
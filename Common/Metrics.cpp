@@ -0,0 +1,252 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iomanip>
+#include <sstream>
+
+#include "Metrics.hpp"
+
+namespace swcu {
+
+std::atomic<bool> Metrics::sActive(false);
+
+Histogram::Histogram() : mCount(0), mSum(0)
+{
+    for(auto& i : mBuckets)
+    {
+        i.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t Histogram::bucketOf(uint64_t us)
+{
+    if(us < SUB_BUCKETS) return us;
+    size_t msb = 63 - __builtin_clzll(us);
+    size_t sub = (us >> (msb - 2)) & (SUB_BUCKETS - 1);
+    size_t bucket = (msb - 1) * SUB_BUCKETS + sub;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t bucket)
+{
+    if(bucket < SUB_BUCKETS) return bucket + 1;
+    size_t msb = bucket / SUB_BUCKETS + 1;
+    size_t sub = bucket % SUB_BUCKETS;
+    return (uint64_t(1) << msb) + (sub + 1) * (uint64_t(1) << (msb - 2));
+}
+
+void Histogram::record(uint64_t us)
+{
+    mBuckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(us, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double q) const
+{
+    uint64_t total = count();
+    if(total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+    if(rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for(size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += bucket(i);
+        if(seen >= rank) return bucketUpperBound(i);
+    }
+    return bucketUpperBound(BUCKET_COUNT - 1);
+}
+
+namespace {
+
+template<typename T, typename Map>
+T& findOrCreate(Map& families, const std::string& name,
+    const std::string& labels, const char* help)
+{
+    auto& family = families[name];
+    if(family.help.empty() && help != nullptr)
+    {
+        family.help = help;
+    }
+    auto& series = family.series[labels];
+    if(series == nullptr)
+    {
+        series.reset(new T());
+    }
+    return *series;
+}
+
+void writeHead(std::ostream& os, const std::string& name,
+    const std::string& help, const char* type)
+{
+    if(!help.empty())
+    {
+        os << "# HELP " << name << " " << help << "\n";
+    }
+    os << "# TYPE " << name << " " << type << "\n";
+}
+
+void writeSeries(std::ostream& os, const std::string& name,
+    const std::string& labels)
+{
+    os << name;
+    if(!labels.empty())
+    {
+        os << "{" << labels << "}";
+    }
+    os << " ";
+}
+
+}
+
+Counter& Metrics::counter(const std::string& name,
+    const std::string& labels, const char* help)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrCreate<Counter>(mCounters, name, labels, help);
+}
+
+Gauge& Metrics::gauge(const std::string& name,
+    const std::string& labels, const char* help)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrCreate<Gauge>(mGauges, name, labels, help);
+}
+
+Histogram& Metrics::histogram(const std::string& name,
+    const std::string& labels, const char* help)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrCreate<Histogram>(mHistograms, name, labels, help);
+}
+
+std::string Metrics::render()
+{
+    setActive(true);
+
+    std::ostringstream os;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for(auto& family : mCounters)
+    {
+        writeHead(os, family.first, family.second.help, "counter");
+        for(auto& i : family.second.series)
+        {
+            writeSeries(os, family.first, i.first);
+            os << i.second->value() << "\n";
+        }
+    }
+    for(auto& family : mGauges)
+    {
+        writeHead(os, family.first, family.second.help, "gauge");
+        for(auto& i : family.second.series)
+        {
+            writeSeries(os, family.first, i.first);
+            os << i.second->value() << "\n";
+        }
+    }
+    // Seconds with microsecond digits, so that bounds print exactly.
+    os << std::fixed << std::setprecision(6);
+    for(auto& family : mHistograms)
+    {
+        writeHead(os, family.first, family.second.help, "histogram");
+        const std::string& name = family.first;
+        for(auto& i : family.second.series)
+        {
+            const Histogram& h = *i.second;
+            std::string sep = i.first.empty() ? "" : ",";
+            // Only octave boundaries are exported; the sub-buckets serve
+            // percentile() without bloating every scrape. Values are whole
+            // microseconds, so the last one below the exclusive bound is
+            // the inclusive le. The last bucket also takes everything too
+            // large to fit, so it is only counted in +Inf.
+            uint64_t cumulative = 0;
+            for(size_t b = 0; b < Histogram::BUCKET_COUNT - 1; ++b)
+            {
+                cumulative += h.bucket(b);
+                if(b % Histogram::SUB_BUCKETS != Histogram::SUB_BUCKETS - 1)
+                    continue;
+                os << name << "_bucket{" << i.first << sep << "le=\"" <<
+                    (Histogram::bucketUpperBound(b) - 1) / 1e6 << "\"} " <<
+                    cumulative << "\n";
+            }
+            os << name << "_bucket{" << i.first << sep << "le=\"+Inf\"} " <<
+                h.count() << "\n";
+            writeSeries(os, name + "_sum", i.first);
+            os << h.sum() / 1e6 << "\n";
+            writeSeries(os, name + "_count", i.first);
+            os << h.count() << "\n";
+        }
+    }
+    return os.str();
+}
+
+std::string Metrics::label(const char* key, const std::string& value)
+{
+    std::string result = key;
+    result += "=\"";
+    for(char c : value)
+    {
+        if(c == '\\' || c == '"') result += '\\';
+        if(c == '\n')
+        {
+            result += "\\n";
+            continue;
+        }
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+DBOpSite::DBOpSite(const char* op) : mOp(op)
+{
+    for(auto& i : mEntries)
+    {
+        i.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+Histogram* DBOpSite::_lookup(const std::string& collection)
+{
+    Histogram* histogram = &Metrics::get().histogram("swcu_db_op_seconds",
+        Metrics::label("collection", collection) + "," +
+        Metrics::label("op", mOp),
+        "Latency of database operations.");
+    // Entries are never removed, so a slot taken by another thread only
+    // moves the search along; a full table leaves the lookup uncached.
+    std::unique_ptr<Entry> entry(new Entry { collection, histogram });
+    for(auto& i : mEntries)
+    {
+        Entry* expected = nullptr;
+        if(i.compare_exchange_strong(expected, entry.get(),
+            std::memory_order_release, std::memory_order_acquire))
+        {
+            entry.release();
+            break;
+        }
+        if(expected->collection == collection) break;
+    }
+    return histogram;
+}
+
+Counter& dbErrorCounter(const char* function)
+{
+    return Metrics::get().counter("swcu_db_errors_total",
+        Metrics::label("function", function),
+        "Exceptions raised by database operations.");
+}
+
+}
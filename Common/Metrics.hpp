@@ -0,0 +1,282 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../Utility/Singleton.hpp"
+
+namespace swcu {
+
+class Counter
+{
+protected:
+    std::atomic<uint64_t>   mValue;
+
+public:
+                    Counter() : mValue(0) {}
+
+            void    inc(uint64_t n = 1)
+    { mValue.fetch_add(n, std::memory_order_relaxed); }
+            uint64_t value() const
+    { return mValue.load(std::memory_order_relaxed); }
+};
+
+class Gauge
+{
+protected:
+    std::atomic<int64_t>    mValue;
+
+public:
+                    Gauge() : mValue(0) {}
+
+            void    set(int64_t v)
+    { mValue.store(v, std::memory_order_relaxed); }
+            void    add(int64_t n)
+    { mValue.fetch_add(n, std::memory_order_relaxed); }
+            int64_t value() const
+    { return mValue.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Latency histogram in microseconds with log-linear buckets: each power
+ * of two is split into 4 sub-buckets, so any recorded value is known
+ * within 25%. The last bucket ends at 2^28 us (about 268 s, four and a
+ * half minutes); larger values land in it too. Recording is a few relaxed
+ * atomic adds.
+ */
+class Histogram
+{
+public:
+    static const size_t SUB_BUCKETS     = 4;
+    static const size_t OCTAVES         = 27;
+    static const size_t BUCKET_COUNT    = SUB_BUCKETS * OCTAVES;
+
+protected:
+    std::atomic<uint64_t>   mBuckets[BUCKET_COUNT];
+    std::atomic<uint64_t>   mCount;
+    std::atomic<uint64_t>   mSum;
+
+public:
+                    Histogram();
+
+            void    record(uint64_t us);
+            uint64_t count() const
+    { return mCount.load(std::memory_order_relaxed); }
+            uint64_t sum() const
+    { return mSum.load(std::memory_order_relaxed); }
+            uint64_t bucket(size_t i) const
+    { return mBuckets[i].load(std::memory_order_relaxed); }
+
+    /**
+     * @param  q Quantile in [0, 1].
+     * @return   Upper bound of the bucket holding the quantile, in us.
+     */
+            uint64_t percentile(double q) const;
+
+    static  size_t  bucketOf(uint64_t us);
+    /**
+     * Exclusive upper bound of a bucket, in microseconds.
+     */
+    static  uint64_t bucketUpperBound(size_t bucket);
+};
+
+/**
+ * Registry of all metrics, rendered in the Prometheus text format.
+ *
+ * Metrics are identified by a name and a set of labels preformatted as
+ * 'key="value",...' (see label()). Registration takes a lock and is meant
+ * to happen once per call site, keeping the returned reference in a
+ * static; updates after that never lock. Registered metrics live until
+ * exit.
+ *
+ * Timers stay off until the first scrape, so an unscraped server doesn't
+ * even read the clock.
+ */
+class Metrics : public Singleton<Metrics>
+{
+protected:
+    template<typename T>
+    struct Family
+    {
+        std::string                                 help;
+        std::map<std::string, std::unique_ptr<T>>  series;
+    };
+
+    std::mutex                                  mMutex;
+    std::map<std::string, Family<Counter>>      mCounters;
+    std::map<std::string, Family<Gauge>>        mGauges;
+    std::map<std::string, Family<Histogram>>    mHistograms;
+
+    static  std::atomic<bool>                   sActive;
+
+protected:
+                    Metrics() {}
+    friend class Singleton<Metrics>;
+
+public:
+    virtual         ~Metrics() {}
+
+            Counter&    counter(const std::string& name,
+                const std::string& labels = "", const char* help = nullptr);
+            Gauge&      gauge(const std::string& name,
+                const std::string& labels = "", const char* help = nullptr);
+            Histogram&  histogram(const std::string& name,
+                const std::string& labels = "", const char* help = nullptr);
+
+    /**
+     * Render every metric. The first call switches timers on.
+     */
+            std::string render();
+
+    static  bool    isActive()
+    { return sActive.load(std::memory_order_relaxed); }
+    static  void    setActive(bool active)
+    { sActive.store(active, std::memory_order_relaxed); }
+
+    /**
+     * Format a label pair, escaping the value.
+     */
+    static  std::string label(const char* key, const std::string& value);
+};
+
+/**
+ * Record the lifetime of the scope in a histogram, if timers are on.
+ */
+class ScopedTimer
+{
+protected:
+    Histogram*                              mHistogram;
+    std::chrono::steady_clock::time_point   mStart;
+
+public:
+    explicit        ScopedTimer(Histogram& histogram) :
+        ScopedTimer(&histogram) {}
+    /**
+     * A null histogram makes the timer a no-op.
+     */
+    explicit        ScopedTimer(Histogram* histogram) :
+        mHistogram(Metrics::isActive() ? histogram : nullptr)
+    {
+        if(mHistogram != nullptr)
+        {
+            mStart = std::chrono::steady_clock::now();
+        }
+    }
+                    ~ScopedTimer()
+    {
+        if(mHistogram != nullptr)
+        {
+            mHistogram->record(std::chrono::duration_cast<
+                std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - mStart).count());
+        }
+    }
+
+                    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer&    operator=(const ScopedTimer&) = delete;
+};
+
+/**
+ * Histograms of one database call site, by collection. The operation is
+ * fixed per site and the collection mostly is too, so the first lookup of
+ * each collection is kept in a small table scanned without locking. Sites
+ * seeing more collections than it holds fall back to the registry.
+ */
+class DBOpSite
+{
+public:
+    static const size_t SLOTS           = 8;
+
+protected:
+    struct Entry
+    {
+        std::string collection;
+        Histogram*  histogram;
+    };
+
+    const char*                 mOp;
+    std::atomic<Entry*>         mEntries[SLOTS];
+
+            Histogram*  _lookup(const std::string& collection);
+
+public:
+    explicit        DBOpSite(const char* op);
+
+    /**
+     * Returns null while timers are off, so that the lookup is skipped as
+     * well.
+     */
+            Histogram*  histogram(const std::string& collection)
+    {
+        if(!Metrics::isActive()) return nullptr;
+        for(auto& i : mEntries)
+        {
+            Entry* entry = i.load(std::memory_order_acquire);
+            if(entry == nullptr) break;
+            if(entry->collection == collection) return entry->histogram;
+        }
+        return _lookup(collection);
+    }
+
+                    DBOpSite(const DBOpSite&) = delete;
+    DBOpSite&       operator=(const DBOpSite&) = delete;
+};
+
+/**
+ * Counter of exceptions caught by MONGO_WRAPPER in the given function.
+ */
+Counter&    dbErrorCounter(const char* function);
+
+}
+
+#define SWCU_METRIC_CONCAT_(a, b) a##b
+#define SWCU_METRIC_CONCAT(a, b) SWCU_METRIC_CONCAT_(a, b)
+
+/**
+ * Time the rest of the enclosing scope. The histogram is looked up once
+ * per call site.
+ */
+#define METRIC_SCOPED_TIMER(name, labels) \
+    static swcu::Histogram& SWCU_METRIC_CONCAT(_metricHist, __LINE__) = \
+        swcu::Metrics::get().histogram(name, labels); \
+    swcu::ScopedTimer SWCU_METRIC_CONCAT(_metricTimer, __LINE__)( \
+        SWCU_METRIC_CONCAT(_metricHist, __LINE__))
+
+/**
+ * Time a database operation for the rest of the enclosing scope. The op
+ * must be a literal, the histograms are cached per call site.
+ */
+#define METRIC_DB_TIMER(collection, op) \
+    static swcu::DBOpSite SWCU_METRIC_CONCAT(_metricDBSite, __LINE__)(op); \
+    swcu::ScopedTimer SWCU_METRIC_CONCAT(_metricDBTimer, __LINE__)( \
+        SWCU_METRIC_CONCAT(_metricDBSite, __LINE__).histogram(collection))
+
+/**
+ * Count a database error in the enclosing function, looking the counter
+ * up once per call site.
+ */
+#define METRIC_DB_ERROR() \
+    static swcu::Counter& SWCU_METRIC_CONCAT(_metricDBError, __LINE__) = \
+        swcu::dbErrorCounter(__func__); \
+    SWCU_METRIC_CONCAT(_metricDBError, __LINE__).inc()
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "Common.hpp"
+
+#include "Scheduler.hpp"
+
+namespace swcu {
+
+TimerWheel::TimerWheel() : mTick(0), mActive(0)
+{
+}
+
+TimerHandle TimerWheel::schedule(uint64_t delay, uint32_t interval,
+    Task task)
+{
+    uint32_t index;
+    if(mFree.empty())
+    {
+        index = static_cast<uint32_t>(mTimers.size());
+        mTimers.push_back(Timer());
+        mTimers.back().generation = 0;
+    }
+    else
+    {
+        index = mFree.back();
+        mFree.pop_back();
+    }
+    Timer& timer    = mTimers[index];
+    timer.expiry    = mTick + (delay > 0 ? delay : 1);
+    timer.interval  = interval;
+    timer.active    = true;
+    timer.task      = std::move(task);
+    ++mActive;
+    _place(index);
+    return TimerHandle((uint64_t(timer.generation) << 32) | (index + 1));
+}
+
+bool TimerWheel::cancel(TimerHandle handle)
+{
+    Timer* timer = _find(handle);
+    if(timer == nullptr) return false;
+    // It's unlinked from its slot when that comes up.
+    timer->active = false;
+    timer->task = nullptr;
+    --mActive;
+    return true;
+}
+
+bool TimerWheel::isPending(TimerHandle handle) const
+{
+    return const_cast<TimerWheel*>(this)->_find(handle) != nullptr;
+}
+
+void TimerWheel::advance()
+{
+    ++mTick;
+    // Bring down the coarser slots which start now.
+    for(size_t level = 1; level < LEVELS; ++level)
+    {
+        if((mTick & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0) break;
+        auto& slot = mWheels[level][(mTick >> (SLOT_BITS * level)) &
+            (SLOTS - 1)];
+        std::vector<uint32_t> timers;
+        timers.swap(slot);
+        for(uint32_t index : timers)
+        {
+            if(mTimers[index].active) _place(index);
+            else _release(index);
+        }
+    }
+    auto& slot = mWheels[0][mTick & (SLOTS - 1)];
+    for(uint32_t index : slot)
+    {
+        if(mTimers[index].active) mReady.push_back(index);
+        else _release(index);
+    }
+    slot.clear();
+}
+
+size_t TimerWheel::runReady(std::chrono::steady_clock::time_point deadline)
+{
+    bool first = true;
+    while(!mReady.empty())
+    {
+        if(!first && std::chrono::steady_clock::now() >= deadline) break;
+        first = false;
+
+        uint32_t index = mReady.front();
+        mReady.pop_front();
+        if(!mTimers[index].active)
+        {
+            _release(index);
+            continue;
+        }
+        // The task may schedule timers, which can move mTimers around.
+        Task task = std::move(mTimers[index].task);
+        bool again = task();
+        Timer& timer = mTimers[index];
+        if(!timer.active)
+        {
+            // Cancelled by the task itself.
+            _release(index);
+        }
+        else if(again && timer.interval > 0)
+        {
+            // Keep the rhythm, unless running late.
+            timer.expiry = std::max(timer.expiry + timer.interval,
+                mTick + 1);
+            timer.task = std::move(task);
+            _place(index);
+        }
+        else
+        {
+            timer.active = false;
+            --mActive;
+            _release(index);
+        }
+    }
+    return mReady.size();
+}
+
+TimerWheel::Timer* TimerWheel::_find(TimerHandle handle)
+{
+    uint64_t id = handle.getId();
+    uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFF);
+    if(index == 0 || index > mTimers.size()) return nullptr;
+    Timer& timer = mTimers[index - 1];
+    if(timer.generation != static_cast<uint32_t>(id >> 32) ||
+        !timer.active)
+    {
+        return nullptr;
+    }
+    return &timer;
+}
+
+void TimerWheel::_place(uint32_t index)
+{
+    uint64_t expiry = mTimers[index].expiry;
+    uint64_t delta  = expiry > mTick ? expiry - mTick : 0;
+    if(delta == 0)
+    {
+        mReady.push_back(index);
+        return;
+    }
+    for(size_t level = 0; level < LEVELS; ++level)
+    {
+        if(delta < (uint64_t(1) << (SLOT_BITS * (level + 1))))
+        {
+            mWheels[level][(expiry >> (SLOT_BITS * level)) & (SLOTS - 1)]
+                .push_back(index);
+            return;
+        }
+    }
+    // Further than the wheels reach, park it in the last slot of the top
+    // level; it's placed again from there.
+    uint64_t park = mTick + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+    mWheels[LEVELS - 1][(park >> (SLOT_BITS * (LEVELS - 1))) & (SLOTS - 1)]
+        .push_back(index);
+}
+
+void TimerWheel::_release(uint32_t index)
+{
+    Timer& timer = mTimers[index];
+    timer.task = nullptr;
+    // Outdates the handles given out for it.
+    ++timer.generation;
+    mFree.push_back(index);
+}
+
+TimerHandle Scheduler::after(int delay, std::function<void()> task)
+{
+    return mWheel.schedule(toTicks(delay), 0, [task]() {
+        task();
+        return false;
+    });
+}
+
+TimerHandle Scheduler::every(int interval, std::function<bool()> task,
+    int offset)
+{
+    return mWheel.schedule(toTicks(interval + offset), toTicks(interval),
+        std::move(task));
+}
+
+void Scheduler::tick()
+{
+    static Counter& spilled = Metrics::get().counter(
+        "swcu_scheduler_spilled_total", "",
+        "Timers put off to a later tick because the budget ran out, "
+        "each counted once however many ticks it waits.");
+    // Leftovers of the last tick run first, they're already queued.
+    size_t carried = mWheel.getReadyCount();
+    mWheel.advance();
+    size_t fresh = mWheel.getReadyCount() - carried;
+    size_t left = mWheel.runReady(std::chrono::steady_clock::now() +
+        std::chrono::microseconds(Config::schedulerTickBudget));
+    // The leftovers are at the front of the queue, so what is left is the
+    // timers due this tick first; only those weren't counted yet.
+    if(left > 0) spilled.inc(std::min(left, fresh));
+}
+
+uint32_t Scheduler::toTicks(int ms)
+{
+    int tick = Config::serverTickInterval > 0 ? Config::serverTickInterval : 1;
+    return ms <= 0 ? 1 : (ms + tick - 1) / tick;
+}
+
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "../Utility/Singleton.hpp"
+
+namespace swcu {
+
+/**
+ * Refers to a scheduled timer. Stays safe to use after the timer is gone;
+ * cancelling it then does nothing.
+ */
+class TimerHandle
+{
+protected:
+    // Slot index + 1 in the low half, generation in the high half.
+    uint64_t            mId;
+
+public:
+                        TimerHandle() : mId(0) {}
+    explicit            TimerHandle(uint64_t id) : mId(id) {}
+
+            bool        isNull() const              { return mId == 0; }
+            uint64_t    getId() const               { return mId; }
+};
+
+/**
+ * Hierarchical timer wheel counting in ticks, LEVELS wheels of SLOTS
+ * slots each, every level 64 times as coarse as the one below. Timers
+ * far away sit in a coarse wheel and move down as they come closer, so
+ * scheduling, cancelling and expiring are all O(1) amortized whatever
+ * the delay.
+ * Expired timers wait in a ready queue until run by runReady(), which
+ * may stop early and leave the rest for the next tick.
+ */
+class TimerWheel
+{
+public:
+    /**
+     * Returns true to run again after the interval of the timer.
+     */
+    typedef std::function<bool()> Task;
+
+    static const unsigned   SLOT_BITS   = 6;
+    static const size_t     SLOTS       = 1 << SLOT_BITS;
+    static const size_t     LEVELS      = 4;
+
+protected:
+    struct Timer
+    {
+        uint64_t        expiry;
+        uint32_t        interval;
+        uint32_t        generation;
+        bool            active;
+        Task            task;
+    };
+
+    // Timers by index, reused through mFree.
+    std::vector<Timer>                                      mTimers;
+    std::vector<uint32_t>                                   mFree;
+    std::array<std::array<std::vector<uint32_t>, SLOTS>, LEVELS> mWheels;
+    std::deque<uint32_t>                                    mReady;
+    uint64_t                                                mTick;
+    size_t                                                  mActive;
+
+public:
+                        TimerWheel();
+
+    /**
+     * Run task after delay ticks, at least one. With an interval, run it
+     * again every interval ticks for as long as it returns true.
+     */
+            TimerHandle schedule(uint64_t delay, uint32_t interval,
+                Task task);
+    /**
+     * @return False if the timer already ran out or was cancelled.
+     */
+            bool        cancel(TimerHandle handle);
+            bool        isPending(TimerHandle handle) const;
+
+    /**
+     * Advance by one tick, moving the timers due into the ready queue.
+     */
+            void        advance();
+    /**
+     * Run ready timers until the queue is empty or the deadline passed.
+     * At least one is run, so the queue always drains eventually.
+     * @return Number of timers left for the next time.
+     */
+            size_t      runReady(
+                std::chrono::steady_clock::time_point deadline);
+
+            uint64_t    getCurrentTick() const      { return mTick; }
+            size_t      getTimerCount() const       { return mActive; }
+            size_t      getReadyCount() const       { return mReady.size(); }
+
+protected:
+            Timer*      _find(TimerHandle handle);
+            void        _place(uint32_t index);
+            void        _release(uint32_t index);
+};
+
+/**
+ * Runs deferred and periodic work on the server thread, driven by the
+ * server tick. Delays are given in milliseconds and rounded up to whole
+ * ticks. Each tick runs for at most Config::schedulerTickBudget us; what
+ * doesn't fit is run first on the next tick.
+ */
+class Scheduler : public Singleton<Scheduler>
+{
+protected:
+    TimerWheel          mWheel;
+
+protected:
+                        Scheduler() {}
+    friend class Singleton<Scheduler>;
+
+public:
+    virtual             ~Scheduler() {}
+
+            TimerHandle after(int delay, std::function<void()> task);
+    /**
+     * Run task every interval ms, the first time after interval + offset
+     * ms, until it returns false or is cancelled. Offsets let many
+     * similar tasks be spread over different ticks.
+     */
+            TimerHandle every(int interval, std::function<bool()> task,
+                int offset = 0);
+            bool        cancel(TimerHandle handle)
+            { return mWheel.cancel(handle); }
+            bool        isPending(TimerHandle handle) const
+            { return mWheel.isPending(handle); }
+
+            void        tick();
+            size_t      getTimerCount() const
+            { return mWheel.getTimerCount(); }
+
+    static  uint32_t    toTicks(int ms);
+};
+
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "SpatialGrid.hpp"
+
+namespace swcu {
+
+namespace {
+
+float distanceSq(const kanko::Vector3& a, const kanko::Vector3& b)
+{
+    float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+}
+
+template<typename Func>
+void SpatialGrid::_visitCell(const CellKey& key, const kanko::Vector3& center,
+    float radiusSq, Func func) const
+{
+    auto iter = mCells.find(key);
+    if(iter == mCells.end()) return;
+    for(int id : iter->second)
+    {
+        float dSq = distanceSq(mEntries[id].pos, center);
+        if(dSq <= radiusSq) func(id, dSq);
+    }
+}
+
+template<typename Func>
+void SpatialGrid::_visitAll(const kanko::Vector3& center, float radiusSq,
+    int world, int interior, Func func) const
+{
+    for(size_t id = 0; id < mEntries.size(); ++id)
+    {
+        const Entry& entry = mEntries[id];
+        if(!entry.valid || entry.cell.world != world ||
+            entry.cell.interior != interior)
+        {
+            continue;
+        }
+        float dSq = distanceSq(entry.pos, center);
+        if(dSq <= radiusSq) func(static_cast<int>(id), dSq);
+    }
+}
+
+SpatialGrid::SpatialGrid(float cellSize, float moveThreshold) :
+    mCellSize(cellSize > 1.0f ? cellSize : 1.0f),
+    mThresholdSq(moveThreshold * moveThreshold), mSize(0)
+{
+}
+
+bool SpatialGrid::update(int id, const kanko::Vector3& pos,
+    int world, int interior)
+{
+    if(id < 0) return false;
+    if(static_cast<size_t>(id) >= mEntries.size())
+    {
+        Entry empty;
+        empty.valid = false;
+        mEntries.resize(id + 1, empty);
+    }
+    Entry& entry = mEntries[id];
+    if(entry.valid && entry.cell.world == world &&
+        entry.cell.interior == interior &&
+        distanceSq(entry.pos, pos) < mThresholdSq)
+    {
+        return false;
+    }
+    CellKey cell = _cellOf(pos, world, interior);
+    entry.pos = pos;
+    if(entry.valid && entry.cell == cell) return true;
+    if(entry.valid) _unlink(entry);
+    else ++mSize;
+    auto& ids   = mCells[cell];
+    entry.valid = true;
+    entry.cell  = cell;
+    entry.index = ids.size();
+    ids.push_back(id);
+    return true;
+}
+
+bool SpatialGrid::remove(int id)
+{
+    if(!contains(id)) return false;
+    Entry& entry = mEntries[id];
+    _unlink(entry);
+    entry.valid = false;
+    --mSize;
+    return true;
+}
+
+bool SpatialGrid::contains(int id) const
+{
+    return id >= 0 && static_cast<size_t>(id) < mEntries.size() &&
+        mEntries[id].valid;
+}
+
+void SpatialGrid::queryRadius(const kanko::Vector3& center, float radius,
+    int world, int interior, std::vector<int>& out) const
+{
+    float radiusSq = radius * radius;
+    auto collect = [&out](int id, float) { out.push_back(id); };
+    double side = 2.0 * std::ceil(radius / mCellSize) + 1.0;
+    if(_scanAll(side * side))
+    {
+        _visitAll(center, radiusSq, world, interior, collect);
+        return;
+    }
+    CellKey lo = _cellOf(kanko::Vector3(center.x - radius,
+        center.y - radius, 0.0f), world, interior);
+    CellKey hi = _cellOf(kanko::Vector3(center.x + radius,
+        center.y + radius, 0.0f), world, interior);
+    CellKey key = lo;
+    for(key.x = lo.x; key.x <= hi.x; ++key.x)
+    {
+        for(key.y = lo.y; key.y <= hi.y; ++key.y)
+        {
+            _visitCell(key, center, radiusSq, collect);
+        }
+    }
+}
+
+void SpatialGrid::queryNearest(const kanko::Vector3& center, size_t k,
+    float maxRadius, int world, int interior, std::vector<int>& out) const
+{
+    if(k == 0) return;
+    std::vector<std::pair<float, int>> found;
+    auto collect = [&found](int id, float dSq) {
+        found.emplace_back(dSq, id);
+    };
+    float maxRadiusSq = maxRadius * maxRadius;
+    // Grow rings of cells around the center. After ring r, whatever hasn't
+    // been seen is at least r cells away.
+    CellKey origin = _cellOf(center, world, interior);
+    int rings = static_cast<int>(std::ceil(maxRadius / mCellSize));
+    size_t visited = 0;
+    for(int r = 0; r <= rings; ++r)
+    {
+        visited += r == 0 ? 1 : 8 * r;
+        if(_scanAll(visited))
+        {
+            found.clear();
+            _visitAll(center, maxRadiusSq, world, interior, collect);
+            break;
+        }
+        CellKey key = origin;
+        for(int dx = -r; dx <= r; ++dx)
+        {
+            // Only the border of the square is new.
+            int step = (dx == -r || dx == r) ? 1 : 2 * r;
+            for(int dy = -r; dy <= r; dy += step)
+            {
+                key.x = origin.x + dx;
+                key.y = origin.y + dy;
+                _visitCell(key, center, maxRadiusSq, collect);
+            }
+        }
+        if(found.size() < k) continue;
+        std::nth_element(found.begin(), found.begin() + (k - 1),
+            found.end());
+        float reach = r * mCellSize;
+        if(found[k - 1].first <= reach * reach) break;
+    }
+    size_t n = std::min(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + n, found.end());
+    for(size_t i = 0; i < n; ++i)
+    {
+        out.push_back(found[i].second);
+    }
+}
+
+SpatialGrid::CellKey SpatialGrid::_cellOf(const kanko::Vector3& pos,
+    int world, int interior) const
+{
+    CellKey key;
+    key.world       = world;
+    key.interior    = interior;
+    key.x           = static_cast<int32_t>(std::floor(pos.x / mCellSize));
+    key.y           = static_cast<int32_t>(std::floor(pos.y / mCellSize));
+    return key;
+}
+
+void SpatialGrid::_unlink(Entry& entry)
+{
+    auto iter = mCells.find(entry.cell);
+    auto& ids = iter->second;
+    int moved = ids.back();
+    ids[entry.index] = moved;
+    mEntries[moved].index = entry.index;
+    ids.pop_back();
+    if(ids.empty()) mCells.erase(iter);
+}
+
+bool SpatialGrid::_scanAll(double cells) const
+{
+    // Looking up a cell costs several times checking an entry.
+    return cells * 8 > mSize;
+}
+
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <kanko/Common/Vector3.hpp>
+
+namespace swcu {
+
+/**
+ * Uniform grid over the X-Y plane of each virtual world and interior,
+ * hashing square cells to the ids inside them. Answers "who is near"
+ * by looking at the few cells a query touches rather than at every id.
+ * Ids are small non-negative integers such as player ids.
+ * Moves shorter than the threshold are ignored, so the positions known
+ * to the grid are off by less than that.
+ */
+class SpatialGrid
+{
+protected:
+    struct CellKey
+    {
+        int32_t         world;
+        int32_t         interior;
+        int32_t         x;
+        int32_t         y;
+
+        bool            operator==(const CellKey& rhs) const
+        {
+            return x == rhs.x && y == rhs.y && world == rhs.world &&
+                interior == rhs.interior;
+        }
+    };
+
+    struct CellKeyHash
+    {
+        size_t          operator()(const CellKey& key) const
+        {
+            uint64_t h = uint32_t(key.x) * 0x9E3779B1u;
+            h ^= uint64_t(uint32_t(key.y)) * 0x85EBCA77u + (h << 6);
+            h ^= uint64_t(uint32_t(key.world)) * 0xC2B2AE3Du + (h >> 2);
+            h ^= uint32_t(key.interior);
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+
+    struct Entry
+    {
+        bool            valid;
+        kanko::Vector3  pos;
+        CellKey         cell;
+        // Position of the id in its cell.
+        size_t          index;
+    };
+
+    float                                                   mCellSize;
+    float                                                   mThresholdSq;
+    std::vector<Entry>                                      mEntries;
+    std::unordered_map<CellKey, std::vector<int>, CellKeyHash> mCells;
+    size_t                                                  mSize;
+
+public:
+                        SpatialGrid(float cellSize, float moveThreshold);
+
+    /**
+     * Add the id, or move it.
+     * @return False if the move was under the threshold and ignored.
+     */
+            bool        update(int id, const kanko::Vector3& pos,
+                int world, int interior);
+            bool        remove(int id);
+            bool        contains(int id) const;
+    /**
+     * Last place taken of the id, which must be contained.
+     */
+            const kanko::Vector3& getPosition(int id) const
+            { return mEntries[id].pos; }
+            int         getWorld(int id) const
+            { return mEntries[id].cell.world; }
+            int         getInterior(int id) const
+            { return mEntries[id].cell.interior; }
+            size_t      size() const                { return mSize; }
+
+    /**
+     * Append the ids within radius of center to out, in no particular
+     * order.
+     */
+            void        queryRadius(const kanko::Vector3& center,
+                float radius, int world, int interior,
+                std::vector<int>& out) const;
+    /**
+     * Append the ids of up to k nearest ones within maxRadius of center to
+     * out, nearest first.
+     */
+            void        queryNearest(const kanko::Vector3& center, size_t k,
+                float maxRadius, int world, int interior,
+                std::vector<int>& out) const;
+
+protected:
+            CellKey     _cellOf(const kanko::Vector3& pos, int world,
+                int interior) const;
+            void        _unlink(Entry& entry);
+    /**
+     * Whether checking every id is cheaper than looking up so many cells.
+     */
+            bool        _scanAll(double cells) const;
+    /**
+     * Call func(id, squared distance) for the ids within the radius, of a
+     * cell or of all cells.
+     */
+    template<typename Func>
+            void        _visitCell(const CellKey& key,
+                const kanko::Vector3& center, float radiusSq,
+                Func func) const;
+    template<typename Func>
+            void        _visitAll(const kanko::Vector3& center,
+                float radiusSq, int world, int interior, Func func) const;
+};
+
+}
@@ -41,7 +41,8 @@ bool StorableObject::_createObject(const mongo::BSONObj& data)
         mongo::OID id = mongo::OID::gen();
         mongo::BSONObjBuilder b;
         b.append("_id", id).appendElements(data);
-        getDBConn()->insert(mCollection, b.obj());
+        MONGO_TIMED(mCollection, "insert",
+            getDBConn()->insert(mCollection, b.obj()));
         if(dbCheckError())
         {
             mId     = id;
@@ -68,7 +69,8 @@ bool StorableObject::_conditionedUpdate(const mongo::BSONObj& query,
     mongo::BSONObjBuilder b;
     b.append("_id", mId).appendElements(query);
     MONGO_WRAPPER({
-        getDBConn()->update(mCollection, mongo::Query(b.obj()), data);
+        MONGO_TIMED(mCollection, "update",
+            getDBConn()->update(mCollection, mongo::Query(b.obj()), data));
         return dbCheckError();
     });
     return false;
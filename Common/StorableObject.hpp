@@ -97,9 +97,9 @@ protected:
             bool        _loadObject(const std::string& fieldname, T value)
     {
         MONGO_WRAPPER({
-            auto doc = getDBConn()->findOne(
+            auto doc = MONGO_TIMED(mCollection, "findOne", getDBConn()->findOne(
                 mCollection, QUERY(fieldname << value)
-            );
+            ));
             if(doc.isEmpty())
             {
                 LOG(ERROR) << "Document not found.";
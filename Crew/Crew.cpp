@@ -47,13 +47,13 @@ Crew::Crew() : StorableObject(Config::colNameCrew),
 
 Crew::Crew(const std::string& name) : Crew()
 {
-    mName = name;
-    if(!_loadObject("name", GBKToUTF8(name)))
+    mName = DualString::fromGBK(name);
+    if(!_loadObject("name", mName.utf8()))
     {
         if(_createObject(BSON(
-            "name"          << GBKToUTF8(mName)         <<
+            "name"          << mName.utf8()             <<
             "leader"        << mLeader                  <<
-            "description"   << GBKToUTF8(mDescription)  <<
+            "description"   << mDescription.utf8()      <<
             "reputation"    << mReputation              <<
             "level"         << mLevel                   <<
             "color"         << mColor.getRGB()          <<
@@ -73,9 +73,10 @@ Crew::Crew(const mongo::OID& id) : Crew()
 
 bool Crew::setName(const std::string& name)
 {
-    if(_updateField("$set", "name", GBKToUTF8(name)))
+    DualString newName = DualString::fromGBK(name);
+    if(_updateField("$set", "name", newName.utf8()))
     {
-        mName = name;
+        mName = newName;
         EventManager::get().sendEvent(onCrewNameChanged, this);
         return true;
     }
@@ -95,9 +96,10 @@ bool Crew::setLeader(const mongo::OID& profileId)
 
 bool Crew::setDescription(const std::string& des)
 {
-    if(_updateField("$set", "description", GBKToUTF8(des)))
+    DualString newDes = DualString::fromGBK(des);
+    if(_updateField("$set", "description", newDes.utf8()))
     {
-        mDescription = des;
+        mDescription = newDes;
         return true;
     }
     return false;
@@ -233,9 +235,10 @@ bool Crew::isMember(const mongo::OID& profileId)
 {
     MONGO_WRAPPER({
         if(profileId == mLeader) return true;
-        return getDBConn()->count(mCollection, BSON(
+        return MONGO_TIMED(mCollection, "count",
+            getDBConn()->count(mCollection, BSON(
             "_id" << mId << "members." + profileId.str() <<
-            BSON("$gt" << PENDING))) > 0;
+            BSON("$gt" << PENDING)))) > 0;
     });
     return false;
 }
@@ -245,9 +248,10 @@ CrewHierarchy Crew::getMemberHierarchy(const mongo::OID& profileId)
     if(profileId == mLeader) return LEADER;
     std::string idstr = profileId.str();
     MONGO_WRAPPER({
-        auto doc = getDBConn()->findOne(mCollection, QUERY(
+        auto doc = MONGO_TIMED(mCollection, "findOne",
+            getDBConn()->findOne(mCollection, QUERY(
             "_id" << mId << "members." + idstr <<
-            BSON("$exists" << true)));
+            BSON("$exists" << true))));
         if(doc.isEmpty())
         {
             return NOT_A_MEMBER;
@@ -264,9 +268,9 @@ CrewHierarchy Crew::getMemberHierarchy(const mongo::OID& profileId)
 bool Crew::_parseObject(const mongo::BSONObj& doc)
 {
     MONGO_WRAPPER({
-        mName           = UTF8ToGBK(doc["name"].str());
+        mName           = DualString::fromUTF8(doc["name"].str());
         mLeader         = doc["leader"].OID();
-        mDescription    = UTF8ToGBK(doc["description"].str());
+        mDescription    = DualString::fromUTF8(doc["description"].str());
         mReputation     = doc["reputation"].numberLong();
         mLevel          = doc["level"].numberInt();
         mColor          = doc["color"].numberInt();
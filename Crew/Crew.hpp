@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "../Common/DualString.hpp"
 #include "../Common/StorableObject.hpp"
 #include "../Common/RGBAColor.hpp"
 #include "../Player/Player.hpp"
@@ -41,9 +42,9 @@ class Crew : public StorableObject
     friend class CrewEditMemberDialog;
 
 protected:
-    std::string     mName;
+    DualString      mName;
     mongo::OID      mLeader;
-    std::string     mDescription;
+    DualString      mDescription;
     int64_t         mReputation;
     int32_t         mLevel;
     RGBAColor       mColor;
@@ -60,13 +61,18 @@ public:
      * Load a crew.
      */
                         Crew(const mongo::OID& id);
-    virtual             ~Crew() {}
+    virtual             ~Crew()
+            { EventManager::get().cancelEvents(this); }
 
-            std::string getName() const         { return mName; }
+            const std::string& getName() const
+            { return mName.gbk(); }
+            const std::string& getNameUTF8() const
+            { return mName.utf8(); }
             std::string getColoredName() const
-            { return mColor.getEmbedCode() + mName + "{FFFFFF}"; }
+            { return mColor.getEmbedCode() + mName.gbk() + "{FFFFFF}"; }
             mongo::OID  getLeader() const       { return mLeader; }
-            std::string getDescription() const  { return mDescription; }
+            const std::string& getDescription() const
+            { return mDescription.gbk(); }
             int64_t     getReputation() const   { return mReputation; }
             int32_t     getLevel() const        { return mLevel; }
             RGBAColor   getColor() const        { return mColor; }
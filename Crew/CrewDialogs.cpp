@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <map>
 #include <memory>
 
 #include "../Interface/DialogManager.hpp"
@@ -81,33 +82,51 @@ bool CrewControlPanelDialog::build()
 
 CrewViewMembersDialog::CrewViewMembersDialog(
     int playerid, const mongo::OID& crew) :
-    ItemListDialog<std::string>(playerid, "ɳԱ"), mCrew(crew)
+    PagedListDialog<std::string>(playerid, "ɳԱ"), mCrew(crew)
 {
 }
 
-bool CrewViewMembersDialog::build()
+bool CrewViewMembersDialog::fetchPage(size_t offset, size_t limit)
 {
+    std::map<std::string, std::string> names;
     MONGO_WRAPPER({
-        auto doc        = getDBConn()->findOne(
+        auto doc        = MONGO_TIMED(Config::colNameCrew, "findOne",
+            getDBConn()->findOne(
             Config::colNameCrew,
             BSON("_id" << mCrew)
-        );
+        ));
         auto members    = doc["members"].Obj();
         auto it         = mongo::BSONObjIterator(members);
-        while(it.more())
+        std::vector<mongo::BSONElement> page;
+        mongo::BSONArrayBuilder ids;
+        for(size_t i = 0; it.more() && page.size() < limit; ++i)
+        {
+            auto member = it.next();
+            if(i < offset) continue;
+            page.push_back(member);
+            ids.append(mongo::OID(member.fieldName()));
+        }
+        if(page.empty()) return true;
+        // Names of the whole page in one query.
+        mongo::BSONObj fields = BSON("logname" << 1);
+        auto cur        = MONGO_TIMED(Config::colNamePlayer, "query",
+            getDBConn()->query(
+            Config::colNamePlayer,
+            QUERY("_id" << BSON("$in" << ids.arr())),
+            0, 0, &fields
+        ));
+        while(cur->more())
+        {
+            auto prof = cur->next();
+            names[prof["_id"].OID().str()] = prof["logname"].str();
+        }
+        for(auto& member : page)
         {
-            auto member                 = it.next();
             std::string memberIdStr     = member.fieldName();
-            mongo::OID memberId         = mongo::OID(memberIdStr);
-            auto prof                   = getDBConn()->findOne(
-                Config::colNamePlayer,
-                BSON("_id" << memberId)
-            );
-            std::string pName           = prof["logname"].str();
             std::stringstream msg;
             msg << getCrewHierarchyStr(
                 CrewHierarchy(member.numberInt()))
-                << "\t" << pName;
+                << "\t" << names[memberIdStr];
             addItem(memberIdStr, msg.str());
         }
     });
@@ -116,6 +135,8 @@ bool CrewViewMembersDialog::build()
 
 bool CrewViewMembersDialog::process(std::string key)
 {
+    // The member may be edited, or expelled.
+    invalidate();
     DialogManager::get().push<CrewEditMemberDialog>(
         mPlayerId, mCrew, mongo::OID(key));
     return true;
@@ -287,18 +308,19 @@ bool CrewFindByNameDialog::handleCallback(
 
 _CrewFindByNameResultDialog::_CrewFindByNameResultDialog(
     int playerid, const std::string& keyword, CallbackType cb) :
-    ItemListDialog<std::string>(playerid, "Ұ"),
+    PagedListDialog<std::string>(playerid, "Ұ"),
     mKeyWord(keyword), mCallback(cb)
 {
 }
 
-bool _CrewFindByNameResultDialog::build()
+bool _CrewFindByNameResultDialog::fetchPage(size_t offset, size_t limit)
 {
     MONGO_WRAPPER({
-        auto cur = getDBConn()->query(
+        auto cur = MONGO_TIMED(Config::colNameCrew, "query", getDBConn()->query(
             Config::colNameCrew,
-            QUERY("name" << BSON("$regex" << GBKToUTF8(mKeyWord)))
-        );
+            QUERY("name" << BSON("$regex" << GBKToUTF8(mKeyWord))).sort("name"),
+            static_cast<int>(limit), static_cast<int>(offset)
+        ));
         while(cur->more())
         {
             auto doc = cur->next();
@@ -31,7 +31,7 @@ public:
     virtual bool    build();
 };
 
-class CrewViewMembersDialog : public ItemListDialog<std::string>
+class CrewViewMembersDialog : public PagedListDialog<std::string>
 {
 protected:
     mongo::OID      mCrew;     
@@ -41,7 +41,7 @@ public:
         int playerid, const mongo::OID& crew);
     virtual         ~CrewViewMembersDialog() {}
 
-    virtual bool    build();
+    virtual bool    fetchPage(size_t offset, size_t limit);
     virtual bool    process(std::string key);
 };
 
@@ -113,7 +113,7 @@ public:
         bool response, int listitem, const std::string &inputtext);
 };
 
-class _CrewFindByNameResultDialog : public ItemListDialog<std::string>
+class _CrewFindByNameResultDialog : public PagedListDialog<std::string>
 {
     typedef std::function<bool(const mongo::OID&)> CallbackType;
 
@@ -126,7 +126,7 @@ public:
         int playerid, const std::string& keyword, CallbackType cb);
     virtual         ~_CrewFindByNameResultDialog() {}
 
-    virtual bool    build();
+    virtual bool    fetchPage(size_t offset, size_t limit);
     virtual bool    process(std::string key);
 };
 
@@ -14,37 +14,238 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <array>
+
+#include "../Common/Metrics.hpp"
+
 #include "Event.hpp"
 
 namespace swcu {
 
-void EventManager::_addListener(EventListener* listener)
+const char* getEventTypeStr(EventType type)
+{
+    static const char* names[] = {
+        "onPlayerEnterServer",
+        "onPlayerExitServer",
+        "onPlayerSpawn",
+        "onPlayerDeath",
+        "onPlayerNicknameChanged",
+        "onPlayerLogNameChanged",
+        "onPlayerMoneyAmountChanged",
+        "onPlayerJailed",
+        "onPlayerUnjailed",
+        "onPlayerAdminLevelChanged",
+        "onPlayerPoliceRankChanged",
+        "onPlayerWantedLevelChanged",
+        "onPlayerColorChanged",
+        "onCrewPlayerApplyToJoin",
+        "onCrewPlayerApprovedToJoin",
+        "onCrewPlayerDeniedToJoin",
+        "onCrewMemberAdded",
+        "onCrewMemberRemoved",
+        "onCrewMemberHierarchyChanged",
+        "onCrewLeaderChanged",
+        "onCrewColorChanged",
+        "onCrewNameChanged"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == invalidEvent,
+        "Event type names out of sync with EventType.");
+    return type < invalidEvent ? names[type] : "invalidEvent";
+}
+
+bool Event::isSameAs(const Event& other) const
+{
+    return type == other.type && player == other.player &&
+        crew == other.crew && profile == other.profile;
+}
+
+EventManager::EventManager() : mDispatching(0)
+{
+    mHasHoles.fill(false);
+    mDelivery.fill(IMMEDIATE);
+    for(auto type : {
+        onPlayerNicknameChanged,
+        onPlayerMoneyAmountChanged,
+        onPlayerAdminLevelChanged,
+        onPlayerPoliceRankChanged,
+        onPlayerWantedLevelChanged,
+        onPlayerColorChanged,
+        onCrewMemberHierarchyChanged,
+        onCrewColorChanged,
+        onCrewNameChanged })
+    {
+        mDelivery[type] = DEFERRED;
+    }
+}
+
+void EventManager::_subscribe(EventListener* listener, EventType type)
+{
+    mSubscribers[type].push_back(listener);
+}
+
+void EventManager::_unsubscribe(EventListener* listener, EventType type)
 {
-    mListeners.insert(listener);
+    auto& list = mSubscribers[type];
+    auto iter = std::find(list.begin(), list.end(), listener);
+    if(iter == list.end()) return;
+    // Don't move the others around under a delivery in progress.
+    if(mDispatching > 0)
+    {
+        *iter = nullptr;
+        mHasHoles[type] = true;
+    }
+    else
+    {
+        list.erase(iter);
+    }
+}
+
+void EventManager::_compact()
+{
+    for(size_t i = 0; i < mSubscribers.size(); ++i)
+    {
+        if(!mHasHoles[i]) continue;
+        auto& list = mSubscribers[i];
+        list.erase(std::remove(list.begin(), list.end(), nullptr),
+            list.end());
+        mHasHoles[i] = false;
+    }
 }
 
-void EventManager::_removeListener(EventListener* listener)
+size_t EventManager::getSubscriberCount(EventType type) const
 {
-    mListeners.erase(listener);
+    if(type >= invalidEvent) return 0;
+    const auto& list = mSubscribers[type];
+    return list.size() -
+        std::count(list.begin(), list.end(), nullptr);
 }
 
-void EventManager::sendEvent(EventType type, boost::any p1, boost::any p2)
+void EventManager::sendEvent(EventType type, Player* player)
 {
-    Event evt(type, p1, p2);
-    for(auto &i : mListeners)
+    sendEvent(Event(type, player));
+}
+
+void EventManager::sendEvent(EventType type, Crew* crew,
+    const mongo::OID& profile)
+{
+    sendEvent(Event(type, crew, profile));
+}
+
+void EventManager::sendEvent(const Event& evt)
+{
+    if(evt.type >= invalidEvent) return;
+    if(mDelivery[evt.type] == IMMEDIATE)
     {
-        i->handleEvent(evt);
-    }   
+        _deliver(evt);
+        return;
+    }
+    for(auto& i : mQueue)
+    {
+        if(i.isSameAs(evt)) return;
+    }
+    mQueue.push_back(evt);
 }
 
-EventListener::EventListener()
+void EventManager::setDelivery(EventType type, EventDelivery delivery)
 {
-    EventManager::get()._addListener(this);
+    if(type < invalidEvent) mDelivery[type] = delivery;
+}
+
+EventDelivery EventManager::getDelivery(EventType type) const
+{
+    return type < invalidEvent ? mDelivery[type] : IMMEDIATE;
+}
+
+void EventManager::flushEvents()
+{
+    // Not reentrant, a listener flushing would deliver events twice.
+    if(!mFlushing.empty()) return;
+    mFlushing.swap(mQueue);
+    for(size_t i = 0; i < mFlushing.size(); ++i)
+    {
+        // Cancelled ones are marked invalid.
+        Event evt = mFlushing[i];
+        if(evt.type != invalidEvent) _deliver(evt);
+    }
+    mFlushing.clear();
+}
+
+void EventManager::cancelEvents(const void* subject)
+{
+    if(subject == nullptr) return;
+    mQueue.erase(std::remove_if(mQueue.begin(), mQueue.end(),
+        [subject](const Event& evt) {
+            return evt.player == subject || evt.crew == subject;
+        }), mQueue.end());
+    for(auto& i : mFlushing)
+    {
+        if(i.player == subject || i.crew == subject) i.type = invalidEvent;
+    }
+}
+
+void EventManager::_deliver(const Event& evt)
+{
+    static const auto histograms = [] {
+        std::array<Histogram*, invalidEvent> h;
+        for(size_t i = 0; i < h.size(); ++i)
+        {
+            h[i] = &Metrics::get().histogram("swcu_event_dispatch_seconds",
+                Metrics::label("type", getEventTypeStr(EventType(i))),
+                "Time spent delivering an event to all listeners.");
+        }
+        return h;
+    }();
+    ScopedTimer timer(histograms[evt.type]);
+
+    auto& list = mSubscribers[evt.type];
+    // Listeners subscribing meanwhile are appended and not called.
+    size_t count = list.size();
+    ++mDispatching;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(EventListener* listener = list[i]) listener->handleEvent(evt);
+    }
+    if(--mDispatching == 0) _compact();
+}
+
+EventListener::EventListener() : mSubscriptions(0)
+{
+    for(int i = 0; i < invalidEvent; ++i)
+    {
+        subscribe(EventType(i));
+    }
+}
+
+EventListener::EventListener(std::initializer_list<EventType> types) :
+    mSubscriptions(0)
+{
+    for(auto type : types)
+    {
+        subscribe(type);
+    }
 }
 
 EventListener::~EventListener()
 {
-    EventManager::get()._removeListener(this);
+    for(int i = 0; i < invalidEvent; ++i)
+    {
+        unsubscribe(EventType(i));
+    }
+}
+
+void EventListener::subscribe(EventType type)
+{
+    if(type >= invalidEvent || isSubscribed(type)) return;
+    mSubscriptions |= 1u << type;
+    EventManager::get()._subscribe(this, type);
+}
+
+void EventListener::unsubscribe(EventType type)
+{
+    if(type >= invalidEvent || !isSubscribed(type)) return;
+    mSubscriptions &= ~(1u << type);
+    EventManager::get()._unsubscribe(this, type);
 }
 
 }
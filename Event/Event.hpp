@@ -16,14 +16,19 @@
 
 #pragma once
 
-#include <utility>
-#include <boost/any.hpp>
-#include <unordered_set>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include <mongo/client/dbclient.h>
 
 #include "../Utility/Singleton.hpp"
 
 namespace swcu {
 
+class Player;
+class Crew;
+
 enum EventType
 {
     onPlayerEnterServer,            // Player*
@@ -52,34 +57,117 @@ enum EventType
     invalidEvent
 };
 
-typedef std::tuple<EventType, boost::any, boost::any> Event;
+/**
+ * An event and its subject. Which members are set depends on the type,
+ * see the comments on EventType; the others are null.
+ * It's a plain value, sending one allocates nothing.
+ */
+struct Event
+{
+    EventType           type;
+    Player*             player;
+    Crew*               crew;
+    mongo::OID          profile;
+
+                        Event(EventType type, Player* player) :
+        type(type), player(player), crew(nullptr) {}
+                        Event(EventType type, Crew* crew,
+        const mongo::OID& profile = mongo::OID()) :
+        type(type), player(nullptr), crew(crew), profile(profile) {}
+
+            bool        isSameAs(const Event& other) const;
+};
+
+const char* getEventTypeStr(EventType type);
+
+enum EventDelivery
+{
+    // Delivered before sendEvent() returns.
+    IMMEDIATE,
+    // Queued and delivered by flushEvents(), once per tick. Repeats of an
+    // event with the same type and subject are delivered only once.
+    DEFERRED
+};
 
 class EventListener;
 
+/**
+ * Delivers events to the listeners subscribed to their types, in the order
+ * they subscribed. Listeners may subscribe and unsubscribe, or be destroyed,
+ * while an event is being delivered.
+ * Each type is delivered either immediately or deferred to the end of the
+ * tick, see EventDelivery. Events which only lead to refreshing what
+ * players see are deferred by default.
+ */
 class EventManager : public Singleton<EventManager>
 {
 protected:
-    std::unordered_set<EventListener*>  mListeners;
+    std::array<std::vector<EventListener*>, invalidEvent>   mSubscribers;
+    // Set when a listener left during delivery, its slots are null then.
+    std::array<bool, invalidEvent>                          mHasHoles;
+    int                                                     mDispatching;
+
+    std::array<EventDelivery, invalidEvent>                 mDelivery;
+    std::vector<Event>                                      mQueue;
+    // The part of the queue being flushed.
+    std::vector<Event>                                      mFlushing;
 
 protected:
-                    EventManager() {}
+                    EventManager();
 
     friend class Singleton<EventManager>;
+    friend class EventListener;
 
 public:
     virtual         ~EventManager() {}
-            void    _addListener(EventListener* listener);
-            void    _removeListener(EventListener* listener);
-            void    sendEvent(EventType type,
-                boost::any p1 = nullptr, boost::any p2 = nullptr);
+            void    sendEvent(EventType type, Player* player);
+            void    sendEvent(EventType type, Crew* crew,
+                const mongo::OID& profile = mongo::OID());
+            void    sendEvent(const Event& evt);
+
+            void    setDelivery(EventType type, EventDelivery delivery);
+            EventDelivery getDelivery(EventType type) const;
+    /**
+     * Deliver the deferred events queued so far. Events raised meanwhile
+     * wait for the next flush.
+     */
+            void    flushEvents();
+    /**
+     * Drop the queued events about a player or crew which is going away.
+     */
+            void    cancelEvents(const void* subject);
+            size_t  getQueuedCount() const      { return mQueue.size(); }
+
+            size_t  getSubscriberCount(EventType type) const;
+
+protected:
+            void    _deliver(const Event& evt);
+            void    _subscribe(EventListener* listener, EventType type);
+            void    _unsubscribe(EventListener* listener, EventType type);
+            void    _compact();
 };
 
+/**
+ * Base of everything that wants events. A listener only receives the types
+ * it subscribed to, by default all of them.
+ */
 class EventListener
 {
+    static_assert(invalidEvent <= 32, "Subscription mask is too narrow.");
+
+protected:
+    uint32_t        mSubscriptions;
+
 public:
                     EventListener();
+                    EventListener(std::initializer_list<EventType> types);
     virtual         ~EventListener();
     virtual void    handleEvent(const Event& evt) = 0;
+
+            void    subscribe(EventType type);
+            void    unsubscribe(EventType type);
+            bool    isSubscribed(EventType type) const
+            { return (mSubscriptions & (1u << type)) != 0; }
 };
 
 }
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sampgdk/a_players.h>
+#include <sampgdk/a_samp.h>
+
+#include "../Common/Common.hpp"
+#include "../Player/PlayerManager.hpp"
+
+#include "ChatManager.hpp"
+
+namespace swcu {
+
+namespace {
+
+const char* getChatChannelStr(ChatChannel channel)
+{
+    static const char* names[] = { "local", "crew", "admin", "global" };
+    return names[channel];
+}
+
+}
+
+ChatManager::ChatManager()
+{
+    mBuckets.fill(TokenBucket(Config::chatRate, Config::chatBurst));
+    for(int i = 0; i < CHAT_CHANNELS; ++i)
+    {
+        mDelivered[i] = &Metrics::get().counter("swcu_chat_messages_total",
+            std::string("channel=\"") + getChatChannelStr(ChatChannel(i)) +
+            "\"", "Chat messages delivered.");
+    }
+}
+
+bool ChatManager::handleText(int playerid, const char* text)
+{
+    ChatChannel channel = ChatChannel(Config::chatDefaultChannel);
+    switch(text[0])
+    {
+        case '#': channel = CHAT_LOCAL;     ++text; break;
+        case '!': channel = CHAT_CREW;      ++text; break;
+        case '@': channel = CHAT_ADMIN;     ++text; break;
+        case '*': channel = CHAT_GLOBAL;    ++text; break;
+        default: break;
+    }
+    if(text[0] != 0) send(playerid, channel, text);
+    return false;
+}
+
+bool ChatManager::send(int playerid, ChatChannel channel, const char* text)
+{
+    static Counter& throttled = Metrics::get().counter(
+        "swcu_chat_throttled_total", "",
+        "Chat messages dropped for flooding.");
+
+    Player* p = PlayerManager::get().getPlayer(playerid);
+    if(p == nullptr || channel >= CHAT_CHANNELS) return false;
+    if(p->hasFlags(STATUS_MUTED)) return false;
+    // Refused messages don't cost a token, or the player would soon be
+    // told to slow down instead of why they were refused.
+    if(!_checkChannel(*p, channel)) return false;
+    if(!mBuckets[playerid].take())
+    {
+        throttled.inc();
+        SendClientMessage(playerid, 0xFF0000FF, "˵̫, Ժ.");
+        return false;
+    }
+
+    mDelivered[channel]->inc();
+    _format(*p, channel, text);
+    if(channel == CHAT_GLOBAL)
+    {
+        SendClientMessageToAll(0xFFFFFFFF, mBuffer.c_str());
+        return true;
+    }
+    _collectRecipients(*p, channel);
+    for(int id : mRecipients)
+    {
+        SendClientMessage(id, 0xFFFFFFFF, mBuffer.c_str());
+    }
+    return true;
+}
+
+void ChatManager::resetPlayer(int playerid)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    mBuckets[playerid].reset();
+}
+
+bool ChatManager::_checkChannel(const Player& player, ChatChannel channel)
+{
+    if(channel == CHAT_CREW && !player.isCrewMember())
+    {
+        SendClientMessage(player.getInGameId(), 0xFF0000FF,
+            "㲻κΰ.");
+        return false;
+    }
+    if(channel == CHAT_ADMIN && player.getAdminLevel() <= 0)
+    {
+        SendClientMessage(player.getInGameId(), 0xFF0000FF,
+            "ûȨʹùƵ.");
+        return false;
+    }
+    return true;
+}
+
+void ChatManager::_format(const Player& player, ChatChannel channel,
+    const char* text)
+{
+    mBuffer.clear();
+    switch(channel)
+    {
+        case CHAT_LOCAL:    mBuffer.append("{AAAAAA}[]{FFFFFF} "); break;
+        case CHAT_CREW:     mBuffer.append("{33CCFF}[]{FFFFFF} "); break;
+        case CHAT_ADMIN:    mBuffer.append("{FF9900}[]{FFFFFF} "); break;
+        default: break;
+    }
+    mBuffer.append(player.getColoredNickname()).append("(")
+        .append(std::to_string(player.getInGameId())).append("): ")
+        .append(text);
+}
+
+void ChatManager::_collectRecipients(const Player& player,
+    ChatChannel channel)
+{
+    mRecipients.clear();
+    int playerid = player.getInGameId();
+    switch(channel)
+    {
+        case CHAT_LOCAL:
+        {
+            mRecipients.push_back(playerid);
+            PlayerManager::get().getPlayersNear(playerid,
+                Config::chatLocalRadius, mRecipients);
+            break;
+        }
+        case CHAT_CREW:
+        {
+            for(Player* member :
+                PlayerManager::get().getOnlineCrewMembers(player.getCrew()))
+            {
+                mRecipients.push_back(member->getInGameId());
+            }
+            break;
+        }
+        case CHAT_ADMIN:
+        {
+            PlayerManager::get().forEachPlayer([this](Player& p) {
+                if(p.getAdminLevel() > 0)
+                {
+                    mRecipients.push_back(p.getInGameId());
+                }
+            });
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <sampgdk/a_samp.h>
+
+#include "../Utility/Singleton.hpp"
+#include "../Utility/TokenBucket.hpp"
+
+namespace swcu {
+
+class Counter;
+class Player;
+
+enum ChatChannel
+{
+    // Players within Config::chatLocalRadius.
+    CHAT_LOCAL,
+    CHAT_CREW,
+    CHAT_ADMIN,
+    CHAT_GLOBAL,
+    CHAT_CHANNELS
+};
+
+/**
+ * Delivers what players say in chat. A leading character picks the
+ * channel, otherwise Config::chatDefaultChannel is used:
+ *     # local, ! crew, @ admin, * global.
+ * Each message is formatted once into a reused buffer and sent only to
+ * those in its channel; global messages go out in one native call.
+ * Every player has a token bucket against flooding.
+ */
+class ChatManager : public Singleton<ChatManager>
+{
+protected:
+    std::array<TokenBucket, MAX_PLAYERS> mBuckets;
+    std::string                          mBuffer;
+    std::vector<int>                     mRecipients;
+    std::array<Counter*, CHAT_CHANNELS>  mDelivered;
+
+protected:
+                        ChatManager();
+    friend class Singleton<ChatManager>;
+
+public:
+    virtual             ~ChatManager() {}
+
+    /**
+     * Called from OnPlayerText.
+     * @return False, the server isn't to send the text itself.
+     */
+            bool        handleText(int playerid, const char* text);
+    /**
+     * Say text in a channel, subject to muting and throttling.
+     * @return Whether the message was delivered.
+     */
+            bool        send(int playerid, ChatChannel channel,
+                const char* text);
+    /**
+     * Give a joining player a full bucket.
+     */
+            void        resetPlayer(int playerid);
+
+protected:
+            bool        _checkChannel(const Player& player,
+                ChatChannel channel);
+            void        _format(const Player& player, ChatChannel channel,
+                const char* text);
+            void        _collectRecipients(const Player& player,
+                ChatChannel channel);
+};
+
+}
@@ -14,44 +14,234 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sampgdk/a_players.h>
+#include <sampgdk/a_samp.h>
+
 #include "../Common/Common.hpp"
+#include "../Player/PlayerManager.hpp"
 
 #include "CommandManager.hpp"
 
 namespace swcu {
 
-void CommandManager::registerCommand(const std::string& cmdname,
-    CommandHandler handler)
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+int64_t nowMillis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+bool parseArgument(StringRef token, int& out)
+{
+    // The token ends with whitespace or the end of the line, neither of
+    // which strtol reads past.
+    if(token.empty()) return false;
+    char* end;
+    errno = 0;
+    long value = strtol(token.data(), &end, 10);
+    if(end != token.end() || errno != 0 ||
+        value < INT32_MIN || value > INT32_MAX)
+    {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+bool parseArgument(StringRef token, float& out)
+{
+    if(token.empty()) return false;
+    char* end;
+    errno = 0;
+    float value = strtof(token.data(), &end);
+    if(end != token.end() || errno != 0 || !std::isfinite(value))
+    {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+bool parseArgument(StringRef token, std::string& out)
+{
+    if(token.empty()) return false;
+    out.assign(token.data(), token.size());
+    return true;
+}
+
+bool parseArgument(StringRef token, StringRef& out)
+{
+    if(token.empty()) return false;
+    out = token;
+    return true;
+}
+
+bool CommandArgs::next(StringRef& token)
+{
+    while(mPos != mEnd && isSpace(*mPos)) ++mPos;
+    if(mPos == mEnd) return false;
+    const char* begin = mPos;
+    while(mPos != mEnd && !isSpace(*mPos)) ++mPos;
+    token = StringRef(begin, mPos - begin);
+    return true;
+}
+
+StringRef CommandArgs::rest()
+{
+    while(mPos != mEnd && isSpace(*mPos)) ++mPos;
+    return StringRef(mPos, mEnd - mPos);
+}
+
+void CommandManager::_registerCommand(const std::string& cmdname,
+    CommandHandler handler, const std::string& usage,
+    const CommandOptions& options)
+{
+    static const char* reasons[] = {
+        "permission", "cooldown", "throttled", "usage"
+    };
+    std::string leaf;
+    auto names = _namespaceOf(cmdname, leaf);
+    if(names == nullptr)
+    {
+        LOG(WARNING) << "Subcommand of unknown command: " << cmdname;
+        return;
+    }
+    if(names->count(leaf) > 0)
+    {
+        LOG(WARNING) << "Command handler overwritten: " << cmdname;
+    }
+    std::unique_ptr<Command> command(new Command());
+    command->handler    = std::move(handler);
+    command->usage      = "÷: /" + cmdname + " " + usage;
+    command->options    = options;
+    if(options.cooldown > 0)
+    {
+        command->lastUse.assign(MAX_PLAYERS, INT64_MIN / 2);
+    }
+    command->budget     = TokenBucket(options.globalRate,
+        std::max(options.globalBurst, double(options.cost)));
+
+    std::string label = Metrics::label("command", cmdname);
+    command->calls      = &Metrics::get().counter(
+        "swcu_command_calls_total", label, "Commands run.");
+    command->cost       = &Metrics::get().counter(
+        "swcu_command_cost_total", label,
+        "Cost units spent on commands, see CommandOptions.");
+    for(int i = 0; i < REJECT_REASONS; ++i)
+    {
+        command->rejected[i] = &Metrics::get().counter(
+            "swcu_command_rejected_total",
+            label + "," + Metrics::label("reason", reasons[i]),
+            "Commands refused before or instead of running.");
+    }
+    command->time       = &Metrics::get().histogram(
+        "swcu_command_seconds", label, "Time taken by commands.");
+
+    (*names)[leaf] = command.get();
+    mCommandList.push_back(std::move(command));
+}
+
+bool CommandManager::addAlias(const std::string& alias,
+    const std::string& cmdname)
 {
-    auto iter = mCommands.find(cmdname);
-    if(iter != mCommands.end())
+    std::string leaf, aliasLeaf;
+    auto names = _namespaceOf(cmdname, leaf);
+    auto aliasNames = _namespaceOf(alias, aliasLeaf);
+    // Subcommands are aliased under the same parent.
+    if(names == nullptr || aliasNames != names || names->count(leaf) == 0)
     {
-        LOG(WARNING) << "Commadn handler overwritten: " << cmdname;
-        iter->second = handler;
+        LOG(WARNING) << "Alias " << alias << " of unknown command " <<
+            cmdname << ".";
+        return false;
     }
-    else
+    (*names)[aliasLeaf] = (*names)[leaf];
+    return true;
+}
+
+std::unordered_map<std::string, CommandManager::Command*>*
+    CommandManager::_namespaceOf(const std::string& cmdname,
+    std::string& leaf)
+{
+    size_t space = cmdname.find(' ');
+    if(space == std::string::npos)
     {
-        mCommands.insert(std::make_pair(cmdname, handler));
+        leaf = cmdname;
+        return &mCommands;
     }
+    auto parent = mCommands.find(cmdname.substr(0, space));
+    if(parent == mCommands.end()) return nullptr;
+    leaf = cmdname.substr(space + 1);
+    return &parent->second->subcommands;
 }
 
 bool CommandManager::handleCallback(int playerid, const char *cmdtext)
 {
-    if(strlen(cmdtext) < 2) return false;
+    CommandArgs args(StringRef(cmdtext[0] == '/' ? cmdtext + 1 : cmdtext));
+    StringRef   name;
+    if(!args.next(name)) return false;
     try
     {
-        std::stringstream   cmdsrc(cmdtext + 1);
-        std::string         cmdname;
-        cmdsrc >> cmdname;
-        auto iter = mCommands.find(cmdname);
+        // Command names fit in the small string buffer, no allocation.
+        auto iter = mCommands.find(name.str());
         if(iter == mCommands.end())
         {
             return false;
         }
-        else
+        Command* found = iter->second;
+        if(!found->subcommands.empty())
+        {
+            CommandArgs rest = args;
+            StringRef   subname;
+            if(rest.next(subname))
+            {
+                auto sub = found->subcommands.find(subname.str());
+                if(sub != found->subcommands.end())
+                {
+                    found = sub->second;
+                    args = rest;
+                }
+            }
+        }
+        Command& command = *found;
+        int64_t now = nowMillis();
+        if(!_admit(command, playerid, now)) return true;
+
+        int result;
+        {
+            ScopedTimer timer(command.time);
+            result = command.handler(playerid, args);
+        }
+        if(result < 0)
+        {
+            command.rejected[REJECT_USAGE]->inc();
+            SendClientMessage(playerid, 0xFFFFFFFF, command.usage.c_str());
+            return true;
+        }
+        command.calls->inc();
+        // Only uses that did something are charged.
+        if(result == COMMAND_HANDLED)
         {
-            return iter->second(playerid, cmdsrc);
+            command.cost->inc(command.options.cost);
+            if(!command.lastUse.empty()) command.lastUse[playerid] = now;
+            if(command.options.globalRate > 0.0)
+            {
+                command.budget.take(command.options.cost);
+            }
         }
+        return result != COMMAND_UNKNOWN;
     }
     catch(std::exception &e)
     {
@@ -64,4 +254,55 @@ bool CommandManager::handleCallback(int playerid, const char *cmdtext)
     return false;
 }
 
+void CommandManager::resetPlayer(int playerid)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    for(auto& command : mCommandList)
+    {
+        if(!command->lastUse.empty())
+        {
+            command->lastUse[playerid] = INT64_MIN / 2;
+        }
+    }
+}
+
+bool CommandManager::_admit(Command& command, int playerid, int64_t now)
+{
+    const CommandOptions& options = command.options;
+    if(options.adminLevel > 0)
+    {
+        Player* p = PlayerManager::get().getPlayer(playerid);
+        if(p == nullptr || p->getAdminLevel() < options.adminLevel)
+        {
+            command.rejected[REJECT_PERMISSION]->inc();
+            SendClientMessage(playerid, 0xFF0000FF,
+                "ûȨʹָ.");
+            return false;
+        }
+    }
+    if(!command.lastUse.empty())
+    {
+        if(static_cast<unsigned>(playerid) >= command.lastUse.size())
+        {
+            return false;
+        }
+        int64_t wait = command.lastUse[playerid] + options.cooldown - now;
+        if(wait > 0)
+        {
+            command.rejected[REJECT_COOLDOWN]->inc();
+            SendClientMessage(playerid, 0xFF0000FF, FORMAT(
+                " {} ʹָ.", (wait + 999) / 1000).c_str());
+            return false;
+        }
+    }
+    if(options.globalRate > 0.0 && !command.budget.has(options.cost))
+    {
+        command.rejected[REJECT_THROTTLED]->inc();
+        SendClientMessage(playerid, 0xFF0000FF,
+            "ָʹõ̫, Ժ.");
+        return false;
+    }
+    return true;
+}
+
 }
@@ -16,22 +16,176 @@
 
 #pragma once
 
-#include <sstream>
-#include <string>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../Utility/Singleton.hpp"
+#include "../Utility/StringRef.hpp"
+#include "../Utility/TokenBucket.hpp"
 
 namespace swcu {
 
+class Counter;
+class Histogram;
+
+/**
+ * Limits on who may use a command and how often.
+ */
+struct CommandOptions
+{
+    // Lowest admin level allowed, 0 for everyone.
+    int                 adminLevel;
+    // Time in ms before the same player may use it again.
+    int                 cooldown;
+    // Cost units per second shared by all players, 0 for no limit, and
+    // how many may be spent at once.
+    double              globalRate;
+    double              globalBurst;
+    // Units a use costs, for commands heavier than others.
+    int                 cost;
+
+                        CommandOptions() : adminLevel(0), cooldown(0),
+                            globalRate(0.0), globalBurst(0.0), cost(1) {}
+};
+
+/**
+ * What a command handler did with the command.
+ */
+enum CommandResult
+{
+    // Not handled, the player is told the command is unknown.
+    COMMAND_UNKNOWN,
+    // Done, counts towards the cooldown and the global rate.
+    COMMAND_HANDLED,
+    // Answered, e.g. with why it failed, but nothing was done, so it
+    // isn't charged.
+    COMMAND_HANDLED_NO_CHARGE
+};
+
+/**
+ * Convert a token into an argument.
+ * @return False if the token isn't of that type, out is untouched then.
+ */
+bool parseArgument(StringRef token, int& out);
+bool parseArgument(StringRef token, float& out);
+bool parseArgument(StringRef token, std::string& out);
+bool parseArgument(StringRef token, StringRef& out);
+
+/**
+ * Whitespace separated tokens of a command line, looked at in place.
+ */
+class CommandArgs
+{
+protected:
+    const char*         mPos;
+    const char*         mEnd;
+
+public:
+    explicit            CommandArgs(StringRef line) :
+                            mPos(line.begin()), mEnd(line.end()) {}
+
+    /**
+     * @return False if there are no more tokens.
+     */
+            bool        next(StringRef& token);
+    template<typename T>
+            bool        read(T& out)
+    {
+        StringRef token;
+        return next(token) && parseArgument(token, out);
+    }
+    /**
+     * What hasn't been read, without leading whitespace.
+     */
+            StringRef   rest();
+};
+
+/**
+ * What to show as the parameters of a command in its usage.
+ */
+template<typename T> struct CommandArgHint;
+template<> struct CommandArgHint<int>
+{ static const char* get() { return "<int>"; } };
+template<> struct CommandArgHint<float>
+{ static const char* get() { return "<float>"; } };
+template<> struct CommandArgHint<std::string>
+{ static const char* get() { return "<text>"; } };
+template<> struct CommandArgHint<StringRef>
+{ static const char* get() { return "<text>"; } };
+template<> struct CommandArgHint<CommandArgs>
+{ static const char* get() { return "[...]"; } };
+
+/**
+ * Binds the parameters of a command handler to tokens of the command
+ * line. A handler may take a CommandArgs& last to read the rest itself.
+ */
+template<typename T>
+struct CommandArgBinder
+{
+    typedef T                   Storage;
+    static bool                 parse(CommandArgs& args, Storage& out)
+    { return args.read(out); }
+    static const T&             get(const Storage& value)
+    { return value; }
+};
+
+template<>
+struct CommandArgBinder<CommandArgs>
+{
+    typedef CommandArgs*        Storage;
+    static bool                 parse(CommandArgs& args, Storage& out)
+    { out = &args; return true; }
+    static CommandArgs&         get(Storage value)
+    { return *value; }
+};
+
 class CommandManager : public Singleton<CommandManager>
 {
 protected:
-    typedef std::function<bool(int, std::stringstream&)>
-        CommandHandler;
+    /**
+     * Returns -1 if the arguments didn't fit, otherwise the CommandResult
+     * of the command.
+     */
+    typedef std::function<int(int, CommandArgs&)> CommandHandler;
+
+    enum RejectReason
+    {
+        REJECT_PERMISSION,
+        REJECT_COOLDOWN,
+        REJECT_THROTTLED,
+        REJECT_USAGE,
+        REJECT_REASONS
+    };
+
+    struct Command
+    {
+        CommandHandler      handler;
+        // Shown when the arguments don't fit.
+        std::string         usage;
+        CommandOptions      options;
+        // Last use by each player id in ms, only kept with a cooldown.
+        std::vector<int64_t> lastUse;
+        TokenBucket         budget;
+
+        Counter*            calls;
+        Counter*            cost;
+        Counter*            rejected[REJECT_REASONS];
+        Histogram*          time;
+
+        // Looked up by the first argument, each with its own limits.
+        std::unordered_map<std::string, Command*>   subcommands;
+    };
 
-    std::unordered_map<std::string, CommandHandler> mCommands;
+    std::vector<std::unique_ptr<Command>>           mCommandList;
+    // Names and aliases.
+    std::unordered_map<std::string, Command*>       mCommands;
 
 protected:
                     CommandManager() {}
@@ -40,10 +194,82 @@ protected:
 public:
     virtual         ~CommandManager() {}
 
+    /**
+     * Register a handler taking the player id followed by typed arguments,
+     * e.g. CommandResult(int playerid, int skin), which are parsed from the
+     * command line before it's called. If they can't be, the usage is
+     * shown to the player instead, made up from the types of the arguments
+     * unless given.
+     * Only uses for which the handler returns COMMAND_HANDLED count
+     * towards the cooldown and the global rate. Those refused by the
+     * options or with wrong arguments don't.
+     * A name of two words, e.g. "c color", registers a subcommand of a
+     * registered command, run instead of it when the first argument is
+     * the second word, and limited apart from it.
+     */
+    template<typename... Args>
             void    registerCommand(const std::string& cmdname,
-        CommandHandler handler);
+        CommandResult (*handler)(int, Args...), const std::string& usage = "",
+        const CommandOptions& options = CommandOptions())
+    {
+        typedef std::index_sequence_for<Args...> Indices;
+        _registerCommand(cmdname, [handler](int playerid, CommandArgs& args)
+        {
+            return _invoke(handler, playerid, args, Indices());
+        }, usage.empty() ? _makeUsage<Args...>() : usage, options);
+    }
+    /**
+     * Another name for a registered command, sharing its limits. Names of
+     * subcommands take the same two words on both sides.
+     */
+            bool    addAlias(const std::string& alias,
+        const std::string& cmdname);
 
             bool    handleCallback(int playerid, const char *cmdtext);
+    /**
+     * Forget the cooldowns of a leaving player.
+     */
+            void    resetPlayer(int playerid);
+
+protected:
+            void    _registerCommand(const std::string& cmdname,
+        CommandHandler handler, const std::string& usage,
+        const CommandOptions& options);
+            bool    _admit(Command& command, int playerid, int64_t now);
+    /**
+     * The names a command or subcommand is registered under, null if its
+     * parent doesn't exist.
+     */
+            std::unordered_map<std::string, Command*>* _namespaceOf(
+        const std::string& cmdname, std::string& leaf);
+
+    template<typename... Args, size_t... I>
+    static  int     _invoke(CommandResult (*handler)(int, Args...),
+        int playerid, CommandArgs& args, std::index_sequence<I...>)
+    {
+        std::tuple<typename CommandArgBinder<
+            typename std::decay<Args>::type>::Storage...> values;
+        bool parsed = true;
+        // Braced lists are evaluated in order, so are the arguments.
+        (void)std::initializer_list<int>{ (parsed = parsed &&
+            CommandArgBinder<typename std::decay<Args>::type>::parse(
+                args, std::get<I>(values)), 0)... };
+        (void)args;
+        (void)values;
+        if(!parsed) return -1;
+        return handler(playerid, CommandArgBinder<
+            typename std::decay<Args>::type>::get(std::get<I>(values))...);
+    }
+
+    template<typename... Args>
+    static  std::string _makeUsage()
+    {
+        std::string usage;
+        (void)std::initializer_list<int>{ (usage.append(usage.empty() ?
+            "" : " ").append(CommandArgHint<
+            typename std::decay<Args>::type>::get()), 0)... };
+        return usage;
+    }
 };
 
 }
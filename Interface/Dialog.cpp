@@ -50,8 +50,8 @@ bool MenuDialog::display()
     {
         message = ".";
     }
-    return ShowPlayerDialog(mPlayerId, 0, DIALOG_STYLE_LIST, mTitle.c_str(),
-        message.c_str(), "ȷ", "");
+    return ShowPlayerDialog(mPlayerId, mDialogId, DIALOG_STYLE_LIST,
+        mTitle.c_str(), message.c_str(), "ȷ", "");
 }
 
 bool MenuDialog::handleCallback(bool response, int listitem,
@@ -101,8 +101,8 @@ bool CheckListDialog::display()
     {
         message = ".";
     }
-    return ShowPlayerDialog(mPlayerId, 0, DIALOG_STYLE_LIST, mTitle.c_str(),
-        message.c_str(), "л", "");
+    return ShowPlayerDialog(mPlayerId, mDialogId, DIALOG_STYLE_LIST,
+        mTitle.c_str(), message.c_str(), "л", "");
 }
 
 bool CheckListDialog::handleCallback(bool response, int listitem,
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <vector>
 #include <sampgdk/a_samp.h>
@@ -28,13 +30,14 @@ class Dialog
 {
 protected:
     int             mPlayerId;
+    int             mDialogId;
     std::string     mTitle;
 
 public:
                     Dialog(
                         int playerid,
                         const std::string &title
-                    ) : mPlayerId(playerid), mTitle(title) {}
+                    ) : mPlayerId(playerid), mDialogId(0), mTitle(title) {}
     virtual         ~Dialog() {}
 
     virtual bool    display() = 0;
@@ -56,6 +59,15 @@ public:
 
             void    setTitle(const std::string& title)
             { mTitle = title; }
+
+    /**
+     * Set by DialogManager before each display.
+     */
+            int     getDialogId() const
+            { return mDialogId; }
+
+            void    setDialogId(int dialogid)
+            { mDialogId = dialogid; }
 };
 
 enum DialogType
@@ -139,7 +151,7 @@ public:
         {
             style = DIALOG_STYLE_MSGBOX;
         }
-        return ShowPlayerDialog(mPlayerId, 0, style, mTitle.c_str(),
+        return ShowPlayerDialog(mPlayerId, mDialogId, style, mTitle.c_str(),
             mMessage.c_str(), btn1, btn2) != 0;
     }
 };
@@ -266,7 +278,7 @@ public:
         {
             message = ".";
         }
-        return ShowPlayerDialog(mPlayerId, 0, DIALOG_STYLE_LIST,
+        return ShowPlayerDialog(mPlayerId, mDialogId, DIALOG_STYLE_LIST,
             mTitle.c_str(), message.c_str(), "ȷ", "");
     }
 
@@ -324,6 +336,196 @@ public:
     }
 };
 
+/**
+ * List dialog showing one page of items at a time, for lists that may not
+ * fit in a single SA-MP dialog. Items are pulled page by page through
+ * fetchPage() and the rendered page is kept until invalidate() is called,
+ * so coming back from a child dialog does not query them again.
+ * A page holds at most Config::dialogPageSize items and stops early if
+ * the text would exceed Config::dialogMaxBytes.
+ */
+template<typename KeyType>
+class PagedListDialog : public Dialog
+{
+protected:
+    struct Item
+    {
+        KeyType                     key;
+        std::string                 title;
+    };
+
+    std::vector<Item>               mItemList;
+    // Offsets of the first item of the pages visited so far.
+    std::vector<size_t>             mPageOffsets;
+    size_t                          mPage;
+    bool                            mHasPrev;
+    bool                            mHasNext;
+    bool                            mLoaded;
+    std::string                     mMessage;
+
+public:
+                    PagedListDialog(
+                        int playerid,
+                        const std::string &title
+                    ) : Dialog(playerid, title), mPageOffsets(1, 0),
+                        mPage(0), mHasPrev(false), mHasNext(false),
+                        mLoaded(false) {}
+
+    virtual         ~PagedListDialog() {}
+
+    virtual void    clear()
+    {
+        mItemList.clear();
+        mMessage.clear();
+        mHasPrev = mHasNext = false;
+    }
+
+            void    addItem(KeyType key, const std::string &title)
+    {
+        mItemList.push_back({key, title});
+    }
+
+    /**
+     * Drop the cached page, it will be fetched again on next display.
+     */
+            void    invalidate()
+    {
+        mLoaded = false;
+    }
+
+    virtual bool    build()
+    {
+        size_t pageSize = std::max<size_t>(Config::dialogPageSize, 1);
+        // One more item tells whether there is a next page.
+        if(!fetchPage(mPageOffsets[mPage], pageSize + 1)) return false;
+        if(mItemList.empty() && mPage > 0)
+        {
+            // The list shrank since the page was turned.
+            mPageOffsets.resize(mPage);
+            --mPage;
+            clear();
+            return build();
+        }
+        mHasPrev = mPage > 0;
+        mHasNext = mItemList.size() > pageSize;
+        if(mHasNext) mItemList.resize(pageSize);
+
+        const char* prevRow = "<< һҳ\n";
+        const char* nextRow = ">> һҳ\n";
+        size_t budget = Config::dialogMaxBytes - strlen(prevRow) -
+            strlen(nextRow);
+        std::string body;
+        size_t shown = 0;
+        for(; shown < mItemList.size(); ++shown)
+        {
+            const std::string& title = mItemList[shown].title;
+            size_t size = 2 + title.size() + 1;
+            if(body.size() + size <= budget)
+            {
+                body.append("  ").append(title).append("\n");
+                continue;
+            }
+            if(shown == 0)
+            {
+                // Always show something, even if it has to be cut.
+                body.append("  ").append(title, 0,
+                    _cut(title, budget - 3)).append("\n");
+                ++shown;
+            }
+            break;
+        }
+        if(shown < mItemList.size())
+        {
+            mItemList.resize(shown);
+            mHasNext = true;
+        }
+        if(mHasPrev) mMessage.append(prevRow);
+        mMessage.append(body);
+        if(mHasNext) mMessage.append(nextRow);
+        if(mPageOffsets.size() == mPage + 1)
+        {
+            mPageOffsets.push_back(mPageOffsets[mPage] + shown);
+        }
+        else
+        {
+            mPageOffsets[mPage + 1] = mPageOffsets[mPage] + shown;
+        }
+        return true;
+    }
+
+    virtual bool    display()
+    {
+        if(!mLoaded)
+        {
+            clear();
+            if(!build()) return false;
+            mLoaded = true;
+        }
+        const char* message = mMessage.empty() ? "." : mMessage.c_str();
+        return ShowPlayerDialog(mPlayerId, mDialogId, DIALOG_STYLE_LIST,
+            mTitle.c_str(), message, "ȷ", "");
+    }
+
+    virtual bool    handleCallback(
+        bool response, int listitem, const std::string& /*inputtext*/)
+    {
+        if(!response)
+        {
+            return true;
+        }
+        if(mHasPrev)
+        {
+            if(listitem == 0)
+            {
+                --mPage;
+                invalidate();
+                return false;
+            }
+            --listitem;
+        }
+        if(static_cast<size_t>(listitem) == mItemList.size() && mHasNext)
+        {
+            ++mPage;
+            invalidate();
+            return false;
+        }
+        if(static_cast<size_t>(listitem) + 1 > mItemList.size())
+        {
+            LOG(ERROR) << "listitem > mItemList.size()";
+            return false;
+        }
+        return process(mItemList[listitem].key);
+    }
+
+    /**
+     * Add up to limit items through addItem(), skipping the first offset
+     * ones. The order must be stable between calls.
+     */
+    virtual bool    fetchPage(size_t offset, size_t limit) = 0;
+    /**
+     * The return value indicates whether the dialog can be closed.
+     */
+    virtual bool    process(KeyType key) = 0;
+
+protected:
+    /**
+     * Length of the longest prefix of text within size bytes, without
+     * splitting a double-byte GBK character.
+     */
+    static  size_t  _cut(const std::string& text, size_t size)
+    {
+        size_t i = 0;
+        while(i < text.size())
+        {
+            size_t next = static_cast<unsigned char>(text[i]) > 0x80 ?
+                i + 2 : i + 1;
+            if(next > size) break;
+            i = next;
+        }
+        return i;
+    }
+};
+
 class CheckListDialog : public Dialog
 {
 protected:
@@ -20,49 +20,135 @@
 
 namespace swcu {
 
+DialogManager::DialogManager() :
+    mStale(&Metrics::get().counter("swcu_dialog_stale_total", "",
+        "Dialog responses dropped for not answering the shown dialog."))
+{
+    for(auto& player : mPlayers)
+    {
+        player.lastId   = 0;
+        player.shownId  = 0;
+    }
+}
+
+DialogManager::~DialogManager()
+{
+    for(int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        clearPlayerStack(i);
+    }
+    for(auto& pool : mPools)
+    {
+        for(void* block : pool)
+        {
+            ::operator delete(block);
+        }
+    }
+}
+
 void DialogManager::clearPlayerStack(int playerid)
 {
-    mPlayerDialogStacks.erase(playerid);
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    PlayerDialogs& player = mPlayers[playerid];
+    while(!player.stack.empty())
+    {
+        _pop(player);
+    }
+    player.shownId = 0;
 }
 
-bool DialogManager::handleCallback(int playerid, int /* dialogid */,
+bool DialogManager::handleCallback(int playerid, int dialogid,
     int response, int listitem, const std::string &inputtext)
 {
-    auto iter = mPlayerDialogStacks.find(playerid);
-    if(iter == mPlayerDialogStacks.end())
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS)
     {
-        LOG(ERROR) << "A dialog callback is called while there is no "
-            "such a dialog or the player trigger it is disconnected.";
+        LOG(ERROR) << "A dialog callback is called by invalid player id "
+            << playerid;
         return false;
     }
-    size_t size = iter->second.size();
+    PlayerDialogs& player = mPlayers[playerid];
+    size_t size = player.stack.size();
     if(size == 0)
     {
         LOG(ERROR) << "A dialog callback is called while the player's "
             "dialog stack is empty";
         return false;
     }
-    auto top = iter->second.top().get();
+    if(dialogid != player.shownId)
+    {
+        // Answer to a dialog that has been replaced since.
+        mStale->inc();
+        return false;
+    }
+    player.shownId = 0;
+    auto top = player.stack.back().dialog;
     bool canpop = top->handleCallback(response != 0, listitem, inputtext);
     /**
      * If oldSize != newSize after invoking handleCallback,
      * there must be a new dialog pushed into the stack,
      * therefore we should not pop the new top.
      */
-    if(canpop && size == iter->second.size())
+    if(canpop && size == player.stack.size())
     {
-        iter->second.pop();
+        _pop(player);
     }
     // find first dialog which wants to display
-    while(iter->second.size() > 0)
+    while(player.stack.size() > 0)
     {
-        top = iter->second.top().get();
-        if(top->display())
+        top = player.stack.back().dialog;
+        if(_display(playerid, top))
             break;
         else
-            iter->second.pop();
+            _pop(player);
     }
     return true;
 }
 
+size_t DialogManager::_newPool()
+{
+    static size_t count = 0;
+    return count++;
+}
+
+void* DialogManager::_acquire(size_t pool, size_t size)
+{
+    if(pool < mPools.size() && !mPools[pool].empty())
+    {
+        void* block = mPools[pool].back();
+        mPools[pool].pop_back();
+        return block;
+    }
+    return ::operator new(size);
+}
+
+void DialogManager::_recycle(size_t pool, void* block)
+{
+    if(pool >= mPools.size()) mPools.resize(pool + 1);
+    if(mPools[pool].size() < MAX_POOLED)
+    {
+        mPools[pool].push_back(block);
+    }
+    else
+    {
+        ::operator delete(block);
+    }
+}
+
+void DialogManager::_pop(PlayerDialogs& player)
+{
+    StackEntry entry = player.stack.back();
+    player.stack.pop_back();
+    entry.dialog->~Dialog();
+    _recycle(entry.pool, entry.block);
+}
+
+bool DialogManager::_display(int playerid, Dialog* dialog)
+{
+    PlayerDialogs& player = mPlayers[playerid];
+    player.lastId   = player.lastId % MAX_DIALOG_ID + 1;
+    player.shownId  = player.lastId;
+    dialog->setDialogId(player.shownId);
+    return dialog->display();
+}
+
 }
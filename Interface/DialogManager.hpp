@@ -16,57 +16,104 @@
 
 #pragma once
 
-#include <memory>
-#include <stack>
-#include <unordered_map>
+#include <array>
+#include <new>
+#include <vector>
 
+#include "../Utility/SmallVector.hpp"
 #include "../Utility/Singleton.hpp"
 
 #include "Dialog.hpp"
 
 namespace swcu {
 
+class Counter;
+
+/**
+ * Keeps a stack of dialogs for each player, the top one being shown.
+ * Each display gets a new dialog id, and responses not carrying the id
+ * last shown to the player are dropped, so a late answer to a replaced
+ * dialog can't act on the one above it.
+ * Memory of popped dialogs is kept per type for the next push.
+ */
 class DialogManager : public Singleton<DialogManager>
 {
+public:
+    // Dialog ids shown cycle through 1 to this, the largest the client
+    // accepts.
+    static const int                MAX_DIALOG_ID       = 32767;
+    // Free blocks kept per dialog type.
+    static const size_t             MAX_POOLED          = 8;
+
 protected:
-    typedef std::unique_ptr<Dialog>                 DialogPtr;
-    typedef std::stack<DialogPtr>                   DialogStack;
-    typedef std::unordered_map<int, DialogStack>    DialogStackMap;
+    struct StackEntry
+    {
+        Dialog*                     dialog;
+        void*                       block;
+        size_t                      pool;
+    };
+
+    struct PlayerDialogs
+    {
+        SmallVector<StackEntry, 4>  stack;
+        int                         lastId;
+        // Id of the dialog the player is looking at, or 0.
+        int                         shownId;
+    };
 
-    DialogStackMap                                  mPlayerDialogStacks;
+    std::array<PlayerDialogs, MAX_PLAYERS> mPlayers;
+    std::vector<std::vector<void*>> mPools;
+    Counter*                        mStale;
 
 protected:
-                    DialogManager() {}
+                    DialogManager();
     friend class Singleton<DialogManager>;
     
 public:
-    virtual         ~DialogManager() {}
+    virtual         ~DialogManager();
 
             void    clearPlayerStack(int playerid);
 
     template<typename DialogType, typename...Args>
             void    push(int playerid, Args...args)
     {
-        DialogType*             playerDialogPtr
-            = new DialogType(playerid, std::move(args)...);
-        std::unique_ptr<Dialog> playerDialogPtrWrap(playerDialogPtr);
-
-        mPlayerDialogStacks[playerid].push(std::move(playerDialogPtrWrap));
-        playerDialogPtr->display();
+        if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+        size_t pool = _poolOf<DialogType>();
+        void* block = _acquire(pool, sizeof(DialogType));
+        DialogType* playerDialogPtr;
+        try
+        {
+            playerDialogPtr = new(block) DialogType(
+                playerid, std::move(args)...);
+        }
+        catch(...)
+        {
+            _recycle(pool, block);
+            throw;
+        }
+        mPlayers[playerid].stack.push_back({playerDialogPtr, block, pool});
+        _display(playerid, playerDialogPtr);
     }
 
+            bool    handleCallback(int playerid, int dialogid,
+        int response, int listitem, const std::string &inputtext);
+
+protected:
     template<typename DialogType>
-            void    push(int playerid)
+    static  size_t  _poolOf()
     {
-        DialogType*             playerDialogPtr = new DialogType(playerid);
-        std::unique_ptr<Dialog> playerDialogPtrWrap(playerDialogPtr);
-
-        mPlayerDialogStacks[playerid].push(std::move(playerDialogPtrWrap));
-        playerDialogPtr->display();
+        static const size_t pool = _newPool();
+        return pool;
     }
+    static  size_t  _newPool();
 
-            bool    handleCallback(int playerid, int dialogid,
-        int response, int listitem, const std::string &inputtext);
+            void*   _acquire(size_t pool, size_t size);
+            void    _recycle(size_t pool, void* block);
+            void    _pop(PlayerDialogs& player);
+    /**
+     * Show the dialog under a new id.
+     */
+            bool    _display(int playerid, Dialog* dialog);
 };
 
 }
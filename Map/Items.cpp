@@ -19,6 +19,7 @@
 
 
 #include "../Streamer/Streamer.hpp"
+#include "../Vehicle/VehicleManager.hpp"
 
 #include "Items.hpp"
 
@@ -110,18 +111,25 @@ Object::~Object()
 }
 
 mongo::BSONObj Object::_buildDocument()
+{
+    return _buildDocument(mMap, { mModel, mX, mY, mZ, mRX, mRY, mRZ },
+        mInterior, mEditable);
+}
+
+mongo::BSONObj Object::_buildDocument(const mongo::OID& map,
+    const ObjectPlacement& placement, int interior, bool editable)
 {
     return BSON(
-        "map"       << mMap <<
-        "model"     << mModel <<
-        "x"         << mX <<
-        "y"         << mY <<
-        "z"         << mZ <<
-        "rx"        << mRX <<
-        "ry"        << mRY <<
-        "rz"        << mRZ <<
-        "interior"  << mInterior <<
-        "editable"  << mEditable
+        "map"       << map <<
+        "model"     << placement.model <<
+        "x"         << placement.x <<
+        "y"         << placement.y <<
+        "z"         << placement.z <<
+        "rx"        << placement.rx <<
+        "ry"        << placement.ry <<
+        "rz"        << placement.rz <<
+        "interior"  << interior <<
+        "editable"  << editable
     );
 }
 
@@ -173,10 +181,10 @@ bool Object::remove()
 {
     if(!mValid) return false;
     MONGO_WRAPPER({
-        getDBConn()->remove(
+        MONGO_TIMED(Config::colNameMapObject, "remove", getDBConn()->remove(
             Config::colNameMapObject,
             QUERY("_id" << mId)
-        );
+        ));
         dbCheckError();
         LOG(INFO) << "Object " << mId.str() << " is removed.";
         DestroyDynamicObject(mInGameID);
@@ -244,28 +252,38 @@ LandscapeVehicle::LandscapeVehicle(
 
 LandscapeVehicle::~LandscapeVehicle()
 {
+    VehicleManager::get().handleVehicleDestroyed(mInGameID);
     DestroyVehicle(mInGameID);
 }
 
 mongo::BSONObj LandscapeVehicle::_buildDocument()
+{
+    return _buildDocument(mMap, { mModel, mX, mY, mZ, mAngle }, mInterior,
+        mRespawnDelay);
+}
+
+mongo::BSONObj LandscapeVehicle::_buildDocument(const mongo::OID& map,
+    const VehiclePlacement& placement, int interior, int respawndelay)
 {
     return BSON(
-        "map"           << mMap <<
-        "model"         << mModel <<
-        "x"             << mX <<
-        "y"             << mY <<
-        "z"             << mZ <<
-        "rotate"        << mAngle <<
-        "interior"      << mInterior <<
-        "respawndelay"  << mRespawnDelay
+        "map"           << map <<
+        "model"         << placement.model <<
+        "x"             << placement.x <<
+        "y"             << placement.y <<
+        "z"             << placement.z <<
+        "rotate"        << placement.angle <<
+        "interior"      << interior <<
+        "respawndelay"  << respawndelay
     );
 }
 
-void LandscapeVehicle::respawn()
+bool LandscapeVehicle::respawn()
 {
+    if(VehicleManager::get().isOccupied(mInGameID)) return false;
     SetVehicleToRespawn(mInGameID);
     SetVehicleVirtualWorld(mInGameID, mWorld);
     LinkVehicleToInterior(mInGameID, mInterior);
+    return true;
 }
 
 }
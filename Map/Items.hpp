@@ -22,6 +22,22 @@
 
 namespace swcu {
 
+/**
+ * Where to put an object or a vehicle, as read from map code before it is
+ * stored.
+ */
+struct ObjectPlacement
+{
+    int                 model;
+    float               x, y, z, rx, ry, rz;
+};
+
+struct VehiclePlacement
+{
+    int                 model;
+    float               x, y, z, angle;
+};
+
 class Object : public StorableObject
 {
     friend class Map;
@@ -46,6 +62,11 @@ protected:
     virtual bool        _parseObject(const mongo::BSONObj& data);
             bool        _createDynamicObject();
             mongo::BSONObj  _buildDocument();
+    /**
+     * The stored fields, also used by Map for bulk inserts.
+     */
+    static  mongo::BSONObj  _buildDocument(const mongo::OID& map,
+        const ObjectPlacement& placement, int interior, bool editable);
 
 public:
     /**
@@ -87,6 +108,8 @@ protected:
     virtual bool        _parseObject(const mongo::BSONObj& data);
             bool        _createVehicle();
             mongo::BSONObj _buildDocument();
+    static  mongo::BSONObj _buildDocument(const mongo::OID& map,
+        const VehiclePlacement& placement, int interior, int respawndelay);
 
 public:
     /**
@@ -106,7 +129,11 @@ public:
             int         getInGameID() const { return mInGameID; }
             mongo::OID  getMap() const
             { return mMap; }
-            void        respawn();
+    /**
+     * Vehicles with someone inside are left where they are.
+     * @return Whether the vehicle was respawned.
+     */
+            bool        respawn();
 };
 
 /*
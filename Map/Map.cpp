@@ -81,10 +81,10 @@ Map::Map(MapType type, int world, const mongo::OID& owner,
     const std::string& name) : Map::Map()
 {
     mType = type; mOwner = owner; mVirtualWorld = world;
-    mName = name;
+    mName = DualString::fromGBK(name);
     if(_createObject(BSON(
         "type"          << mType            <<
-        "name"          << GBKToUTF8(mName) <<
+        "name"          << mName.utf8()     <<
         "owner"         << mOwner           <<
         "activated"     << mActivated       <<
         "world"         << mVirtualWorld
@@ -96,8 +96,8 @@ Map::Map(MapType type, int world, const mongo::OID& owner,
 
 Map::Map(const std::string& name) : Map::Map()
 {
-    mName = name;
-    _loadObject("name", GBKToUTF8(name));
+    mName = DualString::fromGBK(name);
+    _loadObject("name", mName.utf8());
 }
 
 Map::Map(const mongo::BSONObj& data) : Map::Map()
@@ -111,25 +111,37 @@ Map::Map(const mongo::BSONObj& data) : Map::Map()
     });
 }
 
-std::string Map::getTypeStr() const
+namespace {
+
+/**
+ * Names of the map types, the last one for unknown types.
+ */
+const DualString& getTypeName(MapType type)
 {
-    switch(mType)
-    {
-        case LANDSCAPE:
-        return "";
-        case DEATHMATCH:
-        return "";
-        case STUNT:
-        return "ؼ";
-        case PROPERTY:
-        return "";
-        case BUSINESS:
-        return "";
-        case PRISON:
-        return "";
-        default:
-        return "δ֪";
-    }
+    static const DualString names[] = {
+        DualString::fromGBK(""),
+        DualString::fromGBK(""),
+        DualString::fromGBK("ؼ"),
+        DualString::fromGBK(""),
+        DualString::fromGBK(""),
+        DualString::fromGBK(""),
+        DualString::fromGBK("δ֪")
+    };
+    const size_t count = sizeof(names) / sizeof(names[0]);
+    size_t index = static_cast<size_t>(type);
+    return names[index < count - 1 ? index : count - 1];
+}
+
+}
+
+const std::string& Map::getTypeStr() const
+{
+    return getTypeName(mType).gbk();
+}
+
+const std::string& Map::getTypeStrUTF8() const
+{
+    return getTypeName(mType).utf8();
 }
 
 std::shared_ptr<Object> Map::addObject(int model, float x, float y, float z,
@@ -159,6 +171,70 @@ bool Map::addVehicle(int model, float x, float y, float z,
     return false;
 }
 
+size_t Map::addObjects(const std::vector<ObjectPlacement>& objects)
+{
+    if(objects.empty()) return 0;
+    std::vector<mongo::BSONObj> docs;
+    docs.reserve(objects.size());
+    for(auto& i : objects)
+    {
+        // The id is set here, the objects are made from the documents.
+        mongo::BSONObjBuilder b;
+        b.append("_id", mongo::OID::gen()).appendElements(
+            Object::_buildDocument(mId, i, -1, false));
+        docs.push_back(b.obj());
+    }
+    MONGO_WRAPPER({
+        MONGO_TIMED(Config::colNameMapObject, "insert",
+            getDBConn()->insert(Config::colNameMapObject, docs));
+        if(!dbCheckError()) return 0;
+        size_t added = 0;
+        for(auto& doc : docs)
+        {
+            std::shared_ptr<Object> obj(new Object(doc, mVirtualWorld));
+            if(obj->isValid())
+            {
+                mObjects.push_back(std::move(obj));
+                ++added;
+            }
+        }
+        return added;
+    });
+    return 0;
+}
+
+size_t Map::addVehicles(const std::vector<VehiclePlacement>& vehicles)
+{
+    if(vehicles.empty()) return 0;
+    std::vector<mongo::BSONObj> docs;
+    docs.reserve(vehicles.size());
+    for(auto& i : vehicles)
+    {
+        mongo::BSONObjBuilder b;
+        b.append("_id", mongo::OID::gen()).appendElements(
+            LandscapeVehicle::_buildDocument(mId, i, 0, 60));
+        docs.push_back(b.obj());
+    }
+    MONGO_WRAPPER({
+        MONGO_TIMED(Config::colNameMapVehicle, "insert",
+            getDBConn()->insert(Config::colNameMapVehicle, docs));
+        if(!dbCheckError()) return 0;
+        size_t added = 0;
+        for(auto& doc : docs)
+        {
+            std::unique_ptr<LandscapeVehicle>
+                veh(new LandscapeVehicle(doc, mVirtualWorld));
+            if(veh->isValid())
+            {
+                mVehicles.push_back(std::move(veh));
+                ++added;
+            }
+        }
+        return added;
+    });
+    return 0;
+}
+
 bool Map::setWorld(int world)
 {
     if(_updateField("$set", "world", world))
@@ -194,9 +270,10 @@ bool Map::setPrice(size_t price)
 
 bool Map::setName(const std::string& name)
 {
-    if(_updateField("$set", "name", GBKToUTF8(name)))
+    DualString newName = DualString::fromGBK(name);
+    if(_updateField("$set", "name", newName.utf8()))
     {
-        mName = name;
+        mName = newName;
         LOG(INFO) << "Map " << mName << "'s name is set to " << name;
         return true;
     }
@@ -419,7 +496,7 @@ bool Map::_parseObject(const mongo::BSONObj& data)
 {
     MONGO_WRAPPER({
         mType           = MapType(data["type"].numberInt());
-        mName           = UTF8ToGBK(data["name"].str());
+        mName           = DualString::fromUTF8(data["name"].str());
         mOwner          = data["owner"].OID();
         mActivated      = data["activated"].boolean();
         mVirtualWorld   = data["world"].numberInt();
@@ -440,10 +517,11 @@ bool Map::_parseObject(const mongo::BSONObj& data)
             setEntrance("");
         }
 
-        auto objcur = getDBConn()->query(
+        auto objcur = MONGO_TIMED(Config::colNameMapObject, "query",
+            getDBConn()->query(
             Config::colNameMapObject,
             QUERY("map" << mId)
-        );
+        ));
         while(objcur->more())
         {
             auto doc = objcur->next();
@@ -452,10 +530,11 @@ bool Map::_parseObject(const mongo::BSONObj& data)
         }
         LOG(INFO) << "Loaded " << mObjects.size() << " object(s).";
 
-        auto vehcur = getDBConn()->query(
+        auto vehcur = MONGO_TIMED(Config::colNameMapVehicle, "query",
+            getDBConn()->query(
             Config::colNameMapVehicle,
             QUERY("map" << mId)
-        );
+        ));
         while(vehcur->more())
         {
             auto doc = vehcur->next();
@@ -478,8 +557,8 @@ std::string Map::getJSON() const
     json <<
     "{\n"
     "  \"id\": \""      << mId.str() << "\",\n"
-    "  \"name\": \""    << GBKToUTF8(mName) << "\",\n"
-    "  \"type\": \""      << GBKToUTF8(getTypeStr()) << "\",\n"
+    "  \"name\": \""    << mName.utf8() << "\",\n"
+    "  \"type\": \""      << getTypeStrUTF8() << "\",\n"
     "  \"owner\": \""   << mOwner.str() << "\",\n"
     "  \"activated\": " << (mActivated ? "true,\n" : "false,\n") <<
     "  \"world\": "     << mVirtualWorld << "\n"
@@ -495,20 +574,20 @@ bool Map::deleteFromDatabase()
         return false;
     }
     MONGO_WRAPPER({
-        getDBConn()->remove(
+        MONGO_TIMED(Config::colNameMapObject, "remove", getDBConn()->remove(
             Config::colNameMapObject,
             QUERY("map" << mId)
-        );
+        ));
         dbCheckError();
-        getDBConn()->remove(
+        MONGO_TIMED(Config::colNameMapVehicle, "remove", getDBConn()->remove(
             Config::colNameMapVehicle,
             QUERY("map" << mId)
-        );
+        ));
         dbCheckError();
-        getDBConn()->remove(
+        MONGO_TIMED(Config::colNameMap, "remove", getDBConn()->remove(
             Config::colNameMap,
             QUERY("_id" << mId)
-        );
+        ));
         dbCheckError();
         LOG(INFO) << "Map " << mName << " is removed.";
         mValid = false;
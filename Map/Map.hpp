@@ -21,6 +21,7 @@
 #include <kanko/Common/Vector3.hpp>
 #include <kanko/Common/BBox.hpp>
 
+#include "../Common/DualString.hpp"
 #include "../Common/StorableObject.hpp"
 #include "../Area/Area.hpp"
 #include "Items.hpp"
@@ -81,7 +82,7 @@ protected:
      * If the id is not set, the map is not saved yet.
      */
     MapType             mType;
-    std::string         mName;
+    DualString          mName;
     bool                mActivated;
     int                 mVirtualWorld;
     kanko::Vector3      mBoundSphereCenter;
@@ -119,8 +120,12 @@ public:
                         Map(const mongo::BSONObj& data);
     virtual             ~Map() {}
             bool        setName(const std::string& name);
-            std::string getName() const         { return mName; }
-            std::string getTypeStr() const;
+            const std::string& getName() const
+            { return mName.gbk(); }
+            const std::string& getNameUTF8() const
+            { return mName.utf8(); }
+            const std::string& getTypeStr() const;
+            const std::string& getTypeStrUTF8() const;
             MapType     getType() const         { return mType; }
             bool        setType(MapType type);
             bool        isActivated() const     { return mActivated; }
@@ -131,6 +136,15 @@ public:
         float rx, float ry, float rz, bool editable, int interior);
             bool        addVehicle(int model, float x, float y, float z,
         float angle, int interior, int respawndelay);
+    /**
+     * Bulk versions of addObject() and addVehicle() for imports. The
+     * documents are written with a single insert, then the items are
+     * created from them. Objects are not editable.
+     * @return Amount of items added.
+     */
+            size_t      addObjects(const std::vector<ObjectPlacement>& objects);
+            size_t      addVehicles(
+        const std::vector<VehiclePlacement>& vehicles);
             bool        setWorld(int world);
 
             bool        setOwner(const mongo::OID& owner);
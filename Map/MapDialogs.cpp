@@ -52,29 +52,31 @@ bool MapManagerDialog::build()
 
 MapViewDialog::MapViewDialog(int playerid, const std::string& title,
         Callback callback, Filter filter) :
-    ItemListDialog<std::shared_ptr<Map>>(playerid, title)
+    PagedListDialog<std::shared_ptr<Map>>(playerid, title)
     , mCallback(callback), mFilter(filter)
 {
 }
 
-bool MapViewDialog::build()
+bool MapViewDialog::fetchPage(size_t offset, size_t limit)
 {
     MapManager& mgr = MapManager::get();
+    size_t matched = 0;
     for(auto& iter : mgr.mLoadedMaps)
     {
-        if(mFilter(iter.second))
-        {
-            addItem(
-                iter.second,
-                STR(iter.second->getTypeStr() << " " << iter.first)
-            );
-        }
+        if(!mFilter(iter.second)) continue;
+        if(matched++ < offset) continue;
+        addItem(
+            iter.second,
+            FORMAT("{} {}", iter.second->getTypeStr(), iter.first).str()
+        );
+        if(matched - offset == limit) break;
     }
     return true;
 }
 
 bool MapViewDialog::process(std::shared_ptr<Map> key)
 {
+    invalidate();
     mCallback(key);
     return true;
 }
@@ -121,7 +123,7 @@ bool MapEditDialog::build()
 }
 
 MapSetTypeDialog::MapSetTypeDialog(int playerid, std::shared_ptr<Map> m) :
-    RadioListDialog<MapType>(playerid, STR(" " << m->getName() << " ")),
+    RadioListDialog<MapType>(playerid, FORMAT(" {} ", m->getName()).str()),
     mMap(std::move(m))
 {
 }
@@ -144,7 +146,7 @@ bool MapSetTypeDialog::process(MapType type)
 
 MapAddObjectDialog::MapAddObjectDialog(int playerid,
     const std::shared_ptr<Map>& map) :
-    ItemListDialog<int>(playerid, STR(" " << map->getName() <<  " ")),
+    ItemListDialog<int>(playerid, FORMAT(" {} ", map->getName()).str()),
     mMap(map)
 {
 }
@@ -278,7 +280,7 @@ bool PropertyEditDialog::build()
            DialogManager::get().push<PropertySetNameDialog>(
                 playerid, map);
         });
-        addItem(STR("۸: " << mMap->getPrice()), [=](){
+        addItem(FORMAT("۸: {}", mMap->getPrice()).str(), [=](){
             auto p = PlayerManager::get().getPlayer(playerid);
             if(p == nullptr || !p->isLoggedIn())
             {
@@ -330,7 +332,7 @@ bool PropertyEditDialog::build()
     else
     {
         addItem(": " + mMap->getName(), [](){});
-        addItem(STR("۸: " << mMap->getPrice()), [=](){
+        addItem(FORMAT("۸: {}", mMap->getPrice()).str(), [=](){
             auto p = PlayerManager::get().getPlayer(playerid);
             if(p == nullptr || !p->isLoggedIn())
             {
@@ -35,7 +35,7 @@ public:
     virtual bool    build();
 };
 
-class MapViewDialog : public ItemListDialog<std::shared_ptr<Map>>
+class MapViewDialog : public PagedListDialog<std::shared_ptr<Map>>
 {
 public:
     typedef std::function<bool(const std::shared_ptr<Map>&)> Filter;
@@ -52,7 +52,7 @@ public:
         Filter filter = [](const std::shared_ptr<Map>&) { return true; });
     virtual         ~MapViewDialog() {}
 
-    virtual bool    build();
+    virtual bool    fetchPage(size_t offset, size_t limit);
     virtual bool    process(std::shared_ptr<Map> key);
 };
 
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+
+#include "../Common/Common.hpp"
+
+#include "MapManager.hpp"
+#include "MapImporter.hpp"
+
+namespace swcu {
+
+MapImporter::MapImporter(std::shared_ptr<Map> map) :
+    mMap(std::move(map)),
+    mParser([this](const std::string& function, const float* args,
+        size_t argc) { _onCall(function, args, argc); }),
+    mObjectCount(0), mVehicleCount(0), mParsedCount(0)
+{
+    mObjects.reserve(Config::mapImportBatchSize);
+    mVehicles.reserve(Config::mapImportBatchSize);
+}
+
+bool MapImporter::feed(const char* data, size_t size)
+{
+    if(isOverLimit()) return false;
+    mParser.feed(data, size);
+    return !isOverLimit();
+}
+
+void MapImporter::finish()
+{
+    mParser.finish();
+    _flushObjects();
+    _flushVehicles();
+    mMap->updateBounding();
+}
+
+bool MapImporter::isOverLimit() const
+{
+    return mParsedCount > Config::mapImportMaxItems;
+}
+
+void MapImporter::_onCall(const std::string& function, const float* args,
+    size_t argc)
+{
+    bool object     = function == "CreateObject" ||
+        function == "CreateDynamicObject";
+    bool vehicle    = function == "CreateVehicle" ||
+        function == "AddStaticVehicle" || function == "AddStaticVehicleEx";
+    if(!object && !vehicle) return;
+    if(++mParsedCount > Config::mapImportMaxItems) return;
+
+    size_t needed = object ? 7 : 5;
+    bool valid = argc >= needed;
+    for(size_t i = 0; valid && i < needed; ++i)
+    {
+        valid = std::isfinite(args[i]);
+    }
+    if(!valid)
+    {
+        LOG(WARNING) << "Skipped a call to " << function <<
+            " with unsupported arguments.";
+        return;
+    }
+
+    if(object)
+    {
+        ObjectPlacement obj = {
+            static_cast<int>(args[0]),
+            args[1], args[2], args[3], args[4], args[5], args[6]
+        };
+        mObjects.push_back(obj);
+        if(mObjects.size() >= Config::mapImportBatchSize) _flushObjects();
+    }
+    else
+    {
+        VehiclePlacement veh = {
+            static_cast<int>(args[0]), args[1], args[2], args[3], args[4]
+        };
+        mVehicles.push_back(veh);
+        if(mVehicles.size() >= Config::mapImportBatchSize) _flushVehicles();
+    }
+}
+
+void MapImporter::_flushObjects()
+{
+    mObjectCount += mMap->addObjects(mObjects);
+    mObjects.clear();
+}
+
+void MapImporter::_flushVehicles()
+{
+    mVehicleCount += mMap->addVehicles(mVehicles);
+    mVehicles.clear();
+}
+
+std::string MapImportProgress::getJSON() const
+{
+    std::stringstream json;
+    json <<
+    "{\n"
+    "  \"received\": "  << received << ",\n"
+    "  \"total\": "     << total << ",\n"
+    "  \"objects\": "   << objects << ",\n"
+    "  \"vehicles\": "  << vehicles << ",\n"
+    "  \"finished\": "  << (finished ? "true" : "false") << ",\n"
+    "  \"failed\": "    << (failed ? "true\n" : "false\n") <<
+    "}";
+    return json.str();
+}
+
+namespace {
+
+// Longest name or type accepted, the rest is dropped.
+const size_t MAX_FIELD = 256;
+
+}
+
+MapUploadHandler::MapUploadHandler(
+    std::shared_ptr<MapImportProgress> progress, std::string error) :
+    mProgress(std::move(progress)),
+    mDecoder(
+        [this](const std::string& name, const char* data, size_t size) {
+            _onValue(name, data, size);
+        },
+        [](const std::string& /* name */) {}
+    ),
+    mError(std::move(error))
+{
+}
+
+MapUploadHandler::~MapUploadHandler()
+{
+    if(mProgress->finished) return;
+    // The connection was lost halfway, don't leave half a map behind.
+    if(mImporter != nullptr)
+    {
+        LOG(WARNING) << "Import of map " << mMap->getName() <<
+            " was interrupted.";
+        mMap->deleteFromDatabase();
+    }
+    // Otherwise the import stays tracked forever.
+    mProgress->failed   = true;
+    mProgress->finished = true;
+}
+
+bool MapUploadHandler::on_content(const char* data, size_t size)
+{
+    mProgress->received += size;
+    if(!mDecoder.feed(data, size))
+    {
+        mError = "表单格式错误.";
+    }
+    return mError.empty() &&
+        (mImporter == nullptr || !mImporter->isOverLimit());
+}
+
+void MapUploadHandler::on_end(HTTPResponse& response)
+{
+    mDecoder.finish();
+    // A form without any code still makes an empty map.
+    if(mError.empty() && mImporter == nullptr) _beginImport();
+    if(mImporter != nullptr)
+    {
+        mImporter->finish();
+        if(mImporter->isOverLimit())
+        {
+            std::ostringstream msg;
+            msg << "地图添加失败, 物件和交通工具总数不能超过 " <<
+                Config::mapImportMaxItems << " 个.";
+            mError = msg.str();
+        }
+    }
+    if(!mError.empty())
+    {
+        mProgress->failed   = true;
+        mProgress->finished = true;
+        if(mImporter != nullptr) mMap->deleteFromDatabase();
+        writeResponse(response, 200, CONTENT_TYPE_TEXT_PLAIN,
+            std::move(mError));
+        return;
+    }
+
+    mProgress->objects  = mImporter->getObjectCount();
+    mProgress->vehicles = mImporter->getVehicleCount();
+    mProgress->finished = true;
+    MapManager::get().mLoadedMaps.insert(
+        std::make_pair(mMap->getName(), mMap));
+
+    std::ostringstream msg;
+    msg << "地图添加成功\n"
+        "名称: " << mMap->getNameUTF8() << "\n"
+        "交通工具数量: " << mMap->getVehicleCount() << "\n"
+        "Obj数量: " << mMap->getObjectCount();
+    writeResponse(response, 200, CONTENT_TYPE_TEXT_PLAIN, msg.str());
+}
+
+void MapUploadHandler::_onValue(const std::string& name, const char* data,
+    size_t size)
+{
+    if(!mError.empty()) return;
+    if(name == "code")
+    {
+        if(mImporter == nullptr && !_beginImport()) return;
+        mImporter->feed(data, size);
+        mProgress->objects  = mImporter->getObjectCount();
+        mProgress->vehicles = mImporter->getVehicleCount();
+    }
+    else if(name == "name" || name == "type")
+    {
+        std::string& field = name == "name" ? mName : mType;
+        field.append(data, std::min(size, MAX_FIELD - field.size()));
+    }
+}
+
+bool MapUploadHandler::_beginImport()
+{
+    std::string name = mName;
+    boost::algorithm::trim(name);
+    std::shared_ptr<Map> map(new Map(MapType(atoi(mType.c_str())), -1,
+        mongo::OID(), UTF8ToGBK(name)));
+    if(!map->isValid())
+    {
+        mError = "地图添加失败, 可能是已经有重名的地图, "
+            "或者服务器发生了错误, 请检查SAMP服务器日志.";
+        return false;
+    }
+    mMap = map;
+    mImporter.reset(new MapImporter(map));
+    return true;
+}
+
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "../Web/WebServiceManager.hpp"
+#include "../Web/FormStreamDecoder.hpp"
+
+#include "Map.hpp"
+#include "PawnMapParser.hpp"
+
+namespace swcu {
+
+/**
+ * Fills a map with the objects and vehicles found in Pawn map code.
+ * It parses:
+ * CreateObject|CreateDynamicObject(model, x, y, z, rx, ry, rz)
+ * CreateVehicle|AddStaticVehicle|AddStaticVehicleEx
+ *     (model, x, y, z, angle, color1, color2)
+ * The code may be fed in pieces. Parsed items are stored in batches of
+ * Config::mapImportBatchSize, so that neither the code nor the items are
+ * ever held whole.
+ */
+class MapImporter
+{
+protected:
+    std::shared_ptr<Map>            mMap;
+    PawnMapParser                   mParser;
+    std::vector<ObjectPlacement>    mObjects;
+    std::vector<VehiclePlacement>   mVehicles;
+    size_t                          mObjectCount;
+    size_t                          mVehicleCount;
+    size_t                          mParsedCount;
+
+public:
+    explicit                        MapImporter(std::shared_ptr<Map> map);
+
+    /**
+     * @return False once more than Config::mapImportMaxItems items were
+     *         found. The rest of the code should not be fed then.
+     */
+            bool                    feed(const char* data, size_t size);
+    /**
+     * Store what's left and update the bounding of the map.
+     */
+            void                    finish();
+
+            bool                    isOverLimit() const;
+            size_t                  getObjectCount() const
+            { return mObjectCount; }
+            size_t                  getVehicleCount() const
+            { return mVehicleCount; }
+
+protected:
+            void                    _onCall(const std::string& function,
+                const float* args, size_t argc);
+            void                    _flushObjects();
+            void                    _flushVehicles();
+};
+
+/**
+ * Progress of an import driven over HTTP, readable from other requests.
+ */
+struct MapImportProgress
+{
+    uint64_t                        total;
+    std::atomic<uint64_t>           received;
+    std::atomic<size_t>             objects;
+    std::atomic<size_t>             vehicles;
+    std::atomic<bool>               finished;
+    // Set along with finished if no map was added.
+    std::atomic<bool>               failed;
+    std::time_t                     started;
+
+                                    MapImportProgress(uint64_t total) :
+        total(total), received(0), objects(0), vehicles(0), finished(false),
+        failed(false), started(std::time(nullptr)) {}
+
+            std::string             getJSON() const;
+};
+
+/**
+ * Receives the body of a /maps/add request. The form fields are decoded
+ * as they arrive and the code field is passed on to a MapImporter, so a
+ * map is imported with the same, small amount of memory whatever its size.
+ * The name and type fields have to come before the code, which is what
+ * browsers do with the form of map-add.html.
+ */
+class MapUploadHandler : public HTTPContentHandler
+{
+protected:
+    std::shared_ptr<MapImportProgress>  mProgress;
+    FormStreamDecoder                   mDecoder;
+    std::string                         mName;
+    std::string                         mType;
+    std::shared_ptr<Map>                mMap;
+    std::unique_ptr<MapImporter>        mImporter;
+    // UTF-8, sent back as it is.
+    std::string                         mError;
+
+public:
+    /**
+     * If an error is given, the body is skipped and the error sent back.
+     */
+    explicit                        MapUploadHandler(
+        std::shared_ptr<MapImportProgress> progress,
+        std::string error = std::string());
+    virtual                         ~MapUploadHandler();
+
+    virtual bool                    on_content(const char* data,
+        size_t size) override;
+    virtual void                    on_end(HTTPResponse& response) override;
+
+protected:
+            void                    _onValue(const std::string& name,
+                const char* data, size_t size);
+            bool                    _beginImport();
+};
+
+}
@@ -42,7 +42,7 @@ MapManager::MapManager()
 }
 
 std::shared_ptr<Map> MapManager::parse(MapType type, const std::string& name, int world,
-    const mongo::OID& owner, std::string source)
+    const mongo::OID& owner, const std::string& source)
 {
     std::shared_ptr<Map> map(new Map(type, world, owner, name));
 
@@ -51,33 +51,9 @@ std::shared_ptr<Map> MapManager::parse(MapType type, const std::string& name, in
         return map;
     }
 
-    std::replace(source.begin(), source.end(), '(', ' ');
-    std::replace(source.begin(), source.end(), ')', ' ');
-    std::replace(source.begin(), source.end(), ',', ' ');
-    std::replace(source.begin(), source.end(), ';', ' ');
-
-    std::istringstream stream(source);
-
-    std::string span;
-    int model;
-    float x, y, z, rx, ry, rz, angle;
-
-    while (stream >> span)
-    {
-        if (span == "CreateObject" || span == "CreateDynamicObject")
-        {
-            stream >> model >> x >> y >> z >> rx >> ry >> rz;
-            map->addObject(model, x, y, z, rx, ry, rz, false, -1);
-        }
-        else if (span == "CreateVehicle" || span == "AddStaticVehicle"
-            || span == "AddStaticVehicleEx")
-        {
-            stream >> model >> x >> y >> z >> angle;
-            map->addVehicle(model, x, y, z, angle, 0, 60);
-        }
-    }
-
-    map->updateBounding();
+    MapImporter importer(map);
+    importer.feed(source.data(), source.size());
+    importer.finish();
 
     mLoadedMaps.insert(std::make_pair(name, map));
     return map;
@@ -115,10 +91,10 @@ size_t MapManager::loadAllMaps()
     LOG(INFO) << "Loaded maps cleared.";
     MONGO_WRAPPER({
         size_t count = 0;
-        auto cur = getDBConn()->query(
+        auto cur = MONGO_TIMED(Config::colNameMap, "query", getDBConn()->query(
             Config::colNameMap,
             QUERY("activated" << true)
-        );
+        ));
         while(cur->more())
         {
             std::shared_ptr<Map> map(new Map(cur->next()));
@@ -152,6 +128,46 @@ std::shared_ptr<Map> MapManager::findMap(const std::string& name)
     }
 }
 
+std::shared_ptr<MapImportProgress> MapManager::_beginImport(
+    const std::string& id, uint64_t total)
+{
+    auto progress = std::make_shared<MapImportProgress>(total);
+    if(id.empty()) return progress;
+
+    std::time_t now = std::time(nullptr);
+    std::lock_guard<std::mutex> lock(mImportsMutex);
+    for(auto iter = mImports.begin(); iter != mImports.end();)
+    {
+        if(iter->second->finished && now - iter->second->started > 60)
+            iter = mImports.erase(iter);
+        else
+            ++iter;
+    }
+    auto iter = mImports.find(id);
+    if(iter != mImports.end())
+    {
+        if(!iter->second->finished) return nullptr;
+        iter->second = progress;
+        return progress;
+    }
+    // Still imported, just not tracked.
+    if(mImports.size() >= 64) return progress;
+    mImports[id] = progress;
+    return progress;
+}
+
+std::shared_ptr<MapImportProgress> MapManager::_findImport(
+    const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mImportsMutex);
+    auto iter = mImports.find(id);
+    if(iter == mImports.end())
+    {
+        return nullptr;
+    }
+    return iter->second;
+}
+
 void MapManager::addWebServices()
 {
     /**
@@ -161,7 +177,7 @@ void MapManager::addWebServices()
      */
     WebServiceManager::get().bindMethod(
         "^/maps/([^/]*)$", "GET",
-    [this](std::ostream& response, HTTPRequertPtr /* request*/ ) {
+    [this](HTTPResponse& response, HTTPRequertPtr /* request*/ ) {
         std::stringstream array;
         array << "{ \"data\" : [";
         for(auto& i : mLoadedMaps)
@@ -171,7 +187,7 @@ void MapManager::addWebServices()
         std::string resp = array.str();
         resp[resp.size() - 1] = ']';
         resp += "}";
-        writeResponse(response, 200, CONTENT_TYPE_APP_JSON, resp);
+        writeResponse(response, 200, CONTENT_TYPE_APP_JSON, std::move(resp));
     });
     /**
      * Get info of a map.
@@ -180,7 +196,7 @@ void MapManager::addWebServices()
      */
     WebServiceManager::get().bindMethod(
         "^/maps/name/([^/]+)$", "GET",
-    [this](std::ostream& response, HTTPRequertPtr request) {
+    [this](HTTPResponse& response, HTTPRequertPtr request) {
         auto map = findMap(UTF8ToGBK(request->path_match[1]));
         if(map == nullptr)
         {
@@ -190,43 +206,44 @@ void MapManager::addWebServices()
         writeResponse(response, 200, CONTENT_TYPE_APP_JSON, map->getJSON());
     });
     /**
-     * Add a map
+     * Add a map. The body is imported while it's being received.
      * Example URI:
-     * /map/add
+     * /maps/add?import=<id chosen by the client, for progress queries>
      */
-    WebServiceManager::get().bindMethod(
-        "^/maps/add", "POST",
-    [this](std::ostream& response, HTTPRequertPtr request) {
-        std::istreambuf_iterator<char> eos;
-        std::string s(std::istreambuf_iterator<char>(request->content), eos);
-        ParamSet p;
-        parseParam(s, p);
-        std::string name = p["name"];
-        boost::algorithm::trim(name);
-        auto map = parse(
-            MapType(atoi(p["type"].c_str())),
-            UTF8ToGBK(name),
-            -1,
-            mongo::OID(),
-            p["code"]
-        );
-        if(map->isValid())
+    WebServiceManager::get().bindContentMethod(
+        "^/maps/add(?:\\?import=([0-9A-Za-z_-]{1,32}))?$", "POST",
+    [this](HTTPRequertPtr request) {
+        uint64_t total = 0;
+        auto length = request->header.find("Content-Length");
+        if(length != request->header.end())
         {
-            writeResponse(response, 200, CONTENT_TYPE_TEXT_PLAIN,
-                STR("地图添加成功\n"
-                    "名称: " << GBKToUTF8(map->getName()) << "\n" <<
-                    "交通工具数量: " << map->getVehicleCount() << "\n"
-                    "Obj数量: " << map->getObjectCount()
-                )
-            );
+            total = strtoull(length->second.c_str(), nullptr, 10);
         }
-        else
+        auto progress = _beginImport(request->path_match[1], total);
+        if(progress == nullptr)
         {
-            writeResponse(response, 200, CONTENT_TYPE_TEXT_PLAIN,
-                "地图添加失败, 可能是已经有重名的地图, "
-                "或者服务器发生了错误, 请检查SAMP服务器日志."
-            );
+            return std::make_shared<MapUploadHandler>(
+                std::make_shared<MapImportProgress>(total),
+                "地图添加失败, 导入ID正在被另一个导入使用, 请重试.");
+        }
+        return std::make_shared<MapUploadHandler>(progress);
+    });
+    /**
+     * Progress of an import.
+     * Example URI:
+     * /maps/import/k3j5h2
+     */
+    WebServiceManager::get().bindMethod(
+        "^/maps/import/([0-9A-Za-z_-]{1,32})$", "GET",
+    [this](HTTPResponse& response, HTTPRequertPtr request) {
+        auto progress = _findImport(request->path_match[1]);
+        if(progress == nullptr)
+        {
+            writeResponse(response, 404, CONTENT_TYPE_TEXT_PLAIN, "");
+            return;
         }
+        writeResponse(response, 200, CONTENT_TYPE_APP_JSON,
+            progress->getJSON());
     });
 }
 
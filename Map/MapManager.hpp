@@ -17,10 +17,12 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 
 #include "../Utility/Singleton.hpp"
 
 #include "Map.hpp"
+#include "MapImporter.hpp"
 
 namespace swcu {
 
@@ -29,24 +31,29 @@ class MapManager : public Singleton<MapManager>
 protected:
     std::map<std::string, std::shared_ptr<Map>> mLoadedMaps;
 
+    /**
+     * Imports running over HTTP, by the id chosen by the client.
+     * Shared between the web server threads.
+     */
+    std::mutex                                  mImportsMutex;
+    std::map<std::string, std::shared_ptr<MapImportProgress>> mImports;
+
 protected:
                     MapManager();
                     
     friend class Singleton<MapManager>;
     friend class MapViewDialog;
+    friend class MapUploadHandler;
 
 public:
     virtual         ~MapManager() {}
 
     /**
-     * This function parses an input stream in order to create a map
-     * using the information from that. It will parse:
-     * CreateObject|CreateDynamicObject(model, x, y, z, rx, ry, rz)
-     * CreateVehicle|AddStaticVehicle|AddStaticVehicleEx
-     *     (model, x, y, z, angle, color1, color2)
+     * This function parses Pawn map code in order to create a map
+     * using the information from that. See MapImporter for what is parsed.
      */
             std::shared_ptr<Map> parse(MapType type, const std::string& name, int world,
-                const mongo::OID& owner, std::string source);
+                const mongo::OID& owner, const std::string& source);
             bool    loadMap(const std::string& name);
             bool    unloadMap(const std::string& name);
             bool    isMapLoaded(const std::string& name);
@@ -59,6 +66,18 @@ public:
             size_t  loadAllMaps();
 
             void    addWebServices();
+
+protected:
+    /**
+     * Track a new import under the id given by the client. Finished
+     * imports are forgotten after a minute, and no more than 64 are
+     * tracked at once.
+     * @return Null if an unfinished import already has the id.
+     */
+            std::shared_ptr<MapImportProgress> _beginImport(
+                const std::string& id, uint64_t total);
+            std::shared_ptr<MapImportProgress> _findImport(
+                const std::string& id);
 };
 
 }
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include "PawnMapParser.hpp"
+
+namespace swcu {
+
+namespace {
+
+bool isTokenChar(char c)
+{
+    // Signs and dots are kept so that "-1.5e-3" stays one token, while
+    // "x+1" becomes a token that isn't a number.
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+        c == '.' || c == '-' || c == '+';
+}
+
+bool isSpace(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+}
+
+PawnMapParser::PawnMapParser(CallHandler handler) :
+    mHandler(std::move(handler)), mState(CODE), mPrev(0), mSlashPending(false),
+    mDepth(0), mArgc(0), mArgSeen(false), mArgIsNumber(false), mArgValue(0)
+{
+    mToken.reserve(MAX_TOKEN);
+}
+
+void PawnMapParser::feed(const char* data, size_t size)
+{
+    for(size_t i = 0; i < size; ++i)
+    {
+        char c = data[i];
+        switch(mState)
+        {
+            case LINE_COMMENT:
+            {
+                if(c == '\n') mState = CODE;
+                break;
+            }
+            case BLOCK_COMMENT:
+            {
+                if(mPrev == '*' && c == '/')
+                {
+                    mState = CODE;
+                    // Don't let the '/' start another comment.
+                    c = 0;
+                }
+                break;
+            }
+            case STRING:
+            case CHARACTER:
+            {
+                if(mPrev == '\\')
+                {
+                    // Escaped, and doesn't escape what follows.
+                    c = 0;
+                }
+                else if(c == (mState == STRING ? '"' : '\''))
+                {
+                    mState = CODE;
+                }
+                break;
+            }
+            case CODE:
+            {
+                // A '/' is held back until we know whether it starts a
+                // comment.
+                if(mSlashPending)
+                {
+                    mSlashPending = false;
+                    if(c == '/')
+                    {
+                        mState = LINE_COMMENT;
+                        break;
+                    }
+                    if(c == '*')
+                    {
+                        mState = BLOCK_COMMENT;
+                        c = 0;
+                        break;
+                    }
+                    _code('/');
+                }
+                if(c == '/')
+                {
+                    mSlashPending = true;
+                }
+                else
+                {
+                    _code(c);
+                }
+                break;
+            }
+        }
+        mPrev = c;
+    }
+}
+
+void PawnMapParser::finish()
+{
+    if(mState == CODE && mSlashPending)
+    {
+        _code('/');
+    }
+    _endToken();
+    mState          = CODE;
+    mPrev           = 0;
+    mSlashPending   = false;
+    mDepth          = 0;
+    mLastIdentifier.clear();
+}
+
+void PawnMapParser::_code(char c)
+{
+    if(isTokenChar(c))
+    {
+        // Overlong tokens are cut; they can't be a number or a function
+        // we care about either way.
+        if(mToken.size() < MAX_TOKEN) mToken += c;
+        return;
+    }
+    _endToken();
+    switch(c)
+    {
+        case '(':
+        {
+            if(mDepth == 0)
+            {
+                mFunction       = mLastIdentifier;
+                mDepth          = 1;
+                mArgc           = 0;
+                mArgSeen        = false;
+                mArgIsNumber    = false;
+            }
+            else
+            {
+                ++mDepth;
+                mArgSeen        = true;
+                mArgIsNumber    = false;
+            }
+            break;
+        }
+        case ')':
+        {
+            if(mDepth == 1)
+            {
+                if(mArgSeen || mArgc > 0) _endArg();
+                if(!mFunction.empty()) mHandler(mFunction, mArgs, mArgc);
+                mDepth = 0;
+            }
+            else if(mDepth > 1)
+            {
+                --mDepth;
+            }
+            break;
+        }
+        case ',':
+        {
+            if(mDepth == 1) _endArg();
+            break;
+        }
+        case '"':
+        case '\'':
+        {
+            mState = c == '"' ? STRING : CHARACTER;
+            if(mDepth > 0)
+            {
+                mArgSeen        = true;
+                mArgIsNumber    = false;
+            }
+            break;
+        }
+        case ';':
+        case '{':
+        case '}':
+        {
+            // Unbalanced call, drop it.
+            mDepth = 0;
+            break;
+        }
+        default:
+        {
+            if(mDepth > 0 && !isSpace(c))
+            {
+                mArgSeen        = true;
+                mArgIsNumber    = false;
+            }
+            break;
+        }
+    }
+    // "CreateObject (" is still a call, "CreateObject = (" is not.
+    if(!isSpace(c)) mLastIdentifier.clear();
+}
+
+void PawnMapParser::_endToken()
+{
+    if(mToken.empty()) return;
+    if(mDepth == 0)
+    {
+        char first = mToken[0];
+        if(std::isalpha(static_cast<unsigned char>(first)) || first == '_')
+            mLastIdentifier = mToken;
+        else
+            mLastIdentifier.clear();
+    }
+    else if(mDepth == 1 && !mArgSeen)
+    {
+        char* end;
+        mArgValue       = std::strtof(mToken.c_str(), &end);
+        mArgIsNumber    = *end == '\0';
+        mArgSeen        = true;
+    }
+    else
+    {
+        mArgSeen        = true;
+        mArgIsNumber    = false;
+    }
+    mToken.clear();
+}
+
+void PawnMapParser::_endArg()
+{
+    if(mArgc < MAX_ARGS)
+    {
+        mArgs[mArgc++] = mArgSeen && mArgIsNumber ? mArgValue : NAN;
+    }
+    mArgSeen        = false;
+    mArgIsNumber    = false;
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace swcu {
+
+/**
+ * Single pass scanner of Pawn map code.
+ * The code may be fed in pieces split anywhere; every function call found
+ * is reported with its arguments. Arguments which aren't plain numbers,
+ * like variables or nested calls, are reported as NaN. Comments and
+ * string literals are skipped. Memory use doesn't depend on the input.
+ */
+class PawnMapParser
+{
+public:
+    static const size_t MAX_ARGS        = 16;
+    static const size_t MAX_TOKEN       = 64;
+
+    typedef std::function<void(const std::string& function,
+        const float* args, size_t argc)> CallHandler;
+
+protected:
+    enum State
+    {
+        CODE,
+        LINE_COMMENT,
+        BLOCK_COMMENT,
+        STRING,
+        CHARACTER
+    };
+
+    CallHandler         mHandler;
+    State               mState;
+    char                mPrev;
+    bool                mSlashPending;
+
+    std::string         mToken;
+    std::string         mLastIdentifier;
+    std::string         mFunction;
+
+    // Paren depth inside the current call, 0 if not in a call.
+    int                 mDepth;
+    float               mArgs[MAX_ARGS];
+    size_t              mArgc;
+    bool                mArgSeen;
+    bool                mArgIsNumber;
+    float               mArgValue;
+
+public:
+    explicit            PawnMapParser(CallHandler handler);
+
+            void        feed(const char* data, size_t size);
+            void        finish();
+
+protected:
+            void        _code(char c);
+            void        _endToken();
+            void        _endArg();
+};
+
+}
@@ -21,8 +21,11 @@
 #include "../Map/Map.hpp"
 #include "../Crew/CrewManager.hpp"
 #include "../Crew/Crew.hpp"
+#include "../Common/Scheduler.hpp"
+#include "../Vehicle/VehicleManager.hpp"
 
 #include "Player.hpp"
+#include "PlayerManager.hpp"
 
 namespace swcu {
 
@@ -42,35 +45,43 @@ const char* PoliceRankString[] =
 
 Player::Player(int gameid) :
     StorableObject(Config::colNamePlayer),
+    // Events reach players through PlayerManager.
+    EventListener({}),
     mMoney(0), mAdminLevel(0), mFlags(PlayerFlags::NO_FLAGS),
     mGameTime(0),
     mPoliceRank(CIVILIAN), mWantedLevel(0), mTimeInPrison(0),
     mTimeToFree(0),
     mInGameId(gameid), mLastSaved(time(0)), mLoggedIn(false),
-    mTextLabel(0), mPrivateVehicle(INVALID_VEHICLE_ID)
+    mLabel(gameid), mPrivateVehicle(INVALID_VEHICLE_ID)
 {
-    mLogName = getPlayerNameFixed(mInGameId);
+    mLogName = DualString::fromGBK(getPlayerNameFixed(mInGameId));
     mNickname = mLogName;
     SetPlayerColor(mInGameId, mColor.getRGBA());
     LOG(INFO) << "Loading player " << mLogName << "'s profile.";
-    _loadObject("logname", GBKToUTF8(mLogName));
+    _loadObject("logname", mLogName.utf8());
+    _scheduleDuties();
 }
 
 Player::Player(const mongo::OID& id) :
     StorableObject(Config::colNamePlayer, id),
+    // Events reach players through PlayerManager.
+    EventListener({}),
     mMoney(0), mAdminLevel(0), mFlags(PlayerFlags::NO_FLAGS),
     mGameTime(0),
     mPoliceRank(CIVILIAN), mWantedLevel(0), mTimeInPrison(0),
     mTimeToFree(0),
     mInGameId(-1), mLastSaved(time(0)), mLoggedIn(false),
-    mTextLabel(0), mPrivateVehicle(INVALID_VEHICLE_ID)
+    mLabel(-1), mPrivateVehicle(INVALID_VEHICLE_ID)
 {
     _loadObject();
 }
 
 Player::~Player()
 {
-    if(mTextLabel != 0) DestroyDynamic3DTextLabel(mTextLabel);
+    EventManager::get().cancelEvents(this);
+    Scheduler::get().cancel(mGodModeTimer);
+    Scheduler::get().cancel(mPrisonTimer);
+    dropPrivateVehicle();
     saveProfile();
 }
 
@@ -82,14 +93,14 @@ bool Player::createProfile(const std::string& password)
     }
     std::string tPasswordHash   = sha1(password);
     if(_createObject(BSON(
-        "logname"       << GBKToUTF8(mLogName)  <<
+        "logname"       << mLogName.utf8()      <<
         "password"      << tPasswordHash        <<
         "color"         << mColor.getRGB()      <<
         "crew"          << mCrew                <<
         "gametime"      << 0                    <<
         "adminlevel"    << mAdminLevel          <<
         "flags"         << mFlags               <<
-        "nickname"      << GBKToUTF8(mNickname) <<
+        "nickname"      << mNickname.utf8()     <<
         "money"         << mMoney               <<
         "policerank"    << mPoliceRank          <<
         "wantedlevel"   << mWantedLevel         <<
@@ -100,10 +111,11 @@ bool Player::createProfile(const std::string& password)
         mPasswordHash   = tPasswordHash;
         EventLog("player", "createProfile", BSON(
             "profile"   << mId                  <<
-            "logname"   << mLogName             <<
+            "logname"   << mLogName.gbk()       <<
             "ip"        << getPlayerIP(mInGameId)<<
             "gpci"      << getGPCI(mInGameId)
         ));
+        PlayerManager::get().updateIndex(this);
         updatePlayerLabel();
         LOG(INFO) << "Player " << mLogName << "'s profile is created.";
         return true;
@@ -162,11 +174,12 @@ bool Player::setLogName(const std::string& name)
     {
         return false;
     }
-    if(_updateField("$set", "logname", GBKToUTF8(name)))
+    DualString newName = DualString::fromGBK(name);
+    if(_updateField("$set", "logname", newName.utf8()))
     {
         LOG(INFO) << "Player " << mLogName << "'s logname is set to "
             << name;
-        mLogName = name;
+        mLogName = newName;
         updatePlayerLabel();
         return true;
     }
@@ -179,11 +192,12 @@ bool Player::setNickname(const std::string& name)
     {
         return false;
     }
-    if(_updateField("$set", "nickname", GBKToUTF8(name)))
+    DualString newName = DualString::fromGBK(name);
+    if(_updateField("$set", "nickname", newName.utf8()))
     {
         LOG(INFO) << "Player " << mLogName << "'s nickname is set to "
             << name;
-        mNickname = name;
+        mNickname = newName;
         updatePlayerLabel();
         return true;
     }
@@ -242,9 +256,9 @@ bool Player::setAdminLevel(int level)
             "levelprev" << mAdminLevel  <<
             "level"     << level
         ));
-        SendClientMessage(mInGameId, 0xFFFFFFFF, CSTR(
-            "你的管理员等级被设置为 " << level
-        ));
+        SendClientMessage(mInGameId, 0xFFFFFFFF, FORMAT(
+            "你的管理员等级被设置为 {}", level
+        ).c_str());
         mAdminLevel = level;
         updatePlayerLabel();
         return true;
@@ -268,9 +282,9 @@ bool Player::setPoliceRank(PoliceRank rank)
             "rankprev"  << mPoliceRank  <<
             "rank"      << rank
         ));
-        SendClientMessage(mInGameId, 0xFFFFFFFF, CSTR(
-            "你的警衔被设置为 " << rank
-        ));
+        SendClientMessage(mInGameId, 0xFFFFFFFF, FORMAT(
+            "你的警衔被设置为 {}", rank
+        ).c_str());
         mPoliceRank = rank;
         updatePlayerLabel();
         return true;
@@ -301,9 +315,9 @@ bool Player::setWantedLevel(int level)
         LOG(INFO) << "Player " << mLogName << "'s wandted level is set to "
             << level << ".";
         mWantedLevel = level;
-        SendClientMessage(mInGameId, 0xFFFFFFFF, CSTR(
-            "你的通缉等级被设置为 " << level
-        ));
+        SendClientMessage(mInGameId, 0xFFFFFFFF, FORMAT(
+            "你的通缉等级被设置为 {}", level
+        ).c_str());
         updatePlayerLabel();
         _applyWantedLevel();
         return true;
@@ -338,9 +352,9 @@ bool Player::putIntoPrison(time_t prisonTerm)
     {
         LOG(INFO) << "Player " << mLogName << " now have a prison term of "
             << prisonTerm << " seconds.";
-        SendClientMessage(mInGameId, 0xFFFFFFFF, CSTR(
-            "你被关入监狱" << prisonTerm / 60 << "分钟."
-        ));
+        SendClientMessage(mInGameId, 0xFFFFFFFF, FORMAT(
+            "你被关入监狱{}分钟.", prisonTerm / 60
+        ).c_str());
         mTimeToFree = tofree;
         mTimeInPrison += tofree;
         setWantedLevel(0);
@@ -363,7 +377,7 @@ bool Player::freeFromPrison()
     removeFlags(STATUS_JAILED);
     ForceClassSelection(mInGameId);
     SetPlayerHealth(mInGameId, 0.0);
-    SetPlayerVirtualWorld(mInGameId, WORLD_MAIN);
+    PlayerManager::get().setPlayerWorld(mInGameId, WORLD_MAIN);
     updatePlayerLabel();
     LOG(INFO) << "Player " << mLogName << " is freed from prison.";
     return true;
@@ -371,41 +385,26 @@ bool Player::freeFromPrison()
 
 void Player::updatePlayerLabel()
 {
-    if(mTextLabel != 0)
-    {
-        DestroyDynamic3DTextLabel(mTextLabel);
-    }
-    std::stringstream label;
-    // Nickname
-    label << getColoredNickname() << "\n";
-    // Admin Level
-    if(mAdminLevel > 0)
-    {
-        label << "Level " << mAdminLevel << "\n";
-    }
-    // Police Rank
-    if(mPoliceRank > CIVILIAN)
-    {
-        label << "{33FFFF}" << getPoliceRankStr() << "{FFFFFF}\n";
-    }
-    // Wanted Level
-    if(mWantedLevel > 0)
-    {
-        label << "{FFFF00}通缉等级 " << mWantedLevel << "{FFFFFF}\n";
-    }
-    // Crew
+    mLabel.setNickname(getColoredNickname());
+    mLabel.setAdminLevel(mAdminLevel);
+    mLabel.setPoliceRank(mPoliceRank > CIVILIAN ? getPoliceRankStr() : "");
+    mLabel.setWantedLevel(mWantedLevel);
+    mLabel.setLogName(mLogName.gbk());
+}
+
+void Player::updateCrewLabel()
+{
+    updatePlayerLabel();
     if(isCrewMember())
     {
         auto crew = CrewManager::get().getCrew(mCrew);
-        label << crew->getColoredName() <<
-        " " << getCrewHierarchyStr(crew->getMemberHierarchy(mId)) << "\n";
+        mLabel.setCrew(crew->getColoredName(),
+            getCrewHierarchyStr(crew->getMemberHierarchy(mId)));
+    }
+    else
+    {
+        mLabel.setCrew("", "");
     }
-    // Login Name and ID
-    label << "(" << mLogName << ")(" << mInGameId << ")\n";
-    mTextLabel = CreateDynamic3DTextLabel(label.str(), 0xFFFFFFFF,
-        0.0, 0.0, 0.2, 200.0, mInGameId);
-    LOG(INFO) << "Player " << mLogName << "'s label created with id " <<
-        mTextLabel;
 }
 
 void Player::teleportTo(float x, float y, float z, float facing,
@@ -415,8 +414,9 @@ void Player::teleportTo(float x, float y, float z, float facing,
 
                         SetPlayerPos(mInGameId, x, y, z);
                         SetPlayerFacingAngle(mInGameId, facing);
-    if(world != -1)     SetPlayerInterior(mInGameId, interior);
-    if(interior != -1)  SetPlayerVirtualWorld(mInGameId, world);
+    if(interior != -1)  PlayerManager::get().setPlayerInterior(mInGameId,
+                            interior);
+    if(world != -1)     PlayerManager::get().setPlayerWorld(mInGameId, world);
 
     if(IsPlayerInAnyVehicle(mInGameId)
         && GetPlayerVehicleSeat(mInGameId) == 0 /* driver */)
@@ -428,19 +428,18 @@ void Player::teleportTo(float x, float y, float z, float facing,
         if(world != -1)     SetVehicleVirtualWorld(vid, world);
         if(interior != -1)  LinkVehicleToInterior(vid, interior);
 
-        int max = GetMaxPlayers();
-        for(int i = 0; i < max; ++i)
+        // Copied, the occupants may change while putting them back.
+        std::vector<VehicleOccupant> occupants =
+            VehicleManager::get().getOccupants(vid);
+        for(const VehicleOccupant& o : occupants)
         {
-            if(GetPlayerVehicleID(i) == vid)
-            {
-                int seat =          GetPlayerVehicleSeat(i);
+            int i = o.playerid;
+                                SetPlayerPos(i, x, y, z);
+            if(interior != -1)  PlayerManager::get().setPlayerInterior(i,
+                                    interior);
+            if(world != -1)     PlayerManager::get().setPlayerWorld(i, world);
 
-                                    SetPlayerPos(i, x, y, z);
-                if(world != -1)     SetPlayerInterior(i, interior);
-                if(interior != -1)  SetPlayerVirtualWorld(i, world);
-
-                                    PutPlayerInVehicle(i, vid, seat);
-            }
+                                PutPlayerInVehicle(i, vid, o.seat);
         }
     }
 }
@@ -464,10 +463,11 @@ bool Player::teleportTo(const std::string& placeName)
     std::string trimmedName = placeName;
     boost::algorithm::trim(trimmedName);
     MONGO_WRAPPER({
-        auto doc = getDBConn()->findOne(
+        auto doc = MONGO_TIMED(Config::colNameTeleport, "findOne",
+            getDBConn()->findOne(
             Config::colNameTeleport,
             QUERY("name" << GBKToUTF8(trimmedName))
-        );
+        ));
         if(doc.isEmpty())
         {
             LOG(WARNING) << "Teleport " << trimmedName << " can't be found.";
@@ -485,11 +485,11 @@ bool Player::teleportTo(const std::string& placeName)
             world       = doc["world"].numberInt();
             interior    = doc["interior"].numberInt();
             teleportTo(x, y, z, facing, world, interior);
-            getDBConn()->update(
+            MONGO_TIMED(Config::colNameTeleport, "update", getDBConn()->update(
                 Config::colNameTeleport,
                 BSON("_id" << doc["_id"]),
                 BSON("$inc" << BSON("use" << 1))
-            );
+            ));
             dbCheckError();
             LOG(INFO) << "Player " << mLogName << " teleported to "
                 << placeName;
@@ -510,7 +510,7 @@ bool Player::createTeleport(const std::string& placeName)
     int world       = GetPlayerVirtualWorld(mInGameId);
     int interior    = GetPlayerInterior(mInGameId);
     MONGO_WRAPPER({
-        getDBConn()->insert(
+        MONGO_TIMED(Config::colNameTeleport, "insert", getDBConn()->insert(
             Config::colNameTeleport,
             BSON(
                 "_id"           << mongo::OID::gen()    <<
@@ -525,7 +525,7 @@ bool Player::createTeleport(const std::string& placeName)
                 "createtime"    << mongo::DATENOW       <<
                 "use"           << 0
             )
-        );
+        ));
         if(dbCheckError())
         {
             SendClientMessage(mInGameId, 0xFFFFFFFF, "传送点创建成功.");
@@ -541,18 +541,24 @@ bool Player::createTeleport(const std::string& placeName)
 
 bool Player::createPrivateVehicle(int model)
 {
-    dropPrivateVehicle();
-    mPrivateVehicle = CreateVehicle(model, 0.0, 0.0, 0.0, 0.0,
+    // The old vehicle is kept if the new one can't be created.
+    int vehicle = CreateVehicle(model, 0.0, 0.0, 0.0, 0.0,
         rand() % 256, rand() % 256, 60);
+    if(vehicle == INVALID_VEHICLE_ID) return false;
+    dropPrivateVehicle();
+    mPrivateVehicle = vehicle;
     teleportPrivateVehicleToPlayer();
-    return mPrivateVehicle != INVALID_VEHICLE_ID;
+    return true;
 }
 
 bool Player::dropPrivateVehicle()
 {
     if(mPrivateVehicle != INVALID_VEHICLE_ID)
     {
+        VehicleManager::get().handleVehicleDestroyed(mPrivateVehicle);
         DestroyVehicle(mPrivateVehicle);
+        // The id is given to the next vehicle created.
+        mPrivateVehicle = INVALID_VEHICLE_ID;
         return true;
     }
     return false;
@@ -580,6 +586,7 @@ bool Player::_setCrew(const mongo::OID& crewId)
     if(_updateField("$set", "crew", crewId))
     {
         mCrew = crewId;
+        PlayerManager::get().updateIndex(this);
         if(crewId.isSet())
         {
             LOG(INFO) << "Player " << mLogName << " joined a crew.";
@@ -588,7 +595,7 @@ bool Player::_setCrew(const mongo::OID& crewId)
         {
             LOG(INFO) << "Player " << mLogName << " quited his crew.";
         }
-        updatePlayerLabel();
+        updateCrewLabel();
         return true;
     }
     return false;
@@ -598,9 +605,9 @@ bool Player::_parseObject(const mongo::BSONObj& doc)
 {
     MONGO_WRAPPER({
         mId             = doc["_id"].OID();
-        mLogName        = UTF8ToGBK(doc["logname"].str());
-        mNickname       = UTF8ToGBK(doc["nickname"].str());
-        if(mNickname.size() == 0) setNickname(mLogName);
+        mLogName        = DualString::fromUTF8(doc["logname"].str());
+        mNickname       = DualString::fromUTF8(doc["nickname"].str());
+        if(mNickname.empty()) setNickname(mLogName.gbk());
         mPasswordHash   = doc["password"].str();
         mAdminLevel     = doc["adminlevel"].numberInt();
         mMoney          = doc["money"].numberInt();
@@ -618,7 +625,7 @@ bool Player::_parseObject(const mongo::BSONObj& doc)
         mTimeInPrison   = doc["timeinprison"].numberLong();
         mTimeToFree     = doc["timetofree"].numberLong();
         _applyWantedLevel();
-        updatePlayerLabel();
+        updateCrewLabel();
         if(!isPrisonTermExceeded()) teleportToPrison();
         return true;
     });
@@ -644,28 +651,42 @@ bool Player::_validatePassword(const std::string& password)
 
 bool Player::onUpdate()
 {
-    if(hasFlags(swcu::STATUS_JAILED))
+    if(hasFlags(swcu::STATUS_FREEZED))
     {
-        if(isPrisonTermExceeded())
-        {
-            freeFromPrison();
-        }
+        return false;
     }
-    if(hasFlags(STATUS_INVINCIBLE))
-    {
-        SetPlayerHealth(mInGameId, 10000.0);
-        if(IsPlayerInAnyVehicle(mInGameId)
-            && GetPlayerVehicleSeat(mInGameId) == 0 /* driver */)
+    return true;
+}
+
+void Player::_scheduleDuties()
+{
+    // Spread the players over different ticks.
+    int offset = mInGameId * Config::serverTickInterval;
+    mGodModeTimer = Scheduler::get().every(Config::playerGodModeInterval,
+    [this]() {
+        _refreshGodMode();
+        return true;
+    }, offset % Config::playerGodModeInterval);
+    mPrisonTimer = Scheduler::get().every(Config::playerPrisonCheckInterval,
+    [this]() {
+        if(hasFlags(STATUS_JAILED) && isPrisonTermExceeded())
         {
-            int vid = GetPlayerVehicleID(mInGameId);
-            RepairVehicle(vid);
+            freeFromPrison();
         }
-    }
-    if(hasFlags(swcu::STATUS_FREEZED))
+        return true;
+    }, offset % Config::playerPrisonCheckInterval);
+}
+
+void Player::_refreshGodMode()
+{
+    if(!hasFlags(STATUS_INVINCIBLE)) return;
+    SetPlayerHealth(mInGameId, 10000.0);
+    if(IsPlayerInAnyVehicle(mInGameId)
+        && GetPlayerVehicleSeat(mInGameId) == 0 /* driver */)
     {
-        return false;
+        int vid = GetPlayerVehicleID(mInGameId);
+        RepairVehicle(vid);
     }
-    return true;
 }
 
 bool Player::onSpawn()
@@ -685,21 +706,19 @@ bool Player::onDeath()
 
 void Player::handleEvent(const Event& evt)
 {
-    switch(std::get<0>(evt))
+    switch(evt.type)
     {
         case onCrewLeaderChanged:
         {
-            auto crew = boost::any_cast<Crew*>(std::get<1>(evt));
-            if(crew->getLeader() == mId)
+            if(evt.crew->getLeader() == mId)
             {
-                _setCrew(boost::any_cast<Crew*>(std::get<1>(evt))->getId());
+                _setCrew(evt.crew->getId());
             }
             break;
         }
         case onCrewPlayerApplyToJoin:
         {
-            auto crew = boost::any_cast<Crew*>(std::get<1>(evt));
-            if(crew->getLeader() == mId)
+            if(evt.crew->getLeader() == mId)
             {
                 SendClientMessage(mInGameId, 0xFFFFFFFF,
                     "有玩家申请加入你的帮派, 请及时处理");
@@ -709,18 +728,16 @@ void Player::handleEvent(const Event& evt)
         case onCrewPlayerApprovedToJoin:
         case onCrewMemberAdded:
         {
-            auto profile = boost::any_cast<mongo::OID>(std::get<2>(evt));
-            if(profile == mId)
+            if(evt.profile == mId)
             {
-                _setCrew(boost::any_cast<Crew*>(std::get<1>(evt))->getId());
+                _setCrew(evt.crew->getId());
             }
             break;
         }
         case onCrewPlayerDeniedToJoin:
         case onCrewMemberRemoved:
         {
-            auto profile = boost::any_cast<mongo::OID>(std::get<2>(evt));
-            if(profile == mId)
+            if(evt.profile == mId)
             {
                 _setCrew(mongo::OID());
             }
@@ -729,19 +746,18 @@ void Player::handleEvent(const Event& evt)
         case onCrewColorChanged:
         case onCrewNameChanged:
         {
-            auto crew = boost::any_cast<Crew*>(std::get<1>(evt));
-            if(crew->getId() == mCrew)
+            if(evt.crew->getId() == mCrew)
             {
-                updatePlayerLabel();
+                // The hierarchy didn't change, don't query it.
+                mLabel.setCrewName(evt.crew->getColoredName());
             }
             break;
         }
         case onCrewMemberHierarchyChanged:
         {
-            auto profile = boost::any_cast<mongo::OID>(std::get<2>(evt));
-            if(profile == mId)
+            if(evt.profile == mId)
             {
-                updatePlayerLabel();
+                updateCrewLabel();
             }
             break;
         }
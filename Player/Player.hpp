@@ -18,10 +18,14 @@
 
 #include <kanko/Common/Vector3.hpp>
 
+#include "../Common/DualString.hpp"
 #include "../Common/StorableObject.hpp"
 #include "../Common/RGBAColor.hpp"
+#include "../Common/Scheduler.hpp"
 #include "../Event/Event.hpp"
 
+#include "PlayerLabel.hpp"
+
 namespace swcu {
 
 class Crew;
@@ -61,8 +65,8 @@ protected:
     /**
      * Profile.
      */
-    std::string         mLogName;
-    std::string         mNickname;
+    DualString          mLogName;
+    DualString          mNickname;
     std::string         mPasswordHash;
     int                 mMoney;
     int                 mAdminLevel;
@@ -88,8 +92,11 @@ protected:
     int                 mInGameId;
     int64_t             mLastSaved;
     bool                mLoggedIn;
-    int                 mTextLabel;
+    PlayerLabel         mLabel;
     int                 mPrivateVehicle;
+    // Periodic duties, cancelled with the player, see _scheduleDuties().
+    TimerHandle         mGodModeTimer;
+    TimerHandle         mPrisonTimer;
 
     /**
      * Houses, Weapons, Vehicles, etc.
@@ -160,14 +167,18 @@ public:
             bool        hasFlags(PlayerFlags flags)
             { return (mFlags & flags) == flags; }
 
-            std::string getLogName() const
-            { return mLogName; }
+            const std::string& getLogName() const
+            { return mLogName.gbk(); }
+            const std::string& getLogNameUTF8() const
+            { return mLogName.utf8(); }
             bool        setLogName(const std::string& name);
 
-            std::string getNickname() const
-            { return mNickname; }
+            const std::string& getNickname() const
+            { return mNickname.gbk(); }
+            const std::string& getNicknameUTF8() const
+            { return mNickname.utf8(); }
             std::string getColoredNickname() const
-            { return mColor.getEmbedCode() + mNickname + "{FFFFFF}"; }
+            { return mColor.getEmbedCode() + mNickname.gbk() + "{FFFFFF}"; }
             bool        setNickname(const std::string& name);
 
             int         getMoney() const
@@ -224,7 +235,18 @@ public:
             bool        freeFromPrison();
             bool        teleportToPrison();
 
+    /**
+     * Refresh what the label shows from the profile. The label itself is
+     * redrawn at the end of the tick, and only if something changed.
+     */
             void        updatePlayerLabel();
+    /**
+     * Like updatePlayerLabel(), also looking up the crew and the
+     * hierarchy in it, which costs a database query.
+     */
+            void        updateCrewLabel();
+            PlayerLabel& getLabel()
+            { return mLabel; }
 
     /**
      * If interior or world is -1, player's old settings of them will
@@ -274,6 +296,12 @@ protected:
     virtual bool        _parseObject(const mongo::BSONObj& data);
             void        _applyWantedLevel();
             bool        _validatePassword(const std::string& password);
+    /**
+     * Work which used to be done on every update packet, now run by the
+     * Scheduler at the intervals set in Config.
+     */
+            void        _scheduleDuties();
+            void        _refreshGodMode();
 };
 
 }
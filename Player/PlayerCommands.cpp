@@ -17,7 +17,6 @@
 #include <sampgdk/a_samp.h>
 #include <sampgdk/a_players.h>
 #include <sampgdk/a_vehicles.h>
-#include <algorithm>
 
 #include "../Interface/CommandManager.hpp"
 #include "../Interface/DialogManager.hpp"
@@ -28,131 +27,138 @@
 
 namespace swcu {
 
-bool pcmdFixCar(int playerid, std::stringstream& /* cmdline */)
+CommandResult pcmdFixCar(int playerid)
 {
     SendClientMessage(playerid, 0xFFFFFFFF,
         "Ľͨ޸");
     RepairVehicle(GetPlayerVehicleID(playerid));
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdSpawnJetPack(int playerid, std::stringstream& /* cmdline */)
+CommandResult pcmdSpawnJetPack(int playerid)
 {
     SetPlayerSpecialAction(playerid, SPECIAL_ACTION_USEJETPACK);
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdChangeSkin(int playerid, std::stringstream& cmdline)
+CommandResult pcmdChangeSkin(int playerid, int skinid)
 {
-    int skinid;
-    cmdline >> skinid;
     if(skinid < 0 || skinid > 299)
     {
         SendClientMessage(playerid, 0xFFFFFFFF, "ƤIDЧ");
-        return false;
+        return COMMAND_HANDLED_NO_CHARGE;
     }
-    return SetPlayerSkin(playerid, skinid);
+    return SetPlayerSkin(playerid, skinid) ? COMMAND_HANDLED :
+        COMMAND_HANDLED_NO_CHARGE;
 }
 
-bool pcmdVehicle(int playerid, std::stringstream& cmdline)
+CommandResult pcmdVehicle(int playerid, int vid)
 {
     auto p = PlayerManager::get().getPlayer(playerid);
-    if(p == nullptr) return false;
+    if(p == nullptr) return COMMAND_UNKNOWN;
+    // Refused before any native is called, uncharged uses aren't limited.
+    if(vid < 400 || vid > 611)
+    {
+        SendClientMessage(playerid, 0xFFFFFFFF, "IDЧ");
+        return COMMAND_HANDLED_NO_CHARGE;
+    }
+
+    if(!p->createPrivateVehicle(vid))
+    {
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            "ʧ");
+        return COMMAND_HANDLED_NO_CHARGE;
+    }
+    SendClientMessage(playerid, 0xFFFFFFFF,
+        FORMAT("㴴IDΪ{}ĳ", vid).c_str());
+    return COMMAND_HANDLED;
+}
 
-    std::string subfunc;
-    cmdline >> subfunc;
+CommandResult pcmdVehicleMine(int playerid)
+{
+    auto p = PlayerManager::get().getPlayer(playerid);
+    if(p == nullptr) return COMMAND_UNKNOWN;
 
-    if(subfunc.size() > 0 &&
-        std::all_of(subfunc.begin(), subfunc.end(), ::isdigit))
+    if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
     {
-        int vid = atoi(subfunc.c_str());
-        if(p->createPrivateVehicle(vid))
-            SendClientMessage(playerid, 0xFFFFFFFF, 
-                CSTR("㴴IDΪ" << vid << "ĳ"));
-        else
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                "ʧ");
-        return true;
+        p->teleportPrivateVehicleToPlayer();
+        SendClientMessage(playerid, 0xFFFFFFFF,
+           "㽫Լĳ˹");
     }
-    if(subfunc == "wode" || subfunc == "mine")
+    else
     {
-        if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
-        {
-            p->teleportPrivateVehicleToPlayer();
-            SendClientMessage(playerid, 0xFFFFFFFF,
-               "㽫Լĳ˹");
-        }
-        else
-        {
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                "û");
-        }
-        return true;
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            "û");
+        return COMMAND_HANDLED_NO_CHARGE;
     }
-    if(subfunc == "color")
+    return COMMAND_HANDLED;
+}
+
+CommandResult pcmdVehicleColor(int playerid, int c1, int c2)
+{
+    auto p = PlayerManager::get().getPlayer(playerid);
+    if(p == nullptr) return COMMAND_UNKNOWN;
+
+    if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
+    {
+        ChangeVehicleColor(p->getPrivateVehicleId(), c1, c2);
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            FORMAT("㽫ɫΪ {} {}", c1, c2).c_str());
+    }
+    else
+    {
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            "û");
+        return COMMAND_HANDLED_NO_CHARGE;
+    }
+    return COMMAND_HANDLED;
+}
+
+CommandResult pcmdVehicleDrop(int playerid)
+{
+    auto p = PlayerManager::get().getPlayer(playerid);
+    if(p == nullptr) return COMMAND_UNKNOWN;
+
+    if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
     {
-        if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
-        {
-            int c1, c2;
-            cmdline >> c1 >> c2;
-            ChangeVehicleColor(p->getPrivateVehicleId(), c1, c2);
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                CSTR("㽫ɫΪ " << c1 << " " << c2));
-        }
-        else
-        {
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                "û");
-        }
-        return true;
+        p->dropPrivateVehicle();
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            "ӵԼĳ");
     }
-    if(subfunc == "rengdiao" || subfunc == "drop")
+    else
     {
-        if(p->getPrivateVehicleId() != INVALID_VEHICLE_ID)
-        {
-            p->dropPrivateVehicle();
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                "ӵԼĳ");
-        }
-        else
-        {
-            SendClientMessage(playerid, 0xFFFFFFFF,
-                "û");
-        }
-        return true;
+        SendClientMessage(playerid, 0xFFFFFFFF,
+            "û");
+        return COMMAND_HANDLED_NO_CHARGE;
     }
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdSuicide(int playerid, std::stringstream& /* cmdline */)
+CommandResult pcmdSuicide(int playerid)
 {
     SetPlayerHealth(playerid, -100.0);
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdChangeWorld(int playerid, std::stringstream& cmdline)
+CommandResult pcmdChangeWorld(int playerid, int vworld)
 {
-    int vworld;
-    cmdline >> vworld;
-    SetPlayerVirtualWorld(playerid, vworld);
-    return true;
+    PlayerManager::get().setPlayerWorld(playerid, vworld);
+    return COMMAND_HANDLED;
 }
 
-bool pcmdWeaponShop(int playerid, std::stringstream& /* cmdline */)
+CommandResult pcmdWeaponShop(int playerid)
 {
     DialogManager::get().push<WeaponShopDialog>(playerid);
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdTeleportToPos(int playerid, std::stringstream& cmdline)
+CommandResult pcmdTeleportToPos(int playerid, float x, float y, float z)
 {
-    float x, y, z;
-    cmdline >> x >> y >> z;
     SetPlayerPos(playerid, x, y, z);
-    return true;
+    return COMMAND_HANDLED;
 }
 
-bool pcmdHelp(int playerid, std::stringstream& /* cmdline */)
+CommandResult pcmdHelp(int playerid)
 {
     SendClientMessage(playerid, 0xFFFFFFFF,
         "ӭSWCUɵش");
@@ -166,26 +172,49 @@ bool pcmdHelp(int playerid, std::stringstream& /* cmdline */)
         "ˢָ /c ID ɫ /c ɫ1 ɫ2");
     SendClientMessage(playerid, 0xFFFFFFFF,
         "ɵشʽ Ⱥ111738228");
-    return true;
+    return COMMAND_HANDLED;
 }
 
 void registerPlayerCommands()
 {
-    CommandManager::get().registerCommand("repair",     &pcmdFixCar);
-    CommandManager::get().registerCommand("fix",        &pcmdFixCar);
-    CommandManager::get().registerCommand("xiuche",     &pcmdFixCar);
-    CommandManager::get().registerCommand("jetpack",    &pcmdSpawnJetPack);
-    CommandManager::get().registerCommand("fxq",        &pcmdSpawnJetPack);
-    CommandManager::get().registerCommand("hf",         &pcmdChangeSkin);
-    CommandManager::get().registerCommand("skin",       &pcmdChangeSkin);
-    CommandManager::get().registerCommand("c",          &pcmdVehicle);
-    CommandManager::get().registerCommand("k",          &pcmdSuicide);
-    CommandManager::get().registerCommand("kill",       &pcmdSuicide);
-    CommandManager::get().registerCommand("w",          &pcmdChangeWorld);
-    CommandManager::get().registerCommand("wuqi",       &pcmdWeaponShop);
-    CommandManager::get().registerCommand("weapon",     &pcmdWeaponShop);
-    CommandManager::get().registerCommand("t",          &pcmdTeleportToPos);
-    CommandManager::get().registerCommand("help",       &pcmdHelp);
+    CommandManager& cmds = CommandManager::get();
+
+    CommandOptions repair;
+    repair.cooldown     = 2000;
+    cmds.registerCommand("repair",      &pcmdFixCar, "", repair);
+    cmds.addAlias("fix",                "repair");
+    cmds.addAlias("xiuche",             "repair");
+    cmds.registerCommand("jetpack",     &pcmdSpawnJetPack);
+    cmds.addAlias("fxq",                "jetpack");
+    cmds.registerCommand("skin",        &pcmdChangeSkin, "ƤID");
+    cmds.addAlias("hf",                 "skin");
+    // Creating vehicles is the most expensive thing a player can do, the
+    // subcommands only touch the one already there and aren't limited.
+    CommandOptions vehicle;
+    vehicle.cooldown    = 3000;
+    vehicle.globalRate  = 10.0;
+    vehicle.globalBurst = 20.0;
+    cmds.registerCommand("c",           &pcmdVehicle,
+        "ID|mine|color|drop", vehicle);
+    cmds.registerCommand("c mine",      &pcmdVehicleMine);
+    cmds.addAlias("c wode",             "c mine");
+    cmds.registerCommand("c color",     &pcmdVehicleColor, "ɫ1 ɫ2");
+    cmds.registerCommand("c drop",      &pcmdVehicleDrop);
+    cmds.addAlias("c rengdiao",         "c drop");
+    cmds.registerCommand("kill",        &pcmdSuicide);
+    cmds.addAlias("k",                  "kill");
+    CommandOptions world;
+    world.cooldown      = 1000;
+    cmds.registerCommand("w",           &pcmdChangeWorld, "ID", world);
+    cmds.registerCommand("weapon",      &pcmdWeaponShop);
+    cmds.addAlias("wuqi",               "weapon");
+    CommandOptions teleport;
+    teleport.cooldown   = 1000;
+    teleport.globalRate = 20.0;
+    teleport.globalBurst = 40.0;
+    cmds.registerCommand("t",           &pcmdTeleportToPos, "x y z",
+        teleport);
+    cmds.registerCommand("help",        &pcmdHelp);
 }
 
 }
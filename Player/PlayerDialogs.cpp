@@ -640,14 +640,12 @@ bool PlayerSendMessageDialog::handleCallback(
         SendClientMessage(mPlayerId, 0xFFFFFFFF, "δҵ.");
         return true;
     }
-    std::stringstream info;
-    info << "Ϣ͸ " << target->getColoredNickname()
-        << "{FFFFFF}(" << mTargetPlayer << "): " << inputtext;
-    SendClientMessage(mPlayerId, 0xFFFFFFFF, info.str().c_str());
-    std::stringstream msg;
-    msg << "Ϣ " << p->getColoredNickname()
-        << "{FFFFFF}(" << mPlayerId << "): " << inputtext;
-    SendClientMessage(mTargetPlayer, 0xFFFFFFFF, msg.str().c_str());
+    SendClientMessage(mPlayerId, 0xFFFFFFFF, FORMAT(
+        "Ϣ͸ {}{FFFFFF}({}): {}",
+        target->getColoredNickname(), mTargetPlayer, inputtext).c_str());
+    SendClientMessage(mTargetPlayer, 0xFFFFFFFF, FORMAT(
+        "Ϣ {}{FFFFFF}({}): {}",
+        p->getColoredNickname(), mPlayerId, inputtext).c_str());
     LOG(INFO) << "Private message sent from " << p->getLogName()
         << " to " << target->getLogName() << ": " << inputtext;
     return false;
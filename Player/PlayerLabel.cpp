@@ -0,0 +1,117 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Common/Common.hpp"
+#include "../Streamer/Streamer.hpp"
+
+#include "PlayerLabel.hpp"
+
+namespace swcu {
+
+PlayerLabel::PlayerLabel(int playerid) :
+    mPlayerId(playerid), mLabel(0), mDirty(false),
+    mAdminLevel(0), mWantedLevel(0)
+{
+}
+
+PlayerLabel::~PlayerLabel()
+{
+    if(mLabel != 0) DestroyDynamic3DTextLabel(mLabel);
+}
+
+void PlayerLabel::setNickname(const std::string& nickname)
+{
+    _set(mNickname, nickname);
+}
+
+void PlayerLabel::setAdminLevel(int level)
+{
+    _set(mAdminLevel, level);
+}
+
+void PlayerLabel::setPoliceRank(const std::string& rank)
+{
+    _set(mPoliceRank, rank);
+}
+
+void PlayerLabel::setWantedLevel(int level)
+{
+    _set(mWantedLevel, level);
+}
+
+void PlayerLabel::setCrew(const std::string& coloredName,
+    const std::string& hierarchy)
+{
+    _set(mCrew, coloredName);
+    _set(mCrewHierarchy, hierarchy);
+}
+
+void PlayerLabel::setCrewName(const std::string& coloredName)
+{
+    _set(mCrew, coloredName);
+}
+
+void PlayerLabel::setLogName(const std::string& logname)
+{
+    _set(mLogName, logname);
+}
+
+void PlayerLabel::update()
+{
+    if(!mDirty) return;
+    mDirty = false;
+
+    mText.clear();
+    // Nickname
+    mText.append(mNickname).append("\n");
+    // Admin Level
+    if(mAdminLevel > 0)
+    {
+        mText.append("Level ").append(std::to_string(mAdminLevel))
+            .append("\n");
+    }
+    // Police Rank
+    if(!mPoliceRank.empty())
+    {
+        mText.append("{33FFFF}").append(mPoliceRank).append("{FFFFFF}\n");
+    }
+    // Wanted Level
+    if(mWantedLevel > 0)
+    {
+        mText.append("{FFFF00}通缉等级 ").append(std::to_string(mWantedLevel))
+            .append("{FFFFFF}\n");
+    }
+    // Crew
+    if(!mCrew.empty())
+    {
+        mText.append(mCrew).append(" ").append(mCrewHierarchy).append("\n");
+    }
+    // Login Name and ID
+    mText.append("(").append(mLogName).append(")(")
+        .append(std::to_string(mPlayerId)).append(")\n");
+
+    if(mLabel != 0)
+    {
+        UpdateDynamic3DTextLabelText(mLabel, 0xFFFFFFFF, mText);
+        return;
+    }
+    mLabel = CreateDynamic3DTextLabel(mText, 0xFFFFFFFF,
+        0.0, 0.0, 0.2, 200.0, mPlayerId);
+    LOG(DEBUG) << "Player " << mLogName << "'s label created with id " <<
+        mLabel;
+}
+
+}
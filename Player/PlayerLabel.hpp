@@ -0,0 +1,87 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace swcu {
+
+/**
+ * The 3D text label attached to a player. It keeps what's shown on it and
+ * is only rebuilt when one of those changes; setting an unchanged value
+ * costs a comparison. The text is generated by update(), which is called
+ * once per tick, into a buffer reused for the lifetime of the label, and
+ * an existing label has its text replaced rather than being recreated.
+ */
+class PlayerLabel
+{
+protected:
+    int                 mPlayerId;
+    int                 mLabel;
+    bool                mDirty;
+
+    std::string         mNickname;
+    int                 mAdminLevel;
+    std::string         mPoliceRank;
+    int                 mWantedLevel;
+    std::string         mCrew;
+    std::string         mCrewHierarchy;
+    std::string         mLogName;
+
+    std::string         mText;
+
+public:
+    explicit            PlayerLabel(int playerid);
+                        ~PlayerLabel();
+                        PlayerLabel(const PlayerLabel&) = delete;
+    PlayerLabel&        operator=(const PlayerLabel&) = delete;
+
+    /**
+     * The nickname is expected with its color embedded.
+     */
+            void        setNickname(const std::string& nickname);
+            void        setAdminLevel(int level);
+    /**
+     * An empty rank is not shown, i.e. for civilians.
+     */
+            void        setPoliceRank(const std::string& rank);
+            void        setWantedLevel(int level);
+    /**
+     * An empty crew name is not shown.
+     */
+            void        setCrew(const std::string& coloredName,
+                const std::string& hierarchy);
+            void        setCrewName(const std::string& coloredName);
+            void        setLogName(const std::string& logname);
+
+            bool        isDirty() const         { return mDirty; }
+    /**
+     * Create the label, or change its text, if anything changed.
+     */
+            void        update();
+
+protected:
+    template<typename T>
+            void        _set(T& field, const T& value)
+    {
+        if(field == value) return;
+        field = value;
+        mDirty = true;
+    }
+};
+
+}
@@ -14,12 +14,32 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <sampgdk/a_players.h>
+
+#include "../Common/Scheduler.hpp"
+#include "../Crew/Crew.hpp"
+
 #include "PlayerManager.hpp"
 
 namespace swcu {
 
-PlayerManager::PlayerManager()
+PlayerManager::PlayerManager() : EventListener({
+    onCrewPlayerApplyToJoin,
+    onCrewPlayerApprovedToJoin,
+    onCrewPlayerDeniedToJoin,
+    onCrewMemberAdded,
+    onCrewMemberRemoved,
+    onCrewMemberHierarchyChanged,
+    onCrewLeaderChanged,
+    onCrewColorChanged,
+    onCrewNameChanged }),
+    mGrid(Config::playerGridCellSize, Config::playerGridMoveThreshold)
 {
+    // Players still here at exit cancel their timers when destroyed, so
+    // the scheduler has to be built first to be destroyed after us.
+    Scheduler::get();
+
     getDBConn()->createCollection(Config::colNamePlayer);
     getDBConn()->ensureIndex(Config::colNamePlayer, 
         BSON("logname" << 1), true);
@@ -31,39 +51,187 @@ PlayerManager::PlayerManager()
 
 Player* PlayerManager::addPlayer(int playerid)
 {
-    Player *p = new Player(playerid);
-    if(mPlayers.insert(std::make_pair(playerid,
-        std::move(std::unique_ptr<Player>(p)))).second)
-    {
-        return p;
-    }
-    else
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS ||
+        mSlots[playerid].player != nullptr)
     {
         return nullptr;
     }
+    Slot& slot = mSlots[playerid];
+    slot.player.reset(new Player(playerid));
+    slot.world      = GetPlayerVirtualWorld(playerid);
+    slot.interior   = GetPlayerInterior(playerid);
+    slot.dense = mPlayerIds.size();
+    mPlayerIds.push_back(playerid);
+    updateIndex(slot.player.get());
+    return slot.player.get();
 }
 
 bool PlayerManager::removePlayer(int playerid)
 {
-    return mPlayers.erase(playerid) > 0;
+    if(!hasPlayer(playerid)) return false;
+    _removeFromIndex(playerid);
+    mGrid.remove(playerid);
+    Slot& slot = mSlots[playerid];
+    // Swap with the last id to keep the list dense.
+    int last = mPlayerIds.back();
+    mPlayerIds[slot.dense] = last;
+    mSlots[last].dense = slot.dense;
+    mPlayerIds.pop_back();
+    slot.player.reset();
+    return true;
+}
+
+Player* PlayerManager::findPlayerByProfile(const mongo::OID& profile)
+{
+    if(!profile.isSet()) return nullptr;
+    auto iter = mByProfile.find(profile);
+    return iter == mByProfile.end() ? nullptr : iter->second;
 }
 
-bool PlayerManager::hasPlayer(int playerid)
+const std::vector<Player*>& PlayerManager::getOnlineCrewMembers(
+    const mongo::OID& crew)
 {
-    return mPlayers.count(playerid) > 0;
+    static const std::vector<Player*> none;
+    if(!crew.isSet()) return none;
+    auto iter = mByCrew.find(crew);
+    return iter == mByCrew.end() ? none : iter->second;
 }
 
-Player* PlayerManager::getPlayer(int playerid)
+void PlayerManager::updateIndex(Player* player)
 {
-    auto iter = mPlayers.find(playerid);
-    if(iter == mPlayers.end())
+    int playerid = player->getInGameId();
+    // Not online, e.g. still being constructed.
+    if(getPlayer(playerid) != player) return;
+
+    _removeFromIndex(playerid);
+    Slot& slot = mSlots[playerid];
+    if(player->isValid())
     {
-        LOG(WARNING) << "Player " << playerid << " not found.";
-        return nullptr;
+        slot.profile = player->getId();
+        mByProfile[slot.profile] = player;
+    }
+    if(player->isCrewMember())
+    {
+        slot.crew = player->getCrew();
+        mByCrew[slot.crew].push_back(player);
     }
-    else
+}
+
+void PlayerManager::_removeFromIndex(int playerid)
+{
+    Slot& slot = mSlots[playerid];
+    if(slot.profile.isSet())
+    {
+        mByProfile.erase(slot.profile);
+        slot.profile = mongo::OID();
+    }
+    if(slot.crew.isSet())
+    {
+        auto crew = mByCrew.find(slot.crew);
+        if(crew != mByCrew.end())
+        {
+            auto& members = crew->second;
+            members.erase(std::remove(members.begin(), members.end(),
+                slot.player.get()), members.end());
+            if(members.empty()) mByCrew.erase(crew);
+        }
+        slot.crew = mongo::OID();
+    }
+}
+
+void PlayerManager::updateLabels()
+{
+    forEachPlayer([](Player& p) {
+        p.getLabel().update();
+    });
+}
+
+void PlayerManager::updatePosition(int playerid, const kanko::Vector3& pos)
+{
+    if(!hasPlayer(playerid)) return;
+    const Slot& slot = mSlots[playerid];
+    mGrid.update(playerid, pos, slot.world, slot.interior);
+}
+
+void PlayerManager::setPlayerWorld(int playerid, int world)
+{
+    SetPlayerVirtualWorld(playerid, world);
+    if(!hasPlayer(playerid)) return;
+    mSlots[playerid].world = world;
+    _updateGridPlace(playerid);
+}
+
+void PlayerManager::setPlayerInterior(int playerid, int interior)
+{
+    SetPlayerInterior(playerid, interior);
+    updateInterior(playerid, interior);
+}
+
+void PlayerManager::updateInterior(int playerid, int interior)
+{
+    if(!hasPlayer(playerid)) return;
+    mSlots[playerid].interior = interior;
+    _updateGridPlace(playerid);
+}
+
+void PlayerManager::_updateGridPlace(int playerid)
+{
+    if(!mGrid.contains(playerid)) return;
+    const Slot& slot = mSlots[playerid];
+    // Copied, the entry it comes from is written by update.
+    kanko::Vector3 pos = mGrid.getPosition(playerid);
+    mGrid.update(playerid, pos, slot.world, slot.interior);
+}
+
+void PlayerManager::getPlayersNear(int playerid, float radius,
+    std::vector<int>& out) const
+{
+    if(!mGrid.contains(playerid)) return;
+    size_t begin = out.size();
+    mGrid.queryRadius(mGrid.getPosition(playerid), radius,
+        mGrid.getWorld(playerid), mGrid.getInterior(playerid), out);
+    out.erase(std::remove(out.begin() + begin, out.end(), playerid),
+        out.end());
+}
+
+void PlayerManager::_sendToProfile(const mongo::OID& profile,
+    const Event& evt)
+{
+    if(Player* p = findPlayerByProfile(profile)) p->handleEvent(evt);
+}
+
+void PlayerManager::handleEvent(const Event& evt)
+{
+    switch(evt.type)
     {
-        return iter->second.get();
+        case onCrewPlayerApplyToJoin:
+        case onCrewLeaderChanged:
+        {
+            _sendToProfile(evt.crew->getLeader(), evt);
+            break;
+        }
+        case onCrewPlayerApprovedToJoin:
+        case onCrewPlayerDeniedToJoin:
+        case onCrewMemberAdded:
+        case onCrewMemberRemoved:
+        case onCrewMemberHierarchyChanged:
+        {
+            _sendToProfile(evt.profile, evt);
+            break;
+        }
+        case onCrewColorChanged:
+        case onCrewNameChanged:
+        {
+            // Copied, a member may leave while handling it.
+            auto members = getOnlineCrewMembers(evt.crew->getId());
+            for(Player* p : members)
+            {
+                p->handleEvent(evt);
+            }
+            break;
+        }
+        default:
+            break;
     }
 }
 
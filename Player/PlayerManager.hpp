@@ -16,19 +16,54 @@
 
 #pragma once
 
+#include <array>
 #include <unordered_map>
 #include <memory>
+#include <string>
+#include <vector>
+#include <sampgdk/a_samp.h>
 
+#include "../Common/Common.hpp"
+#include "../Common/SpatialGrid.hpp"
 #include "../Utility/Singleton.hpp"
 
 #include "Player.hpp"
  
 namespace swcu {
 
-class PlayerManager : public Singleton<PlayerManager>
+/**
+ * Owns the online players, in slots indexed by their in-game ids, so
+ * finding one is an array access. The ids in use are also kept densely
+ * for iterating.
+ * Also routes crew events to the players they concern, found through
+ * indices of the online players by profile and by crew, so a crew event
+ * costs as much as the crew has online members.
+ * Positions of the online players are kept in a SpatialGrid for finding
+ * who is near without asking every player for their position.
+ */
+class PlayerManager : public Singleton<PlayerManager>, public EventListener
 {
 protected:
-    std::unordered_map<int, std::unique_ptr<Player>>    mPlayers;
+    struct Slot
+    {
+        std::unique_ptr<Player> player;
+        // Position of the id in mPlayerIds.
+        size_t                  dense;
+        // What the player is indexed under, unset if nothing.
+        mongo::OID              profile;
+        mongo::OID              crew;
+        // Where the player is, kept so OnPlayerUpdate needn't ask.
+        int                     world;
+        int                     interior;
+    };
+    std::array<Slot, MAX_PLAYERS>                       mSlots;
+    // In-game ids of the online players, in no particular order.
+    std::vector<int>                                    mPlayerIds;
+
+    std::unordered_map<mongo::OID, Player*, OIDHash>    mByProfile;
+    std::unordered_map<mongo::OID, std::vector<Player*>, OIDHash> mByCrew;
+
+    SpatialGrid                                         mGrid;
 
 protected:
                     PlayerManager();
@@ -39,8 +74,102 @@ public:
 
     virtual Player* addPlayer(int playerid);
     virtual bool    removePlayer(int playerid);
-    virtual bool    hasPlayer(int playerid);
-    virtual Player* getPlayer(int playerid);
+            bool    hasPlayer(int playerid) const
+            { return getPlayer(playerid) != nullptr; }
+    /**
+     * @return The player, or nullptr if the id isn't in use.
+     */
+            Player* getPlayer(int playerid) const
+    {
+        // Negative ids wrap around and fail the same test.
+        return static_cast<unsigned>(playerid) < MAX_PLAYERS ?
+            mSlots[playerid].player.get() : nullptr;
+    }
+            size_t  getPlayerCount() const
+            { return mPlayerIds.size(); }
+    /**
+     * The list changes as players join and leave, don't keep it.
+     */
+            const std::vector<int>& getPlayerIds() const
+            { return mPlayerIds; }
+
+    /**
+     * @return The online player having this profile, or nullptr.
+     */
+            Player* findPlayerByProfile(const mongo::OID& profile);
+    /**
+     * @return Online members of the crew. The list is changed by players
+     *         joining or leaving, don't keep it.
+     */
+            const std::vector<Player*>& getOnlineCrewMembers(
+                const mongo::OID& crew);
+    /**
+     * Must be called when the profile or the crew of a player changes.
+     */
+            void    updateIndex(Player* player);
+
+    virtual void    handleEvent(const Event& evt) override;
+
+    /**
+     * Called from OnPlayerUpdate.
+     */
+            void    updatePosition(int playerid, const kanko::Vector3& pos);
+    /**
+     * Use these instead of SetPlayerVirtualWorld and SetPlayerInterior,
+     * the world and interior of online players are cached.
+     */
+            void    setPlayerWorld(int playerid, int world);
+            void    setPlayerInterior(int playerid, int interior);
+    /**
+     * Called from OnPlayerInteriorChange, the player may enter one by
+     * themselves.
+     */
+            void    updateInterior(int playerid, int interior);
+            const SpatialGrid& getGrid() const
+            { return mGrid; }
+    /**
+     * Append the players within radius of the player to out, not
+     * including the player.
+     */
+            void    getPlayersNear(int playerid, float radius,
+                std::vector<int>& out) const;
+
+    /**
+     * Redraw the labels which changed. Called once per tick.
+     */
+            void    updateLabels();
+
+    /**
+     * Players mustn't be added or removed by func.
+     */
+    template<typename Func>
+            void    forEachPlayer(Func func)
+    {
+        for(int id : mPlayerIds)
+        {
+            func(*mSlots[id].player);
+        }
+    }
+    /**
+     * For broadcasts which skip the player causing them.
+     */
+    template<typename Func>
+            void    forEachPlayerExcept(int playerid, Func func)
+    {
+        for(int id : mPlayerIds)
+        {
+            if(id != playerid) func(*mSlots[id].player);
+        }
+    }
+
+protected:
+            void    _removeFromIndex(int playerid);
+    /**
+     * Move the player in the grid to their cached world and interior.
+     */
+            void    _updateGridPlace(int playerid);
+            void    _sendToProfile(const mongo::OID& profile,
+                const Event& evt);
 };
 
 }
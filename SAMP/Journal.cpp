@@ -0,0 +1,380 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <sampgdk/a_samp.h>
+
+#include "../Common/Common.hpp"
+
+#include "Journal.hpp"
+
+// Defined in Server.cpp.
+void SAMPGDK_CALL OnServerTick(int timerid, void* param);
+void OnPlayerEnterDynamicArea(int playerid, int areaid);
+void OnPlayerLeaveDynamicArea(int playerid, int areaid);
+
+namespace swcu {
+
+const char* getJournalRecordTypeStr(JournalRecordType type)
+{
+    static const char* names[] = {
+        "OnPlayerConnect",
+        "OnPlayerDisconnect",
+        "OnPlayerUpdate",
+        "OnPlayerCommandText",
+        "OnDialogResponse",
+        "OnPlayerEnterDynamicArea",
+        "OnPlayerLeaveDynamicArea",
+        "OnServerTick",
+        "OnPlayerStateChange",
+        "OnPlayerExitVehicle",
+        "OnPlayerText",
+        "OnPlayerInteriorChange"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == JOURNAL_RECORD_TYPES,
+        "Journal record names out of sync with JournalRecordType.");
+    return type < JOURNAL_RECORD_TYPES ? names[type] : "invalid";
+}
+
+const char Journal::MAGIC[8] = { 'S', 'W', 'C', 'U', 'J', 'N', 'L', '1' };
+
+bool Journal::start(const std::string& path)
+{
+    stop();
+    mFile.open(path, std::ios::binary | std::ios::trunc);
+    if(!mFile.is_open())
+    {
+        LOG(ERROR) << "Cannot open journal " << path << ".";
+        return false;
+    }
+    mFile.write(MAGIC, sizeof(MAGIC));
+    mStart      = std::chrono::steady_clock::now();
+    mLastFlush  = mStart;
+    LOG(INFO) << "Recording journal to " << path << ".";
+    return true;
+}
+
+void Journal::stop()
+{
+    if(!mFile.is_open()) return;
+    mFile.close();
+    LOG(INFO) << "Journal closed.";
+}
+
+void Journal::recordConnect(int playerid)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_CONNECT, playerid);
+}
+
+void Journal::recordDisconnect(int playerid, int reason)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_DISCONNECT, playerid);
+    _writeInt(reason);
+}
+
+void Journal::recordUpdate(int playerid, float x, float y, float z)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_UPDATE, playerid);
+    float pos[3] = { x, y, z };
+    _write(pos, sizeof(pos));
+}
+
+void Journal::recordCommand(int playerid, const char* text)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_COMMAND, playerid);
+    _writeString(text);
+}
+
+void Journal::recordDialog(int playerid, int dialogid, int response,
+    int listitem, const char* text)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_DIALOG, playerid);
+    _writeInt(dialogid);
+    _writeInt(response);
+    _writeInt(listitem);
+    _writeString(text);
+}
+
+void Journal::recordEnterArea(int playerid, int areaid)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_ENTER_AREA, playerid);
+    _writeInt(areaid);
+}
+
+void Journal::recordLeaveArea(int playerid, int areaid)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_LEAVE_AREA, playerid);
+    _writeInt(areaid);
+}
+
+void Journal::recordStateChange(int playerid, int newstate, int oldstate)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_STATE_CHANGE, playerid);
+    _writeInt(newstate);
+    _writeInt(oldstate);
+}
+
+void Journal::recordExitVehicle(int playerid, int vehicleid)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_EXIT_VEHICLE, playerid);
+    _writeInt(vehicleid);
+}
+
+void Journal::recordText(int playerid, const char* text)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_TEXT, playerid);
+    _writeString(text);
+}
+
+void Journal::recordInteriorChange(int playerid, int newinterior,
+    int oldinterior)
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_INTERIOR_CHANGE, playerid);
+    _writeInt(newinterior);
+    _writeInt(oldinterior);
+}
+
+void Journal::recordTick()
+{
+    if(!isRecording()) return;
+    _begin(JOURNAL_TICK, -1);
+    auto now = std::chrono::steady_clock::now();
+    if(now - mLastFlush >= std::chrono::seconds(1))
+    {
+        mFile.flush();
+        mLastFlush = now;
+    }
+    if(!mFile.good())
+    {
+        LOG(ERROR) << "Writing the journal failed, recording stopped.";
+        stop();
+    }
+}
+
+void Journal::_begin(JournalRecordType type, int playerid)
+{
+    uint64_t time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - mStart).count();
+    _write(&time, sizeof(time));
+    _write(&type, sizeof(type));
+    _writeInt(playerid);
+}
+
+void Journal::_write(const void* data, size_t size)
+{
+    mFile.write(static_cast<const char*>(data), size);
+}
+
+void Journal::_writeInt(int32_t value)
+{
+    _write(&value, sizeof(value));
+}
+
+void Journal::_writeString(const char* text)
+{
+    size_t length = text == nullptr ? 0 : strlen(text);
+    uint16_t size = static_cast<uint16_t>(std::min<size_t>(length, 0xFFFF));
+    _write(&size, sizeof(size));
+    _write(text, size);
+}
+
+JournalReplayer::JournalReplayer(const std::string& path) :
+    mFile(path, std::ios::binary), mPaced(false)
+{
+    char magic[sizeof(Journal::MAGIC)];
+    if(mFile.is_open() && (!_read(magic, sizeof(magic)) ||
+        memcmp(magic, Journal::MAGIC, sizeof(magic)) != 0))
+    {
+        LOG(ERROR) << path << " is not a journal.";
+        mFile.close();
+    }
+}
+
+bool JournalReplayer::readRecord(JournalRecord& record)
+{
+    uint8_t type;
+    if(!_read(&record.time, sizeof(record.time)) ||
+        !_read(&type, sizeof(type)) ||
+        !_read(&record.playerid, sizeof(record.playerid)))
+    {
+        return false;
+    }
+    if(type >= JOURNAL_RECORD_TYPES)
+    {
+        LOG(ERROR) << "Unknown journal record type " << int(type) << ".";
+        return false;
+    }
+    record.type = JournalRecordType(type);
+    record.text.clear();
+
+    size_t ints = 0;
+    bool pos = false, text = false;
+    switch(record.type)
+    {
+        case JOURNAL_DISCONNECT:
+        case JOURNAL_ENTER_AREA:
+        case JOURNAL_LEAVE_AREA:
+        case JOURNAL_EXIT_VEHICLE:
+            ints = 1; break;
+        case JOURNAL_STATE_CHANGE:
+        case JOURNAL_INTERIOR_CHANGE:
+            ints = 2; break;
+        case JOURNAL_UPDATE:
+            pos = true; break;
+        case JOURNAL_COMMAND:
+        case JOURNAL_TEXT:
+            text = true; break;
+        case JOURNAL_DIALOG:
+            ints = 3; text = true; break;
+        default:
+            break;
+    }
+    if(!_read(record.args, ints * sizeof(int32_t))) return false;
+    if(pos && !_read(record.pos, sizeof(record.pos))) return false;
+    if(text)
+    {
+        uint16_t size;
+        if(!_read(&size, sizeof(size))) return false;
+        record.text.resize(size);
+        if(size > 0 && !_read(&record.text[0], size)) return false;
+    }
+    return true;
+}
+
+uint64_t JournalReplayer::run()
+{
+    uint64_t replayed = 0;
+    JournalRecord record;
+    auto start = std::chrono::steady_clock::now();
+    while(readRecord(record))
+    {
+        if(mPaced)
+        {
+            std::this_thread::sleep_until(
+                start + std::chrono::microseconds(record.time));
+        }
+        if(record.type == JOURNAL_UPDATE && mOnPosition)
+        {
+            mOnPosition(record.playerid,
+                record.pos[0], record.pos[1], record.pos[2]);
+        }
+        if(record.type == JOURNAL_CONNECT && mOnConnection)
+        {
+            mOnConnection(record.playerid, true);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        _dispatch(record);
+        uint64_t nanos = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        if(record.type == JOURNAL_DISCONNECT && mOnConnection)
+        {
+            mOnConnection(record.playerid, false);
+        }
+        mNanos[record.type].push_back(nanos);
+        ++replayed;
+    }
+    return replayed;
+}
+
+std::string JournalReplayer::getReport() const
+{
+    std::ostringstream report;
+    report << "# type count total_ns mean_ns p50_ns p90_ns p99_ns\n";
+    report << std::fixed << std::setprecision(1);
+    for(size_t i = 0; i < JOURNAL_RECORD_TYPES; ++i)
+    {
+        if(mNanos[i].empty()) continue;
+        std::vector<uint64_t> samples = mNanos[i];
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double q) {
+            return samples[std::min(samples.size() - 1,
+                static_cast<size_t>(q * samples.size()))];
+        };
+        uint64_t total = 0;
+        for(uint64_t nanos : samples) total += nanos;
+        report << getJournalRecordTypeStr(JournalRecordType(i)) << ' ' <<
+            samples.size() << ' ' <<
+            total << ' ' <<
+            static_cast<double>(total) / samples.size() << ' ' <<
+            at(0.5) << ' ' <<
+            at(0.9) << ' ' <<
+            at(0.99) << '\n';
+    }
+    return report.str();
+}
+
+void JournalReplayer::_dispatch(const JournalRecord& record)
+{
+    int playerid = record.playerid;
+    switch(record.type)
+    {
+        case JOURNAL_CONNECT:
+            OnPlayerConnect(playerid); break;
+        case JOURNAL_DISCONNECT:
+            OnPlayerDisconnect(playerid, record.args[0]); break;
+        case JOURNAL_UPDATE:
+            OnPlayerUpdate(playerid); break;
+        case JOURNAL_COMMAND:
+            OnPlayerCommandText(playerid, record.text.c_str()); break;
+        case JOURNAL_DIALOG:
+            OnDialogResponse(playerid, record.args[0], record.args[1],
+                record.args[2], record.text.c_str());
+            break;
+        case JOURNAL_ENTER_AREA:
+            OnPlayerEnterDynamicArea(playerid, record.args[0]); break;
+        case JOURNAL_LEAVE_AREA:
+            OnPlayerLeaveDynamicArea(playerid, record.args[0]); break;
+        case JOURNAL_TICK:
+            OnServerTick(-1, nullptr); break;
+        case JOURNAL_STATE_CHANGE:
+            OnPlayerStateChange(playerid, record.args[0], record.args[1]);
+            break;
+        case JOURNAL_EXIT_VEHICLE:
+            OnPlayerExitVehicle(playerid, record.args[0]); break;
+        case JOURNAL_TEXT:
+            OnPlayerText(playerid, record.text.c_str()); break;
+        case JOURNAL_INTERIOR_CHANGE:
+            OnPlayerInteriorChange(playerid, record.args[0], record.args[1]);
+            break;
+        default:
+            break;
+    }
+}
+
+bool JournalReplayer::_read(void* data, size_t size)
+{
+    if(size == 0) return true;
+    mFile.read(static_cast<char*>(data), size);
+    return mFile.gcount() == static_cast<std::streamsize>(size);
+}
+
+}
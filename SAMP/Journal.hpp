@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../Utility/Singleton.hpp"
+
+namespace swcu {
+
+/**
+ * Callbacks kept in a journal. The values are part of the file format,
+ * append new ones only.
+ */
+enum JournalRecordType : uint8_t
+{
+    JOURNAL_CONNECT,        // playerid
+    JOURNAL_DISCONNECT,     // playerid, reason
+    JOURNAL_UPDATE,         // playerid, x, y, z
+    JOURNAL_COMMAND,        // playerid, text
+    JOURNAL_DIALOG,         // playerid, dialogid, response, listitem, text
+    JOURNAL_ENTER_AREA,     // playerid, areaid
+    JOURNAL_LEAVE_AREA,     // playerid, areaid
+    JOURNAL_TICK,           //
+    JOURNAL_STATE_CHANGE,   // playerid, newstate, oldstate
+    JOURNAL_EXIT_VEHICLE,   // playerid, vehicleid
+    JOURNAL_TEXT,           // playerid, text
+    JOURNAL_INTERIOR_CHANGE, // playerid, newinterior, oldinterior
+
+    JOURNAL_RECORD_TYPES
+};
+
+const char* getJournalRecordTypeStr(JournalRecordType type);
+
+/**
+ * One callback read back from a journal.
+ */
+struct JournalRecord
+{
+    // Microseconds since the journal was started.
+    uint64_t            time;
+    JournalRecordType   type;
+    int32_t             playerid;
+    int32_t             args[3];
+    float               pos[3];
+    std::string         text;
+};
+
+/**
+ * Binary journal of the callbacks which drive the game mode, recorded on a
+ * live server to be replayed offline by JournalReplayer.
+ * The file starts with a magic string and is followed by records:
+ *   uint64 time, uint8 type, int32 playerid, then by type
+ *   int32 arguments, float coordinates, or a uint16 sized string.
+ * Numbers are written in the byte order of the host.
+ * Recording is off unless Config::journalPath is set.
+ */
+class Journal : public Singleton<Journal>
+{
+protected:
+    std::ofstream                           mFile;
+    std::chrono::steady_clock::time_point   mStart;
+    std::chrono::steady_clock::time_point   mLastFlush;
+    // Callbacks being run, see JournalScope.
+    int                                     mDepth;
+
+protected:
+                    Journal() : mDepth(0) {}
+    friend class Singleton<Journal>;
+
+public:
+    virtual         ~Journal() { stop(); }
+
+    static const char   MAGIC[8];
+
+            bool    start(const std::string& path);
+            void    stop();
+            bool    isRecording() const
+            { return mDepth == 0 && mFile.is_open(); }
+
+            void    recordConnect(int playerid);
+            void    recordDisconnect(int playerid, int reason);
+            void    recordUpdate(int playerid, float x, float y, float z);
+            void    recordCommand(int playerid, const char* text);
+            void    recordDialog(int playerid, int dialogid, int response,
+                int listitem, const char* text);
+            void    recordEnterArea(int playerid, int areaid);
+            void    recordLeaveArea(int playerid, int areaid);
+            void    recordStateChange(int playerid, int newstate,
+                int oldstate);
+            void    recordExitVehicle(int playerid, int vehicleid);
+            void    recordText(int playerid, const char* text);
+            void    recordInteriorChange(int playerid, int newinterior,
+                int oldinterior);
+    /**
+     * Also writes the buffered records out about once a second.
+     */
+            void    recordTick();
+
+protected:
+            void    _begin(JournalRecordType type, int playerid);
+            void    _write(const void* data, size_t size);
+            void    _writeInt(int32_t value);
+            void    _writeString(const char* text);
+
+    friend class JournalScope;
+};
+
+/**
+ * Put in a recorded callback after recording it. Callbacks it calls in
+ * turn, like OnPlayerConnect running /help, are then left out of the
+ * journal, as replaying the outer one calls them again.
+ */
+class JournalScope
+{
+public:
+                    JournalScope()  { ++Journal::get().mDepth; }
+                    ~JournalScope() { --Journal::get().mDepth; }
+                    JournalScope(const JournalScope&) = delete;
+    JournalScope&   operator=(const JournalScope&) = delete;
+};
+
+/**
+ * Feeds a journal back through the callbacks of the game mode and times
+ * each of them. Meant to run against stub natives and storage, where a
+ * recorded night becomes a repeatable benchmark.
+ */
+class JournalReplayer
+{
+public:
+    /**
+     * Called before each JOURNAL_UPDATE so the stub natives can report the
+     * recorded position to the game mode.
+     */
+    typedef std::function<void(int playerid, float x, float y, float z)>
+        PositionHandler;
+    /**
+     * Called before JOURNAL_CONNECT and after JOURNAL_DISCONNECT, so the
+     * stub natives see the player online while the game mode handles it.
+     */
+    typedef std::function<void(int playerid, bool connected)>
+        ConnectionHandler;
+
+protected:
+    std::ifstream                                   mFile;
+    PositionHandler                                 mOnPosition;
+    ConnectionHandler                               mOnConnection;
+    bool                                            mPaced;
+    // Time taken by each replayed callback in ns, by record type.
+    std::array<std::vector<uint64_t>, JOURNAL_RECORD_TYPES> mNanos;
+
+public:
+    explicit        JournalReplayer(const std::string& path);
+
+            bool    isValid() const         { return mFile.is_open(); }
+            void    setPositionHandler(PositionHandler handler)
+            { mOnPosition = std::move(handler); }
+            void    setConnectionHandler(ConnectionHandler handler)
+            { mOnConnection = std::move(handler); }
+    /**
+     * Wait between records as long as the server did. Off by default, the
+     * journal is replayed as fast as it can be.
+     */
+            void    setPaced(bool paced)    { mPaced = paced; }
+
+            bool    readRecord(JournalRecord& record);
+    /**
+     * Replay the remaining records.
+     * @return Number of records replayed.
+     */
+            uint64_t run();
+    /**
+     * Latency of each callback in nanoseconds, one line per record type:
+     * type count total_ns mean_ns p50_ns p90_ns p99_ns
+     */
+            std::string getReport() const;
+
+protected:
+            void    _dispatch(const JournalRecord& record);
+            bool    _read(void* data, size_t size);
+};
+
+}
@@ -26,16 +26,24 @@
 #include <sampgdk/sdk.h>
 
 #include "../Common/Common.hpp"
+#include "../Common/AsyncLog.hpp"
+#include "../Common/Scheduler.hpp"
 #include "../Streamer/Streamer.hpp"
 #include "../Player/PlayerManager.hpp"
 #include "../Player/PlayerDialogs.hpp"
 #include "../Player/PlayerCommands.hpp"
 #include "../Interface/DialogManager.hpp"
 #include "../Interface/CommandManager.hpp"
+#include "../Interface/ChatManager.hpp"
 #include "../Map/MapManager.hpp"
 #include "../Map/MapDialogs.hpp"
 #include "../Area/AreaManager.hpp"
+#include "../Vehicle/VehicleManager.hpp"
 #include "../Web/WebServiceManager.hpp"
+#include "../Web/EventStream.hpp"
+#include "../Web/StaticAssetCache.hpp"
+
+#include "Journal.hpp"
 
 /** ~~ Event Forwarding for Streamer ~~ **/
 
@@ -97,8 +105,30 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerWeaponShot(int playerid,
 
 /** ^^ Event Forwarding for Streamer ^^ **/
 
+/**
+ * Periodic work of the game mode. ProcessTick belongs to the streamer, so
+ * the tick is driven by a repeating sampgdk timer instead; it runs on the
+ * server thread like every other callback.
+ */
+void SAMPGDK_CALL OnServerTick(int /* timerid */, void* /* param */)
+{
+    METRIC_SCOPED_TIMER("swcu_tick_seconds", "");
+    swcu::Journal::get().recordTick();
+    swcu::JournalScope journalScope;
+    // Deferred events first, so the stream still sends them this tick.
+    swcu::EventManager::get().flushEvents();
+    swcu::Scheduler::get().tick();
+    // After the events, which change what labels show.
+    swcu::PlayerManager::get().updateLabels();
+    swcu::EventStreamManager::get().onTick();
+}
+
 PLUGIN_EXPORT bool PLUGIN_CALL OnGameModeInit()
 {
+    if(!swcu::Config::logPath.empty())
+    {
+        swcu::AsyncLog::get().start(swcu::Config::logPath);
+    }
     srand(time(NULL));
     ShowNameTags(0);
     for(int i = 0; i < 299; ++i)
@@ -109,23 +139,46 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnGameModeInit()
     swcu::registerPlayerCommands();
     swcu::MapManager::get().loadAllMaps();
     swcu::WebServiceManager::get().bindMethod("^/hello$", "GET",
-    [](std::ostream& response, swcu::HTTPRequertPtr request) {
+    [](swcu::HTTPResponse& response, swcu::HTTPRequertPtr request) {
         swcu::writeResponse(response, 200, swcu::CONTENT_TYPE_TEXT_PLAIN,
         "Hello.");
     });
+    swcu::WebServiceManager::get().bindMethod("^/metrics$", "GET",
+    [](swcu::HTTPResponse& response, swcu::HTTPRequertPtr /* request */) {
+        swcu::writeResponse(response, 200, swcu::CONTENT_TYPE_TEXT_PLAIN,
+            swcu::Metrics::get().render());
+    });
     swcu::MapManager::get().addWebServices();
+    swcu::EventStreamManager::get().addWebServices();
     swcu::WebServiceManager::get().startServer();
+    SetTimer(swcu::Config::serverTickInterval, true, OnServerTick, nullptr);
+    if(!swcu::Config::journalPath.empty())
+    {
+        swcu::Journal::get().start(swcu::Config::journalPath);
+    }
     LOG(INFO) << "Game mode initialized.";
     return true;
 }
 
+PLUGIN_EXPORT bool PLUGIN_CALL OnGameModeExit()
+{
+    LOG(INFO) << "Game mode exiting.";
+    swcu::StaticAssetCache::get().stopWatching();
+    swcu::Journal::get().stop();
+    swcu::AsyncLog::get().stop();
+    return true;
+}
+
 PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerConnect(int playerid)
 {
+    swcu::Journal::get().recordConnect(playerid);
+    swcu::JournalScope journalScope;
     Streamer_OnPlayerConnect(playerid);
     swcu::Player* p = swcu::PlayerManager::get().addPlayer(playerid);
     if(p != nullptr)
     {
         LOG(INFO) << "Player connected. ID = " << playerid;
+        swcu::ChatManager::get().resetPlayer(playerid);
         if(p->isValid())
         {
             if(p->hasFlags(swcu::STATUS_BANNED))
@@ -142,8 +195,8 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerConnect(int playerid)
                 <swcu::PlayerRegisterDialog>(playerid);
         }
         SendClientMessageToAll(0xFFFFFFFF,
-            CSTR(" " << p->getColoredNickname()
-            << "(" << playerid << ") ˷."));
+            FORMAT(" {}({}) ˷.",
+            p->getColoredNickname(), playerid).c_str());
         SendDeathMessage(INVALID_PLAYER_ID, playerid, 200 /* ICON_CONNECT */);
         OnPlayerCommandText(playerid, "/help");
     }
@@ -156,13 +209,15 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerConnect(int playerid)
 
 PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerDisconnect(int playerid, int reason)
 {
+    swcu::Journal::get().recordDisconnect(playerid, reason);
+    swcu::JournalScope journalScope;
     Streamer_OnPlayerDisconnect(playerid, reason);
     swcu::Player* p = swcu::PlayerManager::get().getPlayer(playerid);
     if(p != nullptr)
     {
         SendClientMessageToAll(0xFFFFFFFF,
-            CSTR(" " << p->getColoredNickname()
-            << "(" << playerid << ") 뿪˷."));
+            FORMAT(" {}({}) 뿪˷.",
+            p->getColoredNickname(), playerid).c_str());
         SendDeathMessage(INVALID_PLAYER_ID, playerid, 201 /* ICON_DISCONNECT */);
     }
     if(swcu::PlayerManager::get().removePlayer(playerid))
@@ -175,13 +230,24 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerDisconnect(int playerid, int reason)
         LOG(ERROR) << "Removal of player from PlayerManager instance failed.";
     }
     swcu::DialogManager::get().clearPlayerStack(playerid);
+    swcu::VehicleManager::get().handleDisconnect(playerid);
+    swcu::CommandManager::get().resetPlayer(playerid);
     return true;
 }
 
 PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerUpdate(int playerid)
 {
+    METRIC_SCOPED_TIMER("swcu_callback_seconds",
+        "callback=\"OnPlayerUpdate\"");
     auto p = swcu::PlayerManager::get().getPlayer(playerid);
+    // Reading the position is a native call, made only when it's used.
+    if(p == nullptr && !swcu::Journal::get().isRecording()) return false;
+    kanko::Vector3 pos;
+    GetPlayerPos(playerid, &pos.x, &pos.y, &pos.z);
+    swcu::Journal::get().recordUpdate(playerid, pos.x, pos.y, pos.z);
+    swcu::JournalScope journalScope;
     if(p == nullptr) return false;
+    swcu::PlayerManager::get().updatePosition(playerid, pos);
     return p->onUpdate();
 }
 
@@ -202,24 +268,18 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerDeath(int playerid, int killerid,
 
 PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerText(int playerid, const char * text)
 {
-    auto p = swcu::PlayerManager::get().getPlayer(playerid);
-    if(p == nullptr)
-    {
-        return false;
-    }
-    if(p->hasFlags(swcu::STATUS_MUTED))
-    {
-        return false;
-    }
-    std::stringstream chat;
-    chat << p->getColoredNickname() << "(" << playerid << "): " << text;
-    SendClientMessageToAll(0xFFFFFFFF, chat.str().c_str());
-    return false;
+    swcu::Journal::get().recordText(playerid, text);
+    swcu::JournalScope journalScope;
+    return swcu::ChatManager::get().handleText(playerid, text);
 }
 
 PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerCommandText(int playerid,
     const char *cmdtext)
 {
+    METRIC_SCOPED_TIMER("swcu_callback_seconds",
+        "callback=\"OnPlayerCommandText\"");
+    swcu::Journal::get().recordCommand(playerid, cmdtext);
+    swcu::JournalScope journalScope;
     auto p = swcu::PlayerManager::get().getPlayer(playerid);
     if(p == nullptr)
     {
@@ -236,6 +296,11 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerCommandText(int playerid,
 PLUGIN_EXPORT bool PLUGIN_CALL OnDialogResponse(int playerid, int dialogid,
     int response, int listitem, const char * inputtext)
 {
+    METRIC_SCOPED_TIMER("swcu_callback_seconds",
+        "callback=\"OnDialogResponse\"");
+    swcu::Journal::get().recordDialog(playerid, dialogid, response, listitem,
+        inputtext);
+    swcu::JournalScope journalScope;
     swcu::DialogManager::get().handleCallback(playerid, dialogid, response,
         listitem, inputtext);
     Streamer_Update(playerid);
@@ -285,6 +350,34 @@ PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerKeyStateChange(int playerid,
     return true;
 }
 
+PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerStateChange(int playerid,
+    int newstate, int oldstate)
+{
+    swcu::Journal::get().recordStateChange(playerid, newstate, oldstate);
+    swcu::JournalScope journalScope;
+    swcu::VehicleManager::get().handleStateChange(playerid, newstate);
+    return true;
+}
+
+PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerExitVehicle(int playerid,
+    int vehicleid)
+{
+    swcu::Journal::get().recordExitVehicle(playerid, vehicleid);
+    swcu::JournalScope journalScope;
+    swcu::VehicleManager::get().handleExitVehicle(playerid);
+    return true;
+}
+
+PLUGIN_EXPORT bool PLUGIN_CALL OnPlayerInteriorChange(int playerid,
+    int newinteriorid, int oldinteriorid)
+{
+    swcu::Journal::get().recordInteriorChange(playerid, newinteriorid,
+        oldinteriorid);
+    swcu::JournalScope journalScope;
+    swcu::PlayerManager::get().updateInterior(playerid, newinteriorid);
+    return true;
+}
+
 /** Streamer Callbacks **/
 
 void OnDynamicObjectMoved(int objectid)
@@ -366,10 +459,14 @@ void OnPlayerLeaveDynamicRaceCP(int playerid, int checkpointid)
 
 void OnPlayerEnterDynamicArea(int playerid, int areaid)
 {
+    swcu::Journal::get().recordEnterArea(playerid, areaid);
+    swcu::JournalScope journalScope;
     swcu::AreaManager::get().handleEnterAreaCallback(playerid, areaid);
 }
 
 void OnPlayerLeaveDynamicArea(int playerid, int areaid)
 {
+    swcu::Journal::get().recordLeaveArea(playerid, areaid);
+    swcu::JournalScope journalScope;
     swcu::AreaManager::get().handleLeaveAreaCallback(playerid, areaid);
 }
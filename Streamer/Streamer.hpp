@@ -16,7 +16,15 @@
 
 #pragma once
 
+/**
+ * The benchmarks build with SWCU_STREAMER_STUB, replacing the streamer
+ * with the stubs in Benchmark/.
+ */
+#ifdef SWCU_STREAMER_STUB
+#include "../Benchmark/StubStreamer.hpp"
+#else
 #include "Internal/src/callbacks.hpp"
 #include "Internal/src/natives.h"
+#endif
 
 using namespace Natives;
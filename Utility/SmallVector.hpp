@@ -0,0 +1,69 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace swcu {
+
+/**
+ * Sequence keeping its first N elements in place and only allocating
+ * for the ones after, for lists that are nearly always short.
+ * T must be default constructible and copyable, elements removed from the
+ * inline part are not destroyed until overwritten.
+ */
+template<typename T, size_t N>
+class SmallVector
+{
+protected:
+    T                   mInline[N];
+    std::vector<T>      mOverflow;
+    size_t              mSize;
+
+public:
+                        SmallVector() : mSize(0) {}
+
+            size_t      size() const                { return mSize; }
+            bool        empty() const               { return mSize == 0; }
+
+            T&          operator[](size_t i)
+            { return i < N ? mInline[i] : mOverflow[i - N]; }
+            const T&    operator[](size_t i) const
+            { return i < N ? mInline[i] : mOverflow[i - N]; }
+            T&          back()          { return (*this)[mSize - 1]; }
+            const T&    back() const    { return (*this)[mSize - 1]; }
+
+            void        push_back(const T& value)
+    {
+        if(mSize < N) mInline[mSize] = value;
+        else mOverflow.push_back(value);
+        ++mSize;
+    }
+            void        pop_back()
+    {
+        --mSize;
+        if(mSize >= N) mOverflow.pop_back();
+    }
+            void        clear()
+    {
+        mOverflow.clear();
+        mSize = 0;
+    }
+};
+
+}
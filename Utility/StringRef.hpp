@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+
+namespace swcu {
+
+/**
+ * Non-owning view of characters, for looking at parts of a string without
+ * copying them. The referred string must outlive the view.
+ */
+class StringRef
+{
+protected:
+    const char*         mData;
+    size_t              mSize;
+
+public:
+                        StringRef() : mData(""), mSize(0) {}
+                        StringRef(const char* data, size_t size) :
+                            mData(data), mSize(size) {}
+                        StringRef(const char* str) :
+                            mData(str), mSize(strlen(str)) {}
+                        StringRef(const std::string& str) :
+                            mData(str.data()), mSize(str.size()) {}
+
+            const char* data() const                { return mData; }
+            size_t      size() const                { return mSize; }
+            bool        empty() const               { return mSize == 0; }
+            const char* begin() const               { return mData; }
+            const char* end() const                 { return mData + mSize; }
+            char        operator[](size_t i) const  { return mData[i]; }
+
+            std::string str() const
+            { return std::string(mData, mSize); }
+};
+
+inline bool operator==(StringRef lhs, StringRef rhs)
+{
+    return lhs.size() == rhs.size() &&
+        memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+inline bool operator!=(StringRef lhs, StringRef rhs)
+{
+    return !(lhs == rhs);
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace swcu {
+
+/**
+ * Rate limiter allowing bursts of up to capacity, refilled by rate tokens
+ * per second. Starts full.
+ */
+class TokenBucket
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+protected:
+    double              mRate;
+    double              mCapacity;
+    double              mTokens;
+    Clock::time_point   mLast;
+
+public:
+                        TokenBucket(double rate = 1.0,
+                            double capacity = 1.0) :
+                            mRate(rate), mCapacity(capacity),
+                            mTokens(capacity), mLast(Clock::now()) {}
+
+    /**
+     * @return False if there were not enough tokens, then none are taken.
+     */
+            bool        take(double tokens = 1.0,
+                Clock::time_point now = Clock::now())
+    {
+        _refill(now);
+        if(mTokens < tokens) return false;
+        mTokens -= tokens;
+        return true;
+    }
+    /**
+     * Whether take() would succeed, without taking anything.
+     */
+            bool        has(double tokens = 1.0,
+                Clock::time_point now = Clock::now())
+    {
+        _refill(now);
+        return mTokens >= tokens;
+    }
+            void        reset()
+    {
+        mTokens = mCapacity;
+        mLast = Clock::now();
+    }
+
+protected:
+            void        _refill(Clock::time_point now)
+    {
+        double elapsed = std::chrono::duration<double>(now - mLast).count();
+        if(elapsed <= 0.0) return;
+        mTokens = std::min(mCapacity, mTokens + elapsed * mRate);
+        mLast = now;
+    }
+};
+
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sampgdk/a_players.h>
+#include <sampgdk/a_samp.h>
+#include <sampgdk/a_vehicles.h>
+
+#include "../Common/Common.hpp"
+
+#include "VehicleManager.hpp"
+
+namespace swcu {
+
+VehicleManager::VehicleManager()
+{
+    mVehicleOf.fill(INVALID_VEHICLE_ID);
+}
+
+void VehicleManager::handleStateChange(int playerid, int newstate)
+{
+    if(newstate == PLAYER_STATE_DRIVER || newstate == PLAYER_STATE_PASSENGER)
+    {
+        _enter(playerid, GetPlayerVehicleID(playerid),
+            GetPlayerVehicleSeat(playerid));
+    }
+    else
+    {
+        _leave(playerid);
+    }
+}
+
+void VehicleManager::handleExitVehicle(int playerid)
+{
+    // The player is on the way out, don't take them along anymore.
+    _leave(playerid);
+}
+
+void VehicleManager::handleVehicleDestroyed(int vehicleid)
+{
+    if(static_cast<unsigned>(vehicleid) >= MAX_VEHICLES) return;
+    for(const VehicleOccupant& o : mOccupants[vehicleid])
+    {
+        mVehicleOf[o.playerid] = INVALID_VEHICLE_ID;
+    }
+    mOccupants[vehicleid].clear();
+}
+
+const std::vector<VehicleOccupant>& VehicleManager::getOccupants(
+    int vehicleid) const
+{
+    static const std::vector<VehicleOccupant> none;
+    if(static_cast<unsigned>(vehicleid) >= MAX_VEHICLES) return none;
+    return mOccupants[vehicleid];
+}
+
+int VehicleManager::getDriver(int vehicleid) const
+{
+    for(const VehicleOccupant& o : getOccupants(vehicleid))
+    {
+        if(o.seat == 0) return o.playerid;
+    }
+    return INVALID_PLAYER_ID;
+}
+
+int VehicleManager::getPlayerVehicle(int playerid) const
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS)
+    {
+        return INVALID_VEHICLE_ID;
+    }
+    return mVehicleOf[playerid];
+}
+
+void VehicleManager::_enter(int playerid, int vehicleid, int seat)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    // Also covers changing seats.
+    _leave(playerid);
+    if(static_cast<unsigned>(vehicleid) >= MAX_VEHICLES) return;
+    mOccupants[vehicleid].push_back({ playerid, seat });
+    mVehicleOf[playerid] = vehicleid;
+}
+
+void VehicleManager::_leave(int playerid)
+{
+    if(static_cast<unsigned>(playerid) >= MAX_PLAYERS) return;
+    int vehicleid = mVehicleOf[playerid];
+    if(vehicleid == INVALID_VEHICLE_ID) return;
+    mVehicleOf[playerid] = INVALID_VEHICLE_ID;
+    auto& occupants = mOccupants[vehicleid];
+    for(size_t i = 0; i < occupants.size(); ++i)
+    {
+        if(occupants[i].playerid != playerid) continue;
+        occupants[i] = occupants.back();
+        occupants.pop_back();
+        break;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <sampgdk/a_samp.h>
+
+#include "../Utility/Singleton.hpp"
+
+namespace swcu {
+
+struct VehicleOccupant
+{
+    int                 playerid;
+    int                 seat;
+};
+
+/**
+ * Keeps who sits in which vehicle, so the occupants of a vehicle are
+ * found without asking every player slot for its vehicle. Fed by state
+ * changes of the players, which are when the server considers a player
+ * to be in or out of a vehicle.
+ */
+class VehicleManager : public Singleton<VehicleManager>
+{
+protected:
+    std::array<std::vector<VehicleOccupant>, MAX_VEHICLES> mOccupants;
+    // Vehicle of each player, or INVALID_VEHICLE_ID.
+    std::array<int, MAX_PLAYERS>        mVehicleOf;
+
+protected:
+                        VehicleManager();
+    friend class Singleton<VehicleManager>;
+
+public:
+    virtual             ~VehicleManager() {}
+
+            void        handleStateChange(int playerid, int newstate);
+            void        handleExitVehicle(int playerid);
+            void        handleDisconnect(int playerid)
+            { _leave(playerid); }
+    /**
+     * Forget about the occupants of a vehicle going to be destroyed, so
+     * they aren't counted in a new vehicle reusing its id.
+     */
+            void        handleVehicleDestroyed(int vehicleid);
+
+    /**
+     * The list is changed by players getting in or out, don't keep it.
+     */
+            const std::vector<VehicleOccupant>& getOccupants(
+                int vehicleid) const;
+            bool        isOccupied(int vehicleid) const
+            { return !getOccupants(vehicleid).empty(); }
+    /**
+     * @return The driver's id, or INVALID_PLAYER_ID.
+     */
+            int         getDriver(int vehicleid) const;
+    /**
+     * @return The vehicle of the player, or INVALID_VEHICLE_ID.
+     */
+            int         getPlayerVehicle(int playerid) const;
+
+protected:
+            void        _enter(int playerid, int vehicleid, int seat);
+            void        _leave(int playerid);
+};
+
+}
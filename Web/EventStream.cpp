@@ -0,0 +1,377 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sampgdk/a_players.h>
+
+#include "../Common/Common.hpp"
+#include "../Player/PlayerManager.hpp"
+#include "../Crew/Crew.hpp"
+
+#include "EventStream.hpp"
+
+namespace swcu {
+
+namespace {
+
+typedef SimpleWeb::HTTP Socket;
+
+/**
+ * Quote a UTF-8 string as a JSON string literal.
+ */
+void writeJSONString(std::ostream& os, const std::string& str)
+{
+    os << '"';
+    for(char c : str)
+    {
+        switch(c)
+        {
+            case '"':   os << "\\\""; break;
+            case '\\':  os << "\\\\"; break;
+            case '\n':  os << "\\n"; break;
+            case '\r':  os << "\\r"; break;
+            case '\t':  os << "\\t"; break;
+            default:
+            {
+                if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    os << buf;
+                }
+                else
+                {
+                    os << c;
+                }
+            }
+        }
+    }
+    os << '"';
+}
+
+int toDecimetre(float v)
+{
+    return static_cast<int>(std::lround(v * 10.0f));
+}
+
+}
+
+EventStreamManager::EventStreamManager() : mSequence(0)
+{
+}
+
+void EventStreamManager::addWebServices()
+{
+    /**
+     * Live feed of player positions and game events.
+     * Example URI:
+     * /events
+     */
+    WebServiceManager::get().bindMethod(
+        "^/events$", "GET",
+    [this](HTTPResponse& response, HTTPRequertPtr /* request */) {
+        if(getSubscriberCount() >= Config::webEventStreamMaxClients)
+        {
+            writeResponse(response, 503, CONTENT_TYPE_TEXT_PLAIN,
+                "Too many listeners.");
+            return;
+        }
+        response << "HTTP/1.1 200 " << getStatusString(200) << "\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n\r\n"
+            "retry: 3000\n\n";
+        // Once the head is out, the connection belongs to us.
+        response.take_over = [this](std::shared_ptr<Socket> socket) {
+            _addSubscriber(socket);
+        };
+    });
+}
+
+void EventStreamManager::_addSubscriber(std::shared_ptr<Socket> socket)
+{
+    auto sub = std::make_shared<Subscriber>();
+    sub->socket = socket;
+    std::lock_guard<std::mutex> lock(mSubscribersMutex);
+    mSubscribers.push_back(sub);
+}
+
+size_t EventStreamManager::getSubscriberCount()
+{
+    std::lock_guard<std::mutex> lock(mSubscribersMutex);
+    return mSubscribers.size();
+}
+
+namespace {
+
+/**
+ * Write a frame. At most one write per subscriber is in flight; frames
+ * arriving meanwhile wait in Subscriber::pending, which only ever holds
+ * the newest one.
+ */
+template<typename Sub>
+void writeFrame(std::shared_ptr<Sub> sub,
+    std::shared_ptr<const std::string> frame)
+{
+    boost::asio::async_write(*sub->socket, boost::asio::buffer(*frame),
+    [sub, frame](const boost::system::error_code& ec, size_t) {
+        std::shared_ptr<const std::string> next;
+        {
+            std::lock_guard<std::mutex> lock(sub->mutex);
+            if(ec)
+            {
+                sub->closed     = true;
+                sub->writing    = false;
+                sub->pending.reset();
+            }
+            else if(sub->pending != nullptr)
+            {
+                next = std::move(sub->pending);
+                sub->pending.reset();
+            }
+            else
+            {
+                sub->writing    = false;
+            }
+        }
+        if(ec)
+        {
+            boost::system::error_code ignored;
+            sub->socket->lowest_layer().close(ignored);
+        }
+        else if(next != nullptr)
+        {
+            writeFrame(sub, next);
+        }
+    });
+}
+
+}
+
+EventStreamManager::Frame EventStreamManager::_buildKeyframe(
+    const std::unordered_map<int, PlayerState>& current)
+{
+    std::ostringstream frame;
+    frame << "data: {\"seq\":" << mSequence << ",\"key\":true,\"players\":[";
+    bool first = true;
+    PlayerManager::get().forEachPlayer([&](Player& p) {
+        auto iter = current.find(p.getInGameId());
+        if(iter == current.end()) return;
+        if(!first) frame << ',';
+        first = false;
+        frame << '[' << p.getInGameId() << ',';
+        writeJSONString(frame, p.getNicknameUTF8());
+        frame << ',' << iter->second.x << ',' << iter->second.y << ','
+            << iter->second.z << ']';
+    });
+    frame << "],\"events\":[";
+    for(size_t i = 0; i < mPendingEvents.size(); ++i)
+    {
+        if(i > 0) frame << ',';
+        frame << mPendingEvents[i];
+    }
+    frame << "]}\n\n";
+    return std::make_shared<const std::string>(frame.str());
+}
+
+void EventStreamManager::onTick()
+{
+    using namespace std::chrono;
+
+    auto now = steady_clock::now();
+    if(now - mLastFrame < milliseconds(Config::webEventStreamInterval))
+    {
+        return;
+    }
+    mLastFrame = now;
+
+    std::vector<std::shared_ptr<Subscriber>> subs;
+    {
+        std::lock_guard<std::mutex> lock(mSubscribersMutex);
+        auto end = std::remove_if(mSubscribers.begin(), mSubscribers.end(),
+        [](const std::shared_ptr<Subscriber>& sub) {
+            std::lock_guard<std::mutex> subLock(sub->mutex);
+            return sub->closed;
+        });
+        mSubscribers.erase(end, mSubscribers.end());
+        subs = mSubscribers;
+    }
+    if(subs.empty())
+    {
+        // Newcomers start with a keyframe anyway.
+        mLastSent.clear();
+        mPendingEvents.clear();
+        return;
+    }
+    ++mSequence;
+
+    // Diff the current positions against what was last sent.
+    const int threshold = toDecimetre(Config::webEventStreamMoveThreshold);
+    const int threshold2 = threshold * threshold;
+    std::unordered_map<int, PlayerState> current;
+    current.reserve(mLastSent.size() + 8);
+    std::ostringstream joins, moves, leaves;
+    bool changed = !mPendingEvents.empty();
+    PlayerManager::get().forEachPlayer([&](Player& p) {
+        int id = p.getInGameId();
+        float x, y, z;
+        if(!GetPlayerPos(id, &x, &y, &z)) return;
+        PlayerState state = { toDecimetre(x), toDecimetre(y), toDecimetre(z) };
+        current[id] = state;
+
+        auto iter = mLastSent.find(id);
+        if(iter == mLastSent.end())
+        {
+            if(joins.tellp() > 0) joins << ',';
+            joins << '[' << id << ',';
+            writeJSONString(joins, p.getNicknameUTF8());
+            joins << ']';
+        }
+        else
+        {
+            int dx = state.x - iter->second.x;
+            int dy = state.y - iter->second.y;
+            int dz = state.z - iter->second.z;
+            if(dx * dx + dy * dy + dz * dz < threshold2) return;
+        }
+        mLastSent[id] = state;
+        if(moves.tellp() > 0) moves << ',';
+        moves << '[' << id << ',' << state.x << ',' << state.y << ','
+            << state.z << ']';
+        changed = true;
+    });
+    for(auto iter = mLastSent.begin(); iter != mLastSent.end();)
+    {
+        if(current.count(iter->first) > 0)
+        {
+            ++iter;
+            continue;
+        }
+        if(leaves.tellp() > 0) leaves << ',';
+        leaves << iter->first;
+        iter = mLastSent.erase(iter);
+        changed = true;
+    }
+
+    Frame delta;
+    if(changed)
+    {
+        std::ostringstream frame;
+        frame << "data: {\"seq\":" << mSequence <<
+            ",\"join\":[" << joins.str() <<
+            "],\"leave\":[" << leaves.str() <<
+            "],\"move\":[" << moves.str() <<
+            "],\"events\":[";
+        for(size_t i = 0; i < mPendingEvents.size(); ++i)
+        {
+            if(i > 0) frame << ',';
+            frame << mPendingEvents[i];
+        }
+        frame << "]}\n\n";
+        delta = std::make_shared<const std::string>(frame.str());
+    }
+    else if(now - mLastWrite > seconds(Config::webEventStreamHeartbeat))
+    {
+        // A comment line, just to find out dead connections.
+        static const Frame heartbeat = std::make_shared<const std::string>(
+            ":\n\n");
+        delta = heartbeat;
+    }
+
+    // A client that still has an unsent frame when a newer one arrives
+    // has fallen behind; replace the backlog with a single keyframe.
+    // The keyframe is only built if somebody needs it.
+    bool anyKey = false;
+    for(auto& sub : subs)
+    {
+        std::lock_guard<std::mutex> lock(sub->mutex);
+        if(sub->needsKeyframe || (delta != nullptr && sub->pending != nullptr))
+        {
+            anyKey = true;
+            break;
+        }
+    }
+    Frame keyframe;
+    if(anyKey)
+    {
+        keyframe = _buildKeyframe(current);
+    }
+
+    for(auto& sub : subs)
+    {
+        Frame frame;
+        {
+            std::lock_guard<std::mutex> lock(sub->mutex);
+            if(sub->closed) continue;
+            if(sub->needsKeyframe ||
+                (delta != nullptr && sub->pending != nullptr))
+            {
+                if(keyframe == nullptr) continue;
+                frame = keyframe;
+                sub->needsKeyframe = false;
+            }
+            else if(delta != nullptr)
+            {
+                frame = delta;
+            }
+            else
+            {
+                continue;
+            }
+            if(sub->writing)
+            {
+                sub->pending = frame;
+                continue;
+            }
+            sub->writing = true;
+        }
+        writeFrame(sub, frame);
+    }
+    if(delta != nullptr || keyframe != nullptr)
+    {
+        mLastWrite = now;
+    }
+    mPendingEvents.clear();
+}
+
+void EventStreamManager::handleEvent(const Event& evt)
+{
+    if(getSubscriberCount() == 0) return;
+
+    std::ostringstream json;
+    json << "{\"type\":\"" << getEventTypeStr(evt.type) << '"';
+    if(evt.player != nullptr)
+    {
+        json << ",\"player\":" << evt.player->getInGameId();
+    }
+    if(evt.crew != nullptr)
+    {
+        json << ",\"crew\":{\"id\":\"" << evt.crew->getId().str() <<
+            "\",\"name\":";
+        writeJSONString(json, evt.crew->getNameUTF8());
+        json << '}';
+    }
+    if(evt.profile.isSet())
+    {
+        json << ",\"profile\":\"" << evt.profile.str() << '"';
+    }
+    json << '}';
+    mPendingEvents.push_back(json.str());
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Utility/Singleton.hpp"
+#include "../Event/Event.hpp"
+
+#include "WebServiceManager.hpp"
+
+namespace swcu {
+
+/**
+ * Pushes live player positions and game events to the web panel as
+ * server-sent events on /events.
+ *
+ * A frame is built once per interval on the game thread and shared by all
+ * clients. Frames normally carry only what changed since the previous
+ * one: joins, leaves, players that moved further than
+ * Config::webEventStreamMoveThreshold, and the events raised meanwhile.
+ * A client that is still busy receiving never queues more than one frame;
+ * if it falls behind, the unsent frame is dropped and it gets a full
+ * snapshot (keyframe) instead once it is ready again.
+ */
+class EventStreamManager : public Singleton<EventStreamManager>,
+    public EventListener
+{
+protected:
+    typedef SimpleWeb::HTTP Socket;
+    typedef std::shared_ptr<const std::string> Frame;
+
+    struct Subscriber
+    {
+        std::shared_ptr<Socket> socket;
+        // Guards the fields below, which are shared with the I/O threads.
+        std::mutex              mutex;
+        bool                    writing = false;
+        bool                    closed = false;
+        bool                    needsKeyframe = true;
+        Frame                   pending;
+    };
+
+    /**
+     * Last position sent for each player, in decimetres, so that tiny
+     * movements don't produce a change.
+     */
+    struct PlayerState
+    {
+        int                     x, y, z;
+    };
+
+    std::mutex                                  mSubscribersMutex;
+    std::vector<std::shared_ptr<Subscriber>>    mSubscribers;
+
+    // Touched only by the game thread.
+    std::unordered_map<int, PlayerState>        mLastSent;
+    std::vector<std::string>                    mPendingEvents;
+    unsigned long                               mSequence;
+    std::chrono::steady_clock::time_point       mLastFrame;
+    std::chrono::steady_clock::time_point       mLastWrite;
+
+protected:
+                    EventStreamManager();
+    friend class Singleton<EventStreamManager>;
+
+public:
+    virtual         ~EventStreamManager() {}
+
+    /**
+     * Bind /events. Must be called before the web server starts.
+     */
+            void    addWebServices();
+
+    /**
+     * Called by the server tick. Builds and fans out a frame when
+     * Config::webEventStreamInterval elapsed since the last one. Does
+     * nothing but a clock read when nobody is listening.
+     */
+            void    onTick();
+
+            size_t  getSubscriberCount();
+
+    virtual void    handleEvent(const Event& evt) override;
+
+protected:
+            void    _addSubscriber(std::shared_ptr<Socket> socket);
+            Frame   _buildKeyframe(
+                const std::unordered_map<int, PlayerState>& current);
+};
+
+}
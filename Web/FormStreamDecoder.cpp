@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FormStreamDecoder.hpp"
+
+namespace swcu {
+
+namespace {
+
+int hexValue(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+}
+
+FormStreamDecoder::FormStreamDecoder(ValueHandler onValue,
+    FieldEndHandler onFieldEnd) :
+    mOnValue(std::move(onValue)), mOnFieldEnd(std::move(onFieldEnd)),
+    mInValue(false), mEscapeSize(0), mOutSize(0), mFailed(false)
+{
+    mName.reserve(MAX_NAME);
+}
+
+bool FormStreamDecoder::feed(const char* data, size_t size)
+{
+    if(mFailed) return false;
+    for(size_t i = 0; i < size && !mFailed; ++i)
+    {
+        char c = data[i];
+        if(mEscapeSize > 0)
+        {
+            if(hexValue(c) >= 0)
+            {
+                mEscape[mEscapeSize++] = c;
+                if(mEscapeSize == 3)
+                {
+                    _put(char(
+                        hexValue(mEscape[1]) * 16 + hexValue(mEscape[2])));
+                    mEscapeSize = 0;
+                }
+                continue;
+            }
+            // Not an escape after all, keep it as it is like UriDecode().
+            _endEscape();
+        }
+        switch(c)
+        {
+            case '%':
+            {
+                mEscape[0]  = c;
+                mEscapeSize = 1;
+                break;
+            }
+            case '+':
+            {
+                _put(' ');
+                break;
+            }
+            case '=':
+            {
+                if(mInValue) _put(c);
+                else mInValue = true;
+                break;
+            }
+            case '&':
+            {
+                _endField();
+                break;
+            }
+            default:
+            {
+                _put(c);
+                break;
+            }
+        }
+    }
+    _flush();
+    return !mFailed;
+}
+
+void FormStreamDecoder::finish()
+{
+    if(!mFailed) _endField();
+}
+
+void FormStreamDecoder::_put(char c)
+{
+    if(!mInValue)
+    {
+        if(mName.size() >= MAX_NAME)
+        {
+            mFailed = true;
+            return;
+        }
+        mName += c;
+        return;
+    }
+    mOut[mOutSize++] = c;
+    if(mOutSize == sizeof(mOut)) _flush();
+}
+
+void FormStreamDecoder::_flush()
+{
+    if(mOutSize == 0) return;
+    mOnValue(mName, mOut, mOutSize);
+    mOutSize = 0;
+}
+
+void FormStreamDecoder::_endEscape()
+{
+    size_t size = mEscapeSize;
+    mEscapeSize = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        _put(mEscape[i]);
+    }
+}
+
+void FormStreamDecoder::_endField()
+{
+    _endEscape();
+    _flush();
+    if(!mName.empty() || mInValue)
+    {
+        mOnFieldEnd(mName);
+    }
+    mName.clear();
+    mInValue = false;
+}
+
+}
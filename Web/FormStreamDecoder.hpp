@@ -0,0 +1,75 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace swcu {
+
+/**
+ * Incremental decoder of application/x-www-form-urlencoded bodies, the
+ * streaming counterpart of parseParam().
+ * The body may be fed in pieces split anywhere, even inside an escape.
+ * Values are handed out decoded, in pieces, as they arrive, so a large
+ * value is never held whole. Field names are kept and must be short.
+ */
+class FormStreamDecoder
+{
+public:
+    static const size_t MAX_NAME        = 64;
+
+    typedef std::function<void(const std::string& name,
+        const char* data, size_t size)> ValueHandler;
+    typedef std::function<void(const std::string& name)> FieldEndHandler;
+
+protected:
+    ValueHandler        mOnValue;
+    FieldEndHandler     mOnFieldEnd;
+
+    bool                mInValue;
+    std::string         mName;
+    // Characters of a pending %XX escape, including the '%'.
+    char                mEscape[3];
+    size_t              mEscapeSize;
+
+    char                mOut[1024];
+    size_t              mOutSize;
+    bool                mFailed;
+
+public:
+                        FormStreamDecoder(ValueHandler onValue,
+        FieldEndHandler onFieldEnd);
+
+    /**
+     * @return False if the body is malformed, i.e. a field name is too
+     *         long. Anything fed after that is ignored.
+     */
+            bool        feed(const char* data, size_t size);
+    /**
+     * End the last field. Call once after the whole body is fed.
+     */
+            void        finish();
+
+protected:
+            void        _put(char c);
+            void        _flush();
+            void        _endEscape();
+            void        _endField();
+};
+
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <zlib.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include "../Common/Common.hpp"
+
+#include "StaticAssetCache.hpp"
+
+namespace swcu {
+
+namespace {
+
+ContentType contentTypeOf(const std::string& path)
+{
+    static const std::unordered_map<std::string, ContentType> types = {
+        { ".html",  CONTENT_TYPE_TEXT_HTML          },
+        { ".htm",   CONTENT_TYPE_TEXT_HTML          },
+        { ".js",    CONTENT_TYPE_APP_JAVASCRIPT     },
+        { ".json",  CONTENT_TYPE_APP_JSON           },
+        { ".css",   CONTENT_TYPE_TEXT_CSS           },
+        { ".txt",   CONTENT_TYPE_TEXT_PLAIN         },
+        { ".png",   CONTENT_TYPE_IMAGE_PNG          },
+        { ".jpg",   CONTENT_TYPE_IMAGE_JPEG         },
+        { ".jpeg",  CONTENT_TYPE_IMAGE_JPEG         },
+        { ".gif",   CONTENT_TYPE_IMAGE_GIF          },
+        { ".ico",   CONTENT_TYPE_IMAGE_ICON         },
+        { ".svg",   CONTENT_TYPE_IMAGE_SVG          }
+    };
+    size_t dot = path.rfind('.');
+    if(dot != std::string::npos)
+    {
+        auto iter = types.find(path.substr(dot));
+        if(iter != types.end())
+        {
+            return iter->second;
+        }
+    }
+    return CONTENT_TYPE_APP_OCTET_STREAM;
+}
+
+bool isCompressible(ContentType type)
+{
+    switch(type)
+    {
+        case CONTENT_TYPE_TEXT_PLAIN:
+        case CONTENT_TYPE_TEXT_HTML:
+        case CONTENT_TYPE_APP_JSON:
+        case CONTENT_TYPE_APP_JAVASCRIPT:
+        case CONTENT_TYPE_TEXT_CSS:
+        case CONTENT_TYPE_IMAGE_SVG:
+        case CONTENT_TYPE_IMAGE_ICON:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool gzipCompress(const std::string& src, std::string& dest)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 15 window bits plus 16 selects the gzip wrapper instead of zlib.
+    if(deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9,
+        Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+    dest.resize(deflateBound(&zs, src.size()));
+    zs.next_in      = reinterpret_cast<Bytef*>(
+        const_cast<char*>(src.data()));
+    zs.avail_in     = src.size();
+    zs.next_out     = reinterpret_cast<Bytef*>(&dest[0]);
+    zs.avail_out    = dest.size();
+    int r = deflate(&zs, Z_FINISH);
+    dest.resize(zs.total_out);
+    deflateEnd(&zs);
+    return r == Z_STREAM_END;
+}
+
+std::string buildHead(const StaticAsset& asset, size_t length, bool gzip)
+{
+    std::ostringstream head;
+    head << "HTTP/1.1 200 " << getStatusString(200) << "\r\n"
+        "Content-Type: " << gContentTypes[asset.type] << "\r\n"
+        "Content-Length: " << length << "\r\n"
+        "ETag: " << (gzip ? asset.gzipEtag : asset.etag) << "\r\n"
+        "Cache-Control: public, max-age=" << Config::webAssetMaxAge << "\r\n";
+    if(asset.gzipped != nullptr)
+    {
+        head << "Vary: Accept-Encoding\r\n";
+    }
+    if(gzip)
+    {
+        head << "Content-Encoding: gzip\r\n";
+    }
+    head << "\r\n";
+    return head.str();
+}
+
+std::string buildNotModifiedHead(const StaticAsset& asset, bool gzip)
+{
+    std::ostringstream head;
+    head << "HTTP/1.1 304 " << getStatusString(304) << "\r\n"
+        "ETag: " << (gzip ? asset.gzipEtag : asset.etag) << "\r\n"
+        "Cache-Control: public, max-age=" << Config::webAssetMaxAge << "\r\n";
+    if(asset.gzipped != nullptr)
+    {
+        head << "Vary: Accept-Encoding\r\n";
+    }
+    head << "\r\n";
+    return head.str();
+}
+
+/**
+ * Items of a comma-separated header, trimmed, empty ones left out.
+ * Nothing if the request doesn't have the header.
+ */
+std::vector<std::string> getHeaderList(HTTPRequertPtr request,
+    const std::string& name)
+{
+    std::vector<std::string> items;
+    auto iter = request->header.find(name);
+    if(iter == request->header.end()) return items;
+    boost::split(items, iter->second, boost::is_any_of(","));
+    for(auto& i : items) boost::trim(i);
+    items.erase(std::remove(items.begin(), items.end(), std::string()),
+        items.end());
+    return items;
+}
+
+/**
+ * Whether Accept-Encoding allows the coding, by its name or else by "*",
+ * with a quality above 0.
+ */
+bool acceptsEncoding(HTTPRequertPtr request, const std::string& coding)
+{
+    // Quality given to the coding and to "*", -1 if not listed.
+    double named = -1, wildcard = -1;
+    for(auto& item : getHeaderList(request, "Accept-Encoding"))
+    {
+        std::vector<std::string> params;
+        boost::split(params, item, boost::is_any_of(";"));
+        double quality = 1;
+        for(size_t i = 1; i < params.size(); ++i)
+        {
+            boost::trim(params[i]);
+            if(boost::istarts_with(params[i], "q="))
+            {
+                quality = std::atof(params[i].c_str() + 2);
+            }
+        }
+        boost::trim(params[0]);
+        if(boost::iequals(params[0], coding)) named = quality;
+        else if(params[0] == "*") wildcard = quality;
+    }
+    return named >= 0 ? named > 0 : wildcard > 0;
+}
+
+/**
+ * Whether If-None-Match is "*" or lists the tag. Compared weakly, as the
+ * header is: a W/ in front of a listed tag is ignored.
+ */
+bool noneMatchHas(HTTPRequertPtr request, const std::string& etag)
+{
+    for(auto& item : getHeaderList(request, "If-None-Match"))
+    {
+        if(item == "*") return true;
+        if(boost::starts_with(item, "W/")) item.erase(0, 2);
+        if(item == etag) return true;
+    }
+    return false;
+}
+
+}
+
+StaticAssetCache::StaticAssetCache() :
+    mAssets(std::make_shared<AssetMap>()), mRunning(false)
+{
+}
+
+StaticAssetPtr StaticAssetCache::_loadAsset(const std::string& path,
+    const std::string& filename, std::time_t mtime, uintmax_t size) const
+{
+    std::ifstream ifs(filename, std::ifstream::in | std::ifstream::binary);
+    if(!ifs)
+    {
+        LOG(WARNING) << "Could not open file " << filename;
+        return nullptr;
+    }
+    auto raw = std::make_shared<std::string>();
+    raw->reserve(size);
+    raw->assign(std::istreambuf_iterator<char>(ifs),
+        std::istreambuf_iterator<char>());
+
+    auto asset      = std::make_shared<StaticAsset>();
+    asset->path     = path;
+    asset->type     = contentTypeOf(path);
+    asset->mtime    = mtime;
+    asset->size     = size;
+    std::string hash = sha1(*raw).substr(0, 16);
+    asset->etag     = "\"" + hash + "\"";
+    asset->gzipEtag = "\"" + hash + "-gz\"";
+    asset->raw      = raw;
+
+    if(isCompressible(asset->type))
+    {
+        auto gzipped = std::make_shared<std::string>();
+        // Not worth the Content-Encoding dance below a 10% saving.
+        if(gzipCompress(*raw, *gzipped) &&
+            gzipped->size() < raw->size() - raw->size() / 10)
+        {
+            asset->gzipped = gzipped;
+        }
+    }
+
+    asset->rawHead          = buildHead(*asset, raw->size(), false);
+    asset->notModifiedHead  = buildNotModifiedHead(*asset, false);
+    if(asset->gzipped != nullptr)
+    {
+        asset->gzipHead = buildHead(*asset, asset->gzipped->size(), true);
+        asset->gzipNotModifiedHead = buildNotModifiedHead(*asset, true);
+    }
+    return asset;
+}
+
+size_t StaticAssetCache::reload()
+{
+    namespace fs = boost::filesystem;
+
+    std::lock_guard<std::mutex> lock(mScanMutex);
+
+    auto current    = std::atomic_load(&mAssets);
+    auto assets     = std::make_shared<AssetMap>();
+    size_t loaded   = 0;
+    try
+    {
+        fs::path root(Config::webRoot);
+        if(!fs::is_directory(root))
+        {
+            LOG(ERROR) << "Web root " << Config::webRoot << " not found.";
+            return 0;
+        }
+        for(fs::recursive_directory_iterator it(root), end; it != end; ++it)
+        {
+            if(!fs::is_regular_file(it->status())) continue;
+
+            std::string filename    = it->path().generic_string();
+            std::string path        = filename.substr(
+                root.generic_string().size());
+            while(!path.empty() && path[0] == '/') path.erase(0, 1);
+
+            std::time_t mtime       = fs::last_write_time(it->path());
+            uintmax_t   size        = fs::file_size(it->path());
+
+            auto old = current->find(path);
+            if(old != current->end() && old->second->mtime == mtime &&
+                old->second->size == size)
+            {
+                assets->insert(*old);
+                continue;
+            }
+            auto asset = _loadAsset(path, filename, mtime, size);
+            if(asset != nullptr)
+            {
+                assets->insert(std::make_pair(path, asset));
+                ++loaded;
+            }
+        }
+    }
+    catch(const fs::filesystem_error& e)
+    {
+        LOG(ERROR) << e.what();
+        return current->size();
+    }
+    if(loaded > 0 || assets->size() != current->size())
+    {
+        std::atomic_store(&mAssets,
+            std::shared_ptr<const AssetMap>(std::move(assets)));
+        LOG(INFO) << "Static assets reloaded: " << loaded << " changed, "
+            << std::atomic_load(&mAssets)->size() << " in total.";
+    }
+    return std::atomic_load(&mAssets)->size();
+}
+
+void StaticAssetCache::startWatching()
+{
+    if(Config::webAssetRescanInterval <= 0 || mRunning) return;
+    mRunning = true;
+    mWatcher = std::thread(&StaticAssetCache::_watch, this);
+}
+
+void StaticAssetCache::stopWatching()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mRunning = false;
+    }
+    mWake.notify_all();
+    if(mWatcher.joinable()) mWatcher.join();
+}
+
+void StaticAssetCache::_watch()
+{
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    for(;;)
+    {
+        mWake.wait_for(lock,
+            std::chrono::seconds(Config::webAssetRescanInterval),
+            [this]() { return !mRunning; });
+        if(!mRunning) break;
+        lock.unlock();
+        reload();
+        lock.lock();
+    }
+}
+
+StaticAssetPtr StaticAssetCache::find(const std::string& path) const
+{
+    auto assets = std::atomic_load(&mAssets);
+    auto iter = assets->find(path);
+    if(iter == assets->end())
+    {
+        return nullptr;
+    }
+    return iter->second;
+}
+
+void StaticAssetCache::serve(HTTPResponse& response, HTTPRequertPtr request)
+{
+    std::string path = request->path_match[1];
+    // A simple file-or-directory check, same as the old file handler.
+    if(path.find('.') == std::string::npos)
+    {
+        if(!path.empty() && path[path.length() - 1] != '/')
+            path += '/';
+        path += "index.html";
+    }
+
+    // Nothing outside the web root is ever loaded, so no ".." filtering
+    // is needed here.
+    auto asset = find(path);
+    if(asset == nullptr)
+    {
+        writeResponse(response, 404, CONTENT_TYPE_TEXT_PLAIN,
+            "Could not find file " + path);
+        return;
+    }
+    bool gzip = asset->gzipped != nullptr &&
+        acceptsEncoding(request, "gzip");
+    // The asset owns the heads and bodies; holding it keeps them alive
+    // until the write completes.
+    if(noneMatchHas(request, gzip ? asset->gzipEtag : asset->etag))
+    {
+        const std::string& head = gzip ? asset->gzipNotModifiedHead :
+            asset->notModifiedHead;
+        response.attach(head.data(), head.size(), asset);
+        return;
+    }
+    if(gzip)
+    {
+        response.attach(asset->gzipHead.data(), asset->gzipHead.size(), asset);
+        response.attach(asset->gzipped);
+    }
+    else
+    {
+        response.attach(asset->rawHead.data(), asset->rawHead.size(), asset);
+        response.attach(asset->raw);
+    }
+}
+
+}
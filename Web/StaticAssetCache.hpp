@@ -0,0 +1,123 @@
+/*
+ * Copyright 2015 Yukino Hayakawa<tennencoll@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "../Utility/Singleton.hpp"
+
+#include "WebServiceManager.hpp"
+
+namespace swcu {
+
+/**
+ * An immutable, fully prepared file of the web panel.
+ * Both the header blocks and the bodies are built once when the file is
+ * loaded, so serving it is only a matter of handing out the buffers.
+ */
+struct StaticAsset
+{
+    std::string                         path;
+    ContentType                         type;
+    std::time_t                         mtime;
+    uintmax_t                           size;
+    // The gzipped body is another entity and has its own tag.
+    std::string                         etag;
+    std::string                         gzipEtag;
+
+    std::shared_ptr<const std::string>  raw;
+    // Null if the type isn't compressible or gzip doesn't pay off.
+    std::shared_ptr<const std::string>  gzipped;
+
+    std::string                         rawHead;
+    std::string                         gzipHead;
+    std::string                         notModifiedHead;
+    std::string                         gzipNotModifiedHead;
+};
+
+typedef std::shared_ptr<const StaticAsset> StaticAssetPtr;
+
+class StaticAssetCache : public Singleton<StaticAssetCache>
+{
+protected:
+    typedef std::unordered_map<std::string, StaticAssetPtr> AssetMap;
+
+    /**
+     * Readers take a snapshot of the map with atomic_load and never lock.
+     * A rescan builds a new map and swaps it in.
+     */
+    std::shared_ptr<const AssetMap>     mAssets;
+    std::mutex                          mScanMutex;
+
+    // Rescans the web root so that no request ever touches the disk.
+    std::atomic<bool>                   mRunning;
+    std::thread                         mWatcher;
+    std::mutex                          mWakeMutex;
+    std::condition_variable             mWake;
+
+protected:
+                    StaticAssetCache();
+    friend class Singleton<StaticAssetCache>;
+
+public:
+    virtual         ~StaticAssetCache() { stopWatching(); }
+
+    /**
+     * Walk Config::webRoot and (re)load every file whose size or
+     * modification time changed. Unchanged files are carried over.
+     * @return Amount of files in the cache.
+     */
+            size_t  reload();
+
+    /**
+     * Start a thread calling reload() every Config::webAssetRescanInterval
+     * seconds. Requests keep serving the current snapshot meanwhile.
+     * Nothing is started if the interval is 0 or less.
+     */
+            void    startWatching();
+            void    stopWatching();
+
+    /**
+     * @param  path Path relative to the web root, such as "js/ui.js".
+     * @return      The asset, or null if there is no such file.
+     */
+            StaticAssetPtr find(const std::string& path) const;
+
+    /**
+     * Default resource handler of the web server. Prefers the gzipped
+     * body when Accept-Encoding allows gzip, and answers with 304 when
+     * If-None-Match is "*" or lists the tag of the body to be sent. The
+     * cached head and body are attached to the response as they are;
+     * nothing is copied, and the disk is never read.
+     */
+            void    serve(HTTPResponse& response, HTTPRequertPtr request);
+
+protected:
+            void    _watch();
+            StaticAssetPtr _loadAsset(const std::string& path,
+                const std::string& filename, std::time_t mtime,
+                uintmax_t size) const;
+};
+
+}
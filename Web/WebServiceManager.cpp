@@ -18,6 +18,7 @@
 
 #include "../Common/Common.hpp"
 
+#include "StaticAssetCache.hpp"
 #include "WebServiceManager.hpp"
 
 namespace swcu {
@@ -158,7 +159,14 @@ const char* gContentTypes[CONTENT_TYPE_END] = {
     "text/plain",
     "text/html",
     "application/json",
-    "application/javascript"
+    "application/javascript",
+    "text/css",
+    "image/png",
+    "image/jpeg",
+    "image/gif",
+    "image/x-icon",
+    "image/svg+xml",
+    "application/octet-stream"
 };
 
 WebServiceManager::WebServiceManager()
@@ -166,76 +174,81 @@ WebServiceManager::WebServiceManager()
     mServer.reset(new SimpleWeb::Server<SimpleWeb::HTTP>(
         Config::webServerPort, Config::webServerThread));
 
-    // The following codes are from Simple-Web-Server.
-    // Please refer to its license.
+    StaticAssetCache::get().reload();
+    Histogram* histogram = &requestHistogram("static", "GET");
     mServer->default_resource["^/([^?]*).*$"]["GET"] =
-    [](std::ostream& response, HTTPRequertPtr request) {
-        std::string     filename    = "web/";
-        std::string     path        = request->path_match[1];
-
-        // Replace all ".." with "." (so we can't leave the web-directory)
-        size_t          pos;
-        while((pos = path.find("..")) != std::string::npos)
-        {
-            path.erase(pos, 1);
-        }
-
-        filename += path;
-        std::ifstream   ifs;
-        // A simple platform-independent file-or-directory check do not
-        // exist, but this works in most of the cases:
-        if(filename.find('.') == std::string::npos)
-        {
-            if(filename[filename.length() - 1] != '/')
-                filename += '/';
-            filename += "index.html";
-        }
-        ifs.open(filename, std::ifstream::in);
-        if(ifs)
-        {
-            ifs.seekg(0, std::ios::end);
-            size_t      length      = ifs.tellg();
-            ifs.seekg(0, std::ios::beg);
-            // The file-content is copied to the response-stream.
-            // Should not be used for very large files.
-            response << "HTTP/1.1 200 OK\r\nContent-Length: "
-                << length << "\r\n\r\n" << ifs.rdbuf();
-            ifs.close();
-        }
-        else {
-            std::string content     = "Could not open file " + filename;
-            response << "HTTP/1.1 400 Bad Request\r\nContent-Length: "
-                << content.length() << "\r\n\r\n" << content;
-        }
+    [histogram](HTTPResponse& response, HTTPRequertPtr request) {
+        ScopedTimer timer(histogram);
+        StaticAssetCache::get().serve(response, request);
     };
 }
 
+Histogram& WebServiceManager::requestHistogram(const std::string& route,
+    const std::string& method)
+{
+    return Metrics::get().histogram("swcu_http_request_seconds",
+        Metrics::label("route", route) + "," + Metrics::label("method", method),
+        "Time spent in HTTP handlers, excluding network transfer.");
+}
+
 void WebServiceManager::bindMethod(
     const std::string& pattern,
     const std::string& method,
     const WebRequestHandler& handler
 )
 {
+    Histogram* histogram = &requestHistogram(pattern, method);
+    WebRequestHandler timed =
+    [histogram, handler](HTTPResponse& response, HTTPRequertPtr request) {
+        ScopedTimer timer(histogram);
+        handler(response, request);
+    };
     auto& patternmap = mServer->resource[pattern];
     auto handleriter = patternmap.find(method);
     if(handleriter == patternmap.end())
     {
-        patternmap.insert(std::make_pair(method, handler));
+        patternmap.insert(std::make_pair(method, timed));
     }
     else
     {
-        handleriter->second = handler;
+        handleriter->second = timed;
+        LOG(WARNING) << "Handler overwritten " << method << ":" << pattern;
+    }
+}
+
+void WebServiceManager::bindContentMethod(
+    const std::string& pattern,
+    const std::string& method,
+    const WebContentHandlerFactory& factory
+)
+{
+    auto& patternmap = mServer->content_resource[pattern];
+    if(!patternmap.insert(std::make_pair(method, factory)).second)
+    {
+        patternmap[method] = factory;
         LOG(WARNING) << "Handler overwritten " << method << ":" << pattern;
     }
 }
 
 void WebServiceManager::startServer()
 {
+    if(Config::webServerPort == 0)
+    {
+        LOG(INFO) << "HTTP server not started.";
+        return;
+    }
     mServerThread.reset(new std::thread(
         &SimpleWeb::Server<SimpleWeb::HTTP>::start, mServer.get()));
+    StaticAssetCache::get().startWatching();
     LOG(INFO) << "HTTP server started on " << Config::webServerPort;
 }
 
+bool WebServiceManager::respond(const std::string& method,
+    const std::string& path, std::string& response)
+{
+    return mServer->respond(method, path, response);
+}
+
 std::unordered_map<int, std::string> gHTTPStatusStrings = {
     { 100, "Continue" },
     { 101, "Switching Protocols" },
@@ -297,15 +310,56 @@ std::unordered_map<int, std::string> gHTTPStatusStrings = {
     { 511, "Network Authentication Required" }
 };
 
-std::string getStatusString(int status)
+const std::string& getStatusString(int status)
 {
+    static const std::string unknown;
     auto iter = gHTTPStatusStrings.find(status);
     if(iter != gHTTPStatusStrings.end())
     {
         return iter->second;
     }
     LOG(WARNING) << "Unexpected HTTP status code used.";
-    return "";
+    return unknown;
+}
+
+bool writeResponseHead(HTTPResponse& response, int status, ContentType ctype,
+    size_t contentLength, const char* extraHeaders)
+{
+    int len = snprintf(response.head, HTTPResponse::head_capacity,
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %lu\r\n"
+        "%s\r\n",
+        status, getStatusString(status).c_str(), gContentTypes[ctype],
+        static_cast<unsigned long>(contentLength), extraHeaders);
+    if(len < 0 || static_cast<size_t>(len) >= HTTPResponse::head_capacity)
+    {
+        response.head_size = 0;
+        LOG(ERROR) << "Response head exceeds "
+            << HTTPResponse::head_capacity << " bytes.";
+        return false;
+    }
+    response.head_size = len;
+    return true;
+}
+
+void writeResponse(HTTPResponse& response, int status, ContentType ctype,
+    std::string&& content)
+{
+    writeResponse(response, status, ctype,
+        std::make_shared<const std::string>(std::move(content)));
+}
+
+void writeResponse(HTTPResponse& response, int status, ContentType ctype,
+    std::shared_ptr<const std::string> content)
+{
+    if(!writeResponseHead(response, status, ctype, content->size()))
+    {
+        writeResponse(static_cast<std::ostream&>(response), status, ctype,
+            *content);
+        return;
+    }
+    response.attach(std::move(content));
 }
 
 }
@@ -22,6 +22,7 @@
 #include "server_http.hpp"
 
 #include "../Utility/Singleton.hpp"
+#include "../Common/Metrics.hpp"
 
 namespace swcu {
 
@@ -34,6 +35,9 @@ void parseParam(std::string src, ParamSet& dest);
 
 typedef std::shared_ptr<SimpleWeb::ServerBase<SimpleWeb::HTTP>::Request>
     HTTPRequertPtr;
+typedef SimpleWeb::ServerBase<SimpleWeb::HTTP>::Response HTTPResponse;
+typedef SimpleWeb::ServerBase<SimpleWeb::HTTP>::ContentHandler
+    HTTPContentHandler;
 
 class WebServiceManager : public Singleton<WebServiceManager>
 {
@@ -45,9 +49,19 @@ protected:
     friend class Singleton<WebServiceManager>;
 
 public:
-    typedef std::function<void(std::ostream&, HTTPRequertPtr)>
+    /**
+     * Handlers declared with std::ostream& instead of HTTPResponse& are
+     * still accepted and keep working through the stream.
+     */
+    typedef std::function<void(HTTPResponse&, HTTPRequertPtr)>
         WebRequestHandler;
 
+    /**
+     * Creates the handler that receives the body of one request.
+     */
+    typedef std::function<std::shared_ptr<HTTPContentHandler>(HTTPRequertPtr)>
+        WebContentHandlerFactory;
+
     virtual         ~WebServiceManager() {}
 
     /**
@@ -59,10 +73,37 @@ public:
                 const WebRequestHandler& handler
             );
 
+    /**
+     * Bind a handler that consumes the request body as it arrives instead
+     * of receiving it buffered whole. Takes precedence over bindMethod()
+     * for the same pattern and method.
+     * IMPORTANT: Same as bindMethod(), bind before starting the server.
+     */
+            void    bindContentMethod(
+                const std::string& pattern,
+                const std::string& method,
+                const WebContentHandlerFactory& factory
+            );
+
+    /**
+     * Not started if Config::webServerPort is 0, for running headless.
+     */
             void    startServer();
+
+    /**
+     * Answer a request as the server would, without the network. Handlers
+     * bound with bindContentMethod() aren't tried.
+     * @return False if no handler matched.
+     */
+            bool    respond(const std::string& method,
+                const std::string& path, std::string& response);
+
+protected:
+    static  Histogram&  requestHistogram(const std::string& route,
+        const std::string& method);
 };
 
-        std::string getStatusString(int status);
+const   std::string& getStatusString(int status);
 
 enum ContentType
 {
@@ -70,21 +111,62 @@ enum ContentType
     CONTENT_TYPE_TEXT_HTML,
     CONTENT_TYPE_APP_JSON,
     CONTENT_TYPE_APP_JAVASCRIPT,
+    CONTENT_TYPE_TEXT_CSS,
+    CONTENT_TYPE_IMAGE_PNG,
+    CONTENT_TYPE_IMAGE_JPEG,
+    CONTENT_TYPE_IMAGE_GIF,
+    CONTENT_TYPE_IMAGE_ICON,
+    CONTENT_TYPE_IMAGE_SVG,
+    CONTENT_TYPE_APP_OCTET_STREAM,
 
     CONTENT_TYPE_END
 };
 
 extern const char* gContentTypes[CONTENT_TYPE_END];
 
+/**
+ * Compatibility path. Everything, including the content, is copied into
+ * the response stream.
+ */
 inline  void        writeResponse(
     std::ostream& response,
     int status, ContentType ctype,
     const std::string& content)
 {
-    response << "HTTP/1.1 " << getStatusString(status) << "\r\n"
+    response << "HTTP/1.1 " << status << " " << getStatusString(status) <<
+        "\r\n"
         "Content-Type: " << gContentTypes[ctype] << "\r\n"
         "Content-Length: " << content.length() << "\r\n\r\n"
         << content;
 }
 
+/**
+ * Format the status line and headers into the fixed head buffer of the
+ * response. Returns false if they don't fit, which is only possible with
+ * a huge set of extra headers.
+ * @param extraHeaders Complete header lines, each ending with CRLF.
+ */
+        bool        writeResponseHead(
+    HTTPResponse& response,
+    int status, ContentType ctype,
+    size_t contentLength,
+    const char* extraHeaders = "");
+
+/**
+ * The content is taken over and sent as a separate buffer by a gather
+ * write, so it is never copied.
+ */
+        void        writeResponse(
+    HTTPResponse& response,
+    int status, ContentType ctype,
+    std::string&& content);
+
+/**
+ * Send shared immutable bytes, e.g. a body cached across requests.
+ */
+        void        writeResponse(
+    HTTPResponse& response,
+    int status, ContentType ctype,
+    std::shared_ptr<const std::string> content);
+
 }
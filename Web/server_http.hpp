@@ -7,9 +7,12 @@
 
 #include <boost/asio.hpp>
 
+#include <array>
 #include <regex>
 #include <unordered_map>
 #include <thread>
+#include <vector>
+#include <memory>
 
 namespace SimpleWeb {
     template <class socket_type>
@@ -32,13 +35,79 @@ namespace SimpleWeb {
             boost::asio::streambuf content_buffer;
         };
 
+        class Response : public std::ostream {
+            friend class ServerBase<socket_type>;
+        public:
+            //Optional fixed storage for the status line and headers, sent before anything else
+            static const size_t head_capacity=512;
+            char head[head_capacity];
+            size_t head_size;
+
+            //Append bytes that are sent after the stream content without being copied.
+            //The owner keeps the bytes alive until the write has completed.
+            void attach(const char* data, size_t size, std::shared_ptr<const void> owner) {
+                if(size==0)
+                    return;
+                attached.push_back(boost::asio::const_buffer(data, size));
+                owners.push_back(std::move(owner));
+            }
+
+            void attach(std::shared_ptr<const std::string> bytes) {
+                if(bytes)
+                    attach(bytes->data(), bytes->size(), bytes);
+            }
+
+            //If set, the connection is handed over once the response is written,
+            //instead of waiting for the next request. Used for long-lived streams.
+            std::function<void(std::shared_ptr<socket_type>)> take_over;
+
+        private:
+            Response(): std::ostream(&streambuf), head_size(0) {}
+
+            boost::asio::streambuf streambuf;
+
+            std::vector<boost::asio::const_buffer> attached;
+            std::vector<std::shared_ptr<const void> > owners;
+
+            //Gather list in wire order: head, stream content, attached buffers
+            std::vector<boost::asio::const_buffer> buffers() const {
+                std::vector<boost::asio::const_buffer> result;
+                result.reserve(attached.size()+2);
+                if(head_size>0)
+                    result.push_back(boost::asio::const_buffer(head, head_size));
+                if(streambuf.size()>0)
+                    result.push_back(boost::asio::const_buffer(streambuf.data()));
+                result.insert(result.end(), attached.begin(), attached.end());
+                return result;
+            }
+        };
+
+        //Handlers taking std::ostream& instead of Response& are still accepted
         typedef std::map<std::string, std::unordered_map<std::string,
-                std::function<void(std::ostream&, std::shared_ptr<ServerBase<socket_type>::Request>)> > > resource_type;
+                std::function<void(Response&, std::shared_ptr<ServerBase<socket_type>::Request>)> > > resource_type;
 
         resource_type resource;
 
         resource_type default_resource;
 
+        //Receives the request body piece by piece as it arrives, instead of
+        //having it buffered whole in Request::content
+        class ContentHandler {
+        public:
+            virtual ~ContentHandler() {}
+            //Return false to stop reading. The rest of the body is not read
+            //and the connection is closed after the response.
+            virtual bool on_content(const char* data, size_t size)=0;
+            //Called once, after the whole body or after on_content returned false
+            virtual void on_end(Response& response)=0;
+        };
+
+        typedef std::map<std::string, std::unordered_map<std::string,
+                std::function<std::shared_ptr<ContentHandler>(std::shared_ptr<Request>)> > > content_resource_type;
+
+        //Checked before resource and default_resource, as soon as the header is read
+        content_resource_type content_resource;
+
         void start() {
             //All resources with default_resource at the end of vector
             //Used in the respond-method
@@ -71,6 +140,37 @@ namespace SimpleWeb {
             m_io_service.stop();
         }
 
+        //Route a request and run its handler the way write_response does, but
+        //without a connection, e.g. for benchmarks. Content resources are not
+        //tried. Returns false if nothing matched, else the bytes to be sent.
+        bool respond(const std::string& method, const std::string& path, std::string& out) {
+            std::shared_ptr<Request> request(new Request());
+            request->method=method;
+            request->path=path;
+            request->http_version="1.1";
+            for(auto resources: {&resource, &default_resource}) {
+                for(auto& res: *resources) {
+                    std::regex e(res.first);
+                    std::smatch sm_res;
+                    if(std::regex_match(request->path, sm_res, e)) {
+                        auto method_it=res.second.find(request->method);
+                        if(method_it!=res.second.end()) {
+                            request->path_match=move(sm_res);
+
+                            Response response;
+                            method_it->second(response, request);
+                            out.clear();
+                            for(auto& buffer: response.buffers())
+                                out.append(boost::asio::buffer_cast<const char*>(buffer),
+                                        boost::asio::buffer_size(buffer));
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
     protected:
         boost::asio::io_service m_io_service;
         boost::asio::ip::tcp::endpoint endpoint;
@@ -103,10 +203,18 @@ namespace SimpleWeb {
             return timer;
         }
 
-        void read_request_and_content(std::shared_ptr<socket_type> socket) {
+        //Bytes read past the body of the previous request, such as a pipelined request, come first
+        void read_request_and_content(std::shared_ptr<socket_type> socket,
+                std::shared_ptr<Request> previous=nullptr) {
             //Create new streambuf (Request::streambuf) for async_read_until()
             //shared_ptr is used to pass temporary objects to the asynchronous functions
             std::shared_ptr<Request> request(new Request());
+            if(previous && previous->content_buffer.size()>0) {
+                size_t size=boost::asio::buffer_copy(
+                        request->content_buffer.prepare(previous->content_buffer.size()),
+                        previous->content_buffer.data());
+                request->content_buffer.commit(size);
+            }
 
             //Set timeout on the following boost::asio::async-read or write function
             std::shared_ptr<boost::asio::deadline_timer> timer;
@@ -126,6 +234,17 @@ namespace SimpleWeb {
 
                     parse_request(request, request->content);
 
+                    size_t content_length=0;
+                    if(request->header.count("Content-Length")>0)
+                        content_length=stoull(request->header["Content-Length"]);
+
+                    std::shared_ptr<ContentHandler> handler=find_content_handler(request);
+                    if(handler) {
+                        read_content_chunks(socket, request, handler, content_length,
+                                std::make_shared<std::array<char, 8192> >());
+                        return;
+                    }
+
                     //If content, read that as well
                     if(request->header.count("Content-Length")>0) {
                         //Set timeout on the following boost::asio::async-read or write function
@@ -134,7 +253,7 @@ namespace SimpleWeb {
                             timer=set_timeout_on_socket(socket, timeout_content);
 
                         boost::asio::async_read(*socket, request->content_buffer,
-                                boost::asio::transfer_exactly(stoull(request->header["Content-Length"])-num_additional_bytes),
+                                boost::asio::transfer_exactly(content_length-num_additional_bytes),
                                 [this, socket, request, timer]
                                 (const boost::system::error_code& ec, size_t /* bytes_transferred */) {
                             if(timeout_content>0)
@@ -179,6 +298,70 @@ namespace SimpleWeb {
             }
         }
 
+        std::shared_ptr<ContentHandler> find_content_handler(std::shared_ptr<Request> request) {
+            for(auto& res: content_resource) {
+                std::regex e(res.first);
+                std::smatch sm_res;
+                if(std::regex_match(request->path, sm_res, e)) {
+                    auto method_it=res.second.find(request->method);
+                    if(method_it!=res.second.end()) {
+                        request->path_match=move(sm_res);
+                        return method_it->second(request);
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        //Feed the body to the handler in pieces of at most chunk->size() bytes,
+        //starting with what was already read along with the header
+        void read_content_chunks(std::shared_ptr<socket_type> socket, std::shared_ptr<Request> request,
+                std::shared_ptr<ContentHandler> handler, size_t remaining,
+                std::shared_ptr<std::array<char, 8192> > chunk) {
+            if(request->content_buffer.size()>0) {
+                size_t size=std::min(remaining, request->content_buffer.size());
+                bool more=handler->on_content(
+                        boost::asio::buffer_cast<const char*>(request->content_buffer.data()), size);
+                //Anything past the body belongs to the next request
+                request->content_buffer.consume(size);
+                remaining-=size;
+                if(!more || remaining==0) {
+                    end_content(socket, request, handler, remaining==0);
+                    return;
+                }
+            }
+            if(remaining==0) {
+                end_content(socket, request, handler, true);
+                return;
+            }
+
+            std::shared_ptr<boost::asio::deadline_timer> timer;
+            if(timeout_content>0)
+                timer=set_timeout_on_socket(socket, timeout_content);
+
+            socket->async_read_some(boost::asio::buffer(*chunk, std::min(remaining, chunk->size())),
+                    [this, socket, request, handler, remaining, chunk, timer]
+                    (const boost::system::error_code& ec, size_t bytes_transferred) {
+                if(timeout_content>0)
+                    timer->cancel();
+                if(ec)
+                    return;
+                size_t left=remaining-bytes_transferred;
+                if(!handler->on_content(chunk->data(), bytes_transferred) || left==0)
+                    end_content(socket, request, handler, left==0);
+                else
+                    read_content_chunks(socket, request, handler, left, chunk);
+            });
+        }
+
+        void end_content(std::shared_ptr<socket_type> socket, std::shared_ptr<Request> request,
+                std::shared_ptr<ContentHandler> handler, bool complete) {
+            std::shared_ptr<Response> response(new Response());
+            handler->on_end(*response);
+            //Unread body bytes would be taken for the next request
+            send_response(socket, request, response, complete, true);
+        }
+
         void write_response(std::shared_ptr<socket_type> socket, std::shared_ptr<Request> request) {
             //Find path- and method-match, and generate response
             for(auto res_it: all_resources) {
@@ -188,32 +371,46 @@ namespace SimpleWeb {
                     if(res_it->second.count(request->method)>0) {
                         request->path_match=move(sm_res);
 
-                        std::shared_ptr<boost::asio::streambuf> write_buffer(new boost::asio::streambuf);
-                        std::ostream response(write_buffer.get());
-                        res_it->second[request->method](response, request);
-
-                        //Set timeout on the following boost::asio::async-read or write function
-                        std::shared_ptr<boost::asio::deadline_timer> timer;
-                        if(timeout_content>0)
-                            timer=set_timeout_on_socket(socket, timeout_content);
-
-                        //Capture write_buffer in lambda so it is not destroyed before async_write is finished
-                        boost::asio::async_write(*socket, *write_buffer,
-                                [this, socket, request, write_buffer, timer]
-                                (const boost::system::error_code& ec, size_t /* bytes_transferred */) {
-                            if(timeout_content>0)
-                                timer->cancel();
-                            //HTTP persistent connection (HTTP 1.1):
-                            if(!ec && stof(request->http_version)>1.05)
-                                read_request_and_content(socket);
-                        });
+                        std::shared_ptr<Response> response(new Response());
+                        res_it->second[request->method](*response, request);
+                        send_response(socket, request, response, true);
                         return;
                     }
                 }
             }
         }
+
+        //With read_ahead, what is left in the buffer of the request was read past its body
+        void send_response(std::shared_ptr<socket_type> socket, std::shared_ptr<Request> request,
+                std::shared_ptr<Response> response, bool keep_alive, bool read_ahead=false) {
+            //Set timeout on the following boost::asio::async-read or write function
+            std::shared_ptr<boost::asio::deadline_timer> timer;
+            if(timeout_content>0)
+                timer=set_timeout_on_socket(socket, timeout_content);
+
+            //Capture response in lambda so it is not destroyed before async_write is finished
+            boost::asio::async_write(*socket, response->buffers(),
+                    [this, socket, request, response, timer, keep_alive, read_ahead]
+                    (const boost::system::error_code& ec, size_t /* bytes_transferred */) {
+                if(timeout_content>0)
+                    timer->cancel();
+                if(!ec && response->take_over)
+                    response->take_over(socket);
+                //HTTP persistent connection (HTTP 1.1):
+                else if(!ec && keep_alive && stof(request->http_version)>1.05)
+                    read_request_and_content(socket, read_ahead ? request : nullptr);
+                else if(!ec && !keep_alive) {
+                    boost::system::error_code ignored;
+                    socket->lowest_layer().shutdown(boost::asio::ip::tcp::socket::shutdown_send, ignored);
+                }
+            });
+        }
     };
 
+    //Definition for when head_capacity is bound to a reference, as when it is logged
+    template<class socket_type>
+    const size_t ServerBase<socket_type>::Response::head_capacity;
+
     template<class socket_type>
     class Server : public ServerBase<socket_type> {};
 